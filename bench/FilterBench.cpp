@@ -0,0 +1,140 @@
+// Filter kernel micro benchmark: row-at-a-time predicates vs the scalar and
+// SIMD batch kernels over an in-memory table of row-major records. The
+// "(codes)" rows evaluate the string predicate on dictionary codes, as a scan
+// of an encoded columnar segment does.
+//
+//   ./FilterBench [rows]
+#include "../include/Predicate.h"
+#include "../include/FilterKernels.h"
+#include "../include/TableScan.h"
+
+using namespace std;
+using benchClock = chrono::steady_clock;
+
+static TableInfo makeTable() {
+    TableInfo table;
+    table.name = "bench";
+    table.columns = {{"ID", "int", 4}, {"Qty", "int", 4}, {"Price", "float", 4}, {"Name", "string", 20}};
+    for (const auto &column: table.columns) {
+        table.columnOffsets.push_back(table.recordSize);
+        table.columnTypes.push_back(columnTypeOf(column));
+        table.recordSize += column.size;
+    }
+    return table;
+}
+
+static vector<char> makeRecords(const TableInfo &table, size_t rows) {
+    vector<char> records(rows * table.recordSize, '\0');
+    mt19937 random(42);
+    for (size_t i = 0; i < rows; i++) {
+        char *record = records.data() + i * table.recordSize;
+        int id = static_cast<int>(i);
+        int qty = static_cast<int>(random() % 1000);
+        float price = static_cast<float>(random() % 100000) / 100.0f;
+        memcpy(record + table.columnOffsets[0], &id, sizeof(int));
+        memcpy(record + table.columnOffsets[1], &qty, sizeof(int));
+        memcpy(record + table.columnOffsets[2], &price, sizeof(float));
+        snprintf(record + table.columnOffsets[3], 20, "name-%zu", i % 97);
+    }
+    return records;
+}
+
+static size_t rowAtATime(const vector<CompiledPredicate> &predicates, const vector<char> &records,
+                         size_t rows, int recordSize) {
+    size_t matches = 0;
+    for (size_t i = 0; i < rows; i++) {
+        matches += matchesAll(predicates, records.data() + i * recordSize);
+    }
+    return matches;
+}
+
+// Name codes as a dictionary would assign them: name-N has code N
+static vector<uint16_t> makeNameCodes(size_t rows) {
+    vector<uint16_t> codes(rows);
+    for (size_t i = 0; i < rows; i++) {
+        codes[i] = i % 97;
+    }
+    return codes;
+}
+
+// `codes` (optional) holds the codes of the first predicate's column, `code` its operand's code
+static size_t batched(const vector<CompiledPredicate> &predicates, const vector<char> &records,
+                      size_t rows, int recordSize, const uint16_t *codes = nullptr, int code = -1) {
+    // Same batch size as a TableScanIterator chunk
+    const size_t batchRows = defaultScanChunkBytes / recordSize;
+    vector<uint64_t> selection;
+    vector<CodedOperand> coded;
+    size_t matches = 0;
+    for (size_t first = 0; first < rows; first += batchRows) {
+        const size_t count = min(batchRows, rows - first);
+        if (codes) coded = {{codes + first, code}};
+        filterBatch(predicates, records.data() + first * recordSize, count, recordSize, selection, coded);
+        for (uint64_t word: selection) {
+            matches += __builtin_popcountll(word);
+        }
+    }
+    return matches;
+}
+
+template <typename Function>
+static double bestOf(int runs, Function &&function, size_t &matches) {
+    double best = 1e30;
+    for (int run = 0; run < runs; run++) {
+        const auto start = benchClock::now();
+        matches = function();
+        best = min(best, chrono::duration<double>(benchClock::now() - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char *argv[]) {
+    const size_t rows = argc > 1 ? stoul(argv[1]) : 4'000'000;
+    const TableInfo table = makeTable();
+    const vector<char> records = makeRecords(table, rows);
+    const vector<uint16_t> nameCodes = makeNameCodes(rows);
+
+    const vector<pair<string, vector<Condition>>> queries = {
+        {"Qty < 500", {{"Qty", "<", 500}}},
+        {"Qty = 7", {{"Qty", "=", 7}}},
+        {"Price >= 250.5", {{"Price", ">=", 250.5f}}},
+        {"Qty != 3 AND Price < 900", {{"Qty", "!=", 3}, {"Price", "<", 900.0f}}},
+        {"Name = name-42", {{"Name", "=", string("name-42")}}},
+        {"Name = name-42 (codes)", {{"Name", "=", string("name-42")}}},
+    };
+
+    cout << "rows: " << rows << ", record size: " << table.recordSize << " bytes, CPU: "
+         << simdLevelName(detectSimdLevel()) << "\n\n";
+    cout << left << setw(28) << "predicate" << setw(14) << "row (Mrow/s)" << setw(16) << "scalar (Mrow/s)"
+         << setw(16) << "simd (Mrow/s)" << "speedup vs row / scalar\n";
+
+    bool consistent = true;
+    for (const auto &[label, conditions]: queries) {
+        vector<CompiledPredicate> predicates;
+        compilePredicates(table, conditions, predicates);
+        const uint16_t *codes = label.find("(codes)") != string::npos ? nameCodes.data() : nullptr;
+
+        size_t rowMatches, scalarMatches, simdMatches;
+        const double rowTime = bestOf(5, [&] { return rowAtATime(predicates, records, rows, table.recordSize); },
+                                      rowMatches);
+        setSimdLevel(SimdLevel::Scalar);
+        const double scalarTime = bestOf(5, [&] { return batched(predicates, records, rows, table.recordSize,
+                                                                 codes, 42); }, scalarMatches);
+        setSimdLevel(detectSimdLevel());
+        const double simdTime = bestOf(5, [&] { return batched(predicates, records, rows, table.recordSize,
+                                                               codes, 42); }, simdMatches);
+
+        consistent = consistent && rowMatches == scalarMatches && scalarMatches == simdMatches;
+        cout << left << setw(28) << label << fixed << setprecision(1)
+             << setw(14) << rows / rowTime / 1e6
+             << setw(16) << rows / scalarTime / 1e6
+             << setw(16) << rows / simdTime / 1e6
+             << setprecision(2) << rowTime / simdTime << "x / " << scalarTime / simdTime << "x"
+             << "  (" << simdMatches << " matches)\n";
+    }
+
+    if (!consistent) {
+        cerr << "Error: kernels disagree on the number of matching rows" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,114 @@
+#ifndef SIMDB_BTREE_H
+#define SIMDB_BTREE_H
+
+#include "Storage.h"
+#include "BufferPool.h"
+
+const string btreeFileType = ".btree";
+
+// Compare two fixed-width keys of the given column type. Strings are NUL padded
+// to the column width, so a byte-wise compare orders them like std::string.
+int compareKeys(ColumnType keyType, int keySize, const char *a, const char *b);
+
+// Persistent B+Tree mapping column values to record IDs, stored in fixed-size
+// pages behind the buffer pool. Page 0 holds the tree's metadata, every other
+// page is a node. Entries are (key, ID) pairs kept unique by ordering on both,
+// so duplicate column values need no overflow chains. Leaves are linked left
+// to right for range scans.
+//
+// Deletion is lazy: entries are removed from their leaf but nodes are never
+// merged. Separator keys stay valid bounds, so searches remain correct.
+class BTree {
+public:
+    BTree(const string &filePath, ColumnType keyType, int keySize);
+
+    // Widest key that still fits two entries in every node; wider columns
+    // can't be indexed
+    static int maxKeySize();
+
+    // Start an empty tree, discarding whatever the file held
+    bool create();
+
+    // Build the tree bottom-up from entries sorted by (key, ID). Leaves are
+    // filled completely, which is right for indexing existing tables.
+    bool bulkLoad(const vector<pair<string, int>> &sortedEntries);
+
+    // The same from a stream: `next` returns the next entry, the key followed
+    // by the 32-bit ID, or nullptr once there are no more
+    bool bulkLoad(const function<const char *()> &next);
+
+    bool insert(const char *key, int id);
+    bool remove(const char *key, int id);
+
+    // Visit the entries with lowKey <= key <= highKey in key order. A null
+    // bound is open. The visitor returns false to stop the scan early.
+    bool scanRange(const char *lowKey, const char *highKey,
+                   const function<bool(const char *key, int id)> &visitor);
+
+    uint64_t size();
+
+private:
+    struct Meta {
+        char magic[4];
+        uint32_t keyType;
+        uint32_t keySize;
+        uint32_t root;
+        uint32_t pageCount;
+        uint32_t height;
+        uint64_t entries;
+    };
+
+    // Pinned page; the pin is released by the destructor
+    class PageGuard {
+    public:
+        PageGuard(const string &filePath, uint32_t pageNo);
+        ~PageGuard();
+        PageGuard(const PageGuard &) = delete;
+        PageGuard &operator=(const PageGuard &) = delete;
+
+        char *data() const { return page; }
+
+        // The whole page, or just the bytes [offset, offset + length), changed
+        void markDirty() { markDirty(0, PAGE_SIZE); }
+        void markDirty(size_t offset, size_t length);
+
+    private:
+        const string &filePath;
+        uint32_t pageNo;
+        char *page;
+        bool dirty = false;
+        size_t dirtyBegin = 0, dirtyEnd = 0;
+    };
+
+    bool readMeta(Meta &meta);
+    bool writeMeta(const Meta &meta);
+    uint32_t allocatePage(Meta &meta);
+
+    int compareEntries(const char *a, const char *b) const;
+    size_t lowerBound(const char *node, const char *entry) const; // first entry >= `entry`
+    size_t childIndex(const char *node, const char *entry) const; // child to descend into
+
+    // Node accessors
+    static uint16_t &count(char *node);
+    static uint16_t count(const char *node);
+    static bool isLeaf(const char *node);
+    static uint32_t &nextLeaf(char *node);
+    char *entry(char *node, size_t i) const;
+    const char *entry(const char *node, size_t i) const;
+    uint32_t *children(char *node) const;
+    const uint32_t *children(const char *node) const;
+
+    // Put a separator and the child to its right into an internal node,
+    // splitting upwards along `path` when the node is full.
+    bool insertIntoParent(Meta &meta, vector<pair<uint32_t, size_t>> &path, uint32_t leftPage,
+                          const string &separator, uint32_t rightPage);
+
+    string filePath;
+    ColumnType keyType;
+    int keySize;
+    int entrySize;
+    size_t leafCapacity;
+    size_t internalCapacity;
+};
+
+#endif //SIMDB_BTREE_H
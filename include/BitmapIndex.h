@@ -0,0 +1,57 @@
+#ifndef SIMDB_BITMAPINDEX_H
+#define SIMDB_BITMAPINDEX_H
+
+#include "Predicate.h"
+
+// Bitmap indexes on low-cardinality columns: one compressed bitmap of record
+// IDs per distinct value, roaring style. The IDs are split into chunks of
+// 65536; a value's IDs in one chunk form a container, kept as a sorted array
+// of their low 16 bits while it holds up to 4096 of them and as a 65536-bit
+// bitmap beyond that, so a container never takes more than 8 KB.
+//
+// Each column's index lives in its own file of 8 KB blocks:
+//   - the header blocks: the number of values and of blocks, the values in the
+//     order they were first seen, and for each value the blocks of its chunk
+//     directory
+//   - directory blocks: the container block and ID count of 1024 chunks
+//   - container blocks, one per value and chunk that ever held an ID
+//
+// Inserts and deletes set and clear the bits of their IDs, so the bitmaps
+// hold exactly the live records. IDs don't change, VACUUM leaves the index as
+// it is.
+
+// Column names with a bitmap index, one per line
+const string bitmapListFileType = ".bitmaps";
+const string bitmapFileType = ".bitmap";
+
+// A column with more distinct values than this is no fit for a bitmap index
+constexpr uint32_t bitmapMaxValues = 256;
+
+// Index file of a column of a table, e.g. ("t", "Region") -> "t.Region.bitmap"
+string bitmapFilePath(const string &tableName, const string &columnName);
+
+// Columns of the table that have a bitmap index, empty if none
+vector<string> readBitmapList(const string &tableName);
+
+// Build the bitmaps of a column from its records, then register them.
+// Returns false (after reporting why) on bad names or too many values.
+bool createBitmapIndex(const string &tableName, const string &columnName);
+bool dropBitmapIndex(const string &tableName, const string &columnName);
+
+// Remove every bitmap index of a table, used when the table is recreated
+void dropAllBitmapIndexes(const string &tableName);
+
+// Keep the bitmap indexes of the table in step with `count` row-major records
+// added under the IDs from `firstId` on, or one record removed from `id`.
+bool bitmapInsertRecords(const TableInfo &table, const char *records, size_t count, int firstId);
+bool bitmapRemoveRecord(const TableInfo &table, const char *record, int id);
+
+// Whether a predicate can be answered from the column's bitmaps: = or IN on a
+// column with a bitmap index
+bool bitmapCheckable(const TableInfo &table, const CompiledPredicate &predicate);
+
+// IDs of the records matching every one of the (bitmap checkable) predicates,
+// sorted, from ANDing the ORed bitmaps of each predicate's values.
+bool bitmapMatches(const TableInfo &table, const vector<const CompiledPredicate *> &predicates, vector<int> &ids);
+
+#endif //SIMDB_BITMAPINDEX_H
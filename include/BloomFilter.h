@@ -0,0 +1,48 @@
+#ifndef SIMDB_BLOOMFILTER_H
+#define SIMDB_BLOOMFILTER_H
+
+#include "Catalog.h"
+
+// Bloom filters on string columns, one per zone of zoneRecords slots (the
+// zones of ZoneMap.h), so a full scan can skip the zones that can't hold the
+// value of an equality predicate. Each column's filters live in their own
+// file, zone after zone. A filter is split into 32-byte blocks: a value picks
+// one block and sets one bit in each of its eight 32-bit words.
+//
+// Writes add their values to the filters, deletes can't take them out; VACUUM
+// rebuilds the filters from the live records.
+
+// Column names with a Bloom filter, one per line
+const string bloomListFileType = ".blooms";
+const string bloomFileType = ".bloom";
+
+// Filter size of one zone: 16 bits per slot
+constexpr size_t bloomZoneBytes = 2048;
+
+// Filter file of a column of the table a data file belongs to, e.g.
+// ("t.bin", "Name") -> "t.Name.bloom"
+string bloomFilePath(const string &dataFilePath, const string &columnName);
+
+// Columns of the table that have Bloom filters, empty if none
+vector<string> readBloomList(const string &tableName);
+
+// Build the filters of a string column from its records, then register them.
+// Returns false (after reporting why) on bad names.
+bool createBloomFilter(const string &tableName, const string &columnName);
+bool dropBloomFilter(const string &tableName, const string &columnName);
+
+// Remove every Bloom filter of a table, used when the table is recreated
+void dropAllBloomFilters(const string &tableName);
+
+// Add `count` row-major records written to the slots from `firstSlot` on to
+// the filters of the data file at `filePath`
+bool updateBloomFilters(const TableInfo &table, const string &filePath, uint64_t firstSlot, const char *records,
+                        size_t count);
+
+// The filters of a column, zone after zone. Zones past the end have none.
+bool readBloomFilters(const TableInfo &table, int column, vector<char> &filters);
+
+// Whether the filter of one zone may hold `value`
+bool bloomMayContain(const char *zoneFilter, string_view value);
+
+#endif //SIMDB_BLOOMFILTER_H
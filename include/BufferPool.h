@@ -0,0 +1,140 @@
+#ifndef SIMDB_BUFFERPOOL_H
+#define SIMDB_BUFFERPOOL_H
+
+#include <bits/stdc++.h>
+using namespace std;
+
+constexpr size_t PAGE_SIZE = 4096;
+constexpr size_t defaultBufferPoolMB = 16;
+const string bufferPoolSizeEnv = "SIMDB_BUFFER_POOL_MB";
+
+// One slot of the pool. A frame holds a single fixed-size page of a table file.
+struct Frame {
+    int fileId = -1;        // -1 means the frame is free
+    uint64_t pageNo = 0;
+    int pinCount = 0;
+    bool dirty = false;
+    bool referenced = false; // CLOCK reference bit
+    char *data = nullptr;
+    uint64_t lsn = 0;        // log record that last changed the page
+};
+
+// Bytes of a file changed while a write capture was active
+struct WriteRange {
+    string filePath;
+    uint64_t offset;
+    size_t length;
+};
+
+// Page cache sitting in front of every table data and index file.
+// Pages are pinned while in use, written back only when dirty and evicted with
+// the CLOCK (second chance) policy once the memory budget is exhausted.
+class BufferPool {
+public:
+    explicit BufferPool(size_t numPages);
+    ~BufferPool();
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    // Pin/unpin API. fetchPage returns nullptr if the file can't be opened or
+    // every frame is pinned. A dirty page can name the bytes that changed so a
+    // write capture logs just those.
+    char *fetchPage(const string &filePath, uint64_t pageNo, bool create = false);
+    void unpinPage(const string &filePath, uint64_t pageNo, bool dirty,
+                   size_t dirtyOffset = 0, size_t dirtyLength = PAGE_SIZE);
+
+    // Byte-range helpers built on fetchPage/unpinPage. Reads fail past the end
+    // of the file, writes extend it.
+    bool readBytes(const string &filePath, uint64_t offset, char *buffer, size_t length);
+    bool writeBytes(const string &filePath, uint64_t offset, const char *buffer, size_t length,
+                    bool create = false);
+
+    bool fileExists(const string &filePath);
+    uint64_t fileSize(const string &filePath);
+
+    // Pages overlapping [offset, offset + length) whose cached copy is newer
+    // than the file, in page order. The rest can be read from the file directly.
+    vector<uint64_t> dirtyPages(const string &filePath, uint64_t offset, size_t length);
+
+    // Write dirty pages back to the file system.
+    bool flushFile(const string &filePath);
+    bool flushAll();
+
+    // Forget every cached page of a file without writing it back and close it.
+    void dropFile(const string &filePath);
+
+    // fdatasync every open file, so flushed pages survive a crash
+    bool syncAll();
+
+    // Write capture for the write-ahead log. Between beginCapture and
+    // releaseCapture every changed page stays pinned (no steal), endCapture
+    // reports what changed and releaseCapture tags the pages with the log
+    // record that describes them. abortCapture instead puts every changed
+    // page and file size back the way it was at beginCapture.
+    void beginCapture();
+    vector<WriteRange> endCapture();
+    void releaseCapture(uint64_t lsn);
+    void abortCapture();
+
+    // Write back the dirty pages under `ranges` now instead of at the next
+    // checkpoint. Pages captured by a statement still in progress are skipped.
+    bool writeBackRanges(const vector<WriteRange> &ranges);
+
+    // Called before a page changed by log record `lsn` is written back, so the
+    // log always reaches disk before the pages it describes. The page stays
+    // dirty if the flusher returns false.
+    void setLogFlusher(function<bool(uint64_t lsn)> flusher);
+
+    void resize(size_t numPages);
+    size_t capacity() const;
+    size_t hitCount() const { return hits; }
+    size_t missCount() const { return misses; }
+    size_t fileSlotCount() const; // open files plus slots of dropped ones waiting for reuse
+
+private:
+    struct OpenFile {
+        string path;
+        int fd = -1;
+        uint64_t size = 0; // logical size, grows with writes before they reach disk
+    };
+
+    int openFile(const string &filePath, bool create);
+    int lookupFile(const string &filePath) const;
+    char *fetchPageLocked(int fileId, uint64_t pageNo);
+    void unpinPageLocked(int fileId, uint64_t pageNo, bool dirty);
+    int findVictim();
+    bool writeBack(Frame &frame);
+    bool flushFileLocked(int fileId);
+    void captureLocked(int fileId, uint64_t pageNo, uint64_t offset, size_t length);
+    void keepBeforeImageLocked(int fileId, uint64_t pageNo, const char *page);
+    void keepFileSizeLocked(int fileId);
+    static uint64_t pageKey(int fileId, uint64_t pageNo) { return (uint64_t(fileId) << 48) | pageNo; }
+
+    vector<Frame> frames;
+    vector<char> memory;
+    unordered_map<uint64_t, size_t> pageTable; // pageKey -> frame index
+    vector<OpenFile> files;
+    unordered_map<string, int> fileIds;
+    vector<int> freeFileIds;  // slots of dropped files
+    size_t clockHand = 0;
+    bool capturing = false;
+    vector<pair<int, pair<uint64_t, size_t>>> capturedRanges; // fileId, (offset, length)
+    unordered_set<uint64_t> capturedPages;
+    struct BeforeImage {
+        vector<char> data;
+        bool dirty;
+        uint64_t lsn;
+    };
+    thread::id captureOwner;                          // pages it pins may be changed in place
+    unordered_map<uint64_t, BeforeImage> beforeImages; // pageKey -> page as the capture found it
+    unordered_map<int, uint64_t> capturedSizes;        // fileId -> size as the capture found it
+    function<bool(uint64_t)> logFlusher;
+    size_t hits = 0, misses = 0;
+    mutable mutex latch;
+};
+
+// Process-wide pool, sized from SIMDB_BUFFER_POOL_MB (defaults to 16 MB).
+BufferPool &bufferPool();
+
+#endif //SIMDB_BUFFERPOOL_H
@@ -0,0 +1,65 @@
+#ifndef SIMDB_CATALOG_H
+#define SIMDB_CATALOG_H
+
+#include "Storage.h"
+
+// A secondary B+Tree index registered on one column of a table
+struct IndexInfo {
+    string name;
+    int columnIndex = -1;
+    string filePath;
+};
+
+// Everything the hot paths need to know about a table, parsed once.
+struct TableInfo {
+    string name;
+    vector<ColumnInfo> columns;
+    vector<ColumnType> columnTypes;
+    vector<int> columnOffsets; // byte offset of each column inside a record
+    int recordSize = 0;
+    DBHeader header;
+    vector<IndexInfo> indexes;
+    vector<int> bloomColumns; // string columns with Bloom filters per zone (BloomFilter.h)
+    vector<int> bitmapColumns; // columns with a bitmap index (BitmapIndex.h)
+
+    // Position of a column in `columns`, -1 if the table has no such column
+    int columnIndex(const string &columnName) const;
+
+    // Secondary index on the column, nullptr if the column isn't indexed
+    const IndexInfo *indexOn(int column) const;
+};
+
+// Process-wide cache of table metadata. Schemas are parsed on first use and
+// kept until DDL invalidates them; the cached header is kept in sync by
+// writeHeader so it never has to be re-read from disk.
+//
+// Entries are shared: an invalidated TableInfo lives on until the last caller
+// holding it lets go. Writers must still re-read it after taking the WAL
+// writer latch, since VACUUM may have replaced the table.
+class Catalog {
+public:
+    // nullptr if the table's schema or data file can't be loaded
+    shared_ptr<const TableInfo> getTable(const string &tableName);
+
+    // Names of the tables loaded so far
+    vector<string> tableNames();
+
+    void updateHeader(const string &tableName, const DBHeader &header);
+    void invalidate(const string &tableName);
+    void clear();
+
+    // Held shared while reading a table's files and exclusively by VACUUM
+    // while it swaps rewritten files in, so a reader sees one version only.
+    shared_mutex &swapLatch() { return swap; }
+
+private:
+    unique_ptr<TableInfo> loadTable(const string &tableName);
+
+    unordered_map<string, shared_ptr<TableInfo>> tables;
+    mutex latch;
+    shared_mutex swap;
+};
+
+Catalog &catalog();
+
+#endif //SIMDB_CATALOG_H
@@ -0,0 +1,65 @@
+#ifndef SIMDB_COLUMNAR_H
+#define SIMDB_COLUMNAR_H
+
+#include "Catalog.h"
+
+// Record I/O that works for both table layouts. A columnar (PAX) table groups
+// its slots into segments of header.segmentRecords; inside a segment each
+// column's values are stored back to back, in schema order. A segment takes
+// exactly as many bytes as the same slots of a row table, so slot counts,
+// freeOffset and the size arithmetic are the same for both layouts.
+//
+// Once every slot of a segment has been written, each of its string columns
+// is dictionary encoded if that takes less room: the distinct values, then a
+// 16-bit code per slot, or (code, run length) pairs when the codes come in
+// long runs. The encoded bytes replace the start of the column's area of the
+// segment, and the table's segment directory (segmentFileType) records how
+// each column of each segment is stored.
+
+enum class ColumnEncoding : uint32_t {
+    Plain = 0,      // one value per slot, padded to the column size
+    Dictionary = 1, // distinct values, then one code per slot
+    RunLength = 2,  // distinct values, then (code, run length) pairs
+};
+
+// One string column of one segment, decoded. Codes follow the sort order of
+// the values.
+struct SegmentDictionary {
+    int valueSize = 0;
+    vector<char> values;    // the distinct values in order, each padded to valueSize
+    vector<uint16_t> codes; // one per slot of the segment
+
+    const char *value(uint16_t code) const { return values.data() + size_t(code) * valueSize; }
+
+    // Code of a value (without padding), -1 if the segment doesn't hold it
+    int codeOf(string_view value) const;
+};
+
+// The dictionary of a column in a segment, nullptr if it's stored plain.
+// Decoded segments are cached. Returns false if the directory or the encoded
+// bytes can't be read.
+bool segmentDictionary(const TableInfo &table, const string &filePath, uint64_t segment, int column,
+                       shared_ptr<const SegmentDictionary> &dictionary);
+
+// Forget every cached dictionary, for when table files are replaced
+void invalidateSegmentDictionaries();
+
+// File offset of one column value of a slot. Not meaningful for a string
+// column whose segment is encoded.
+FileOffset columnValueOffset(const TableInfo &table, uint64_t slot, int column);
+
+// Read `count` records from `firstSlot` on into row-major `records`. For a
+// columnar table only `columns` are read (all of them if empty); the bytes of
+// the other columns are left as they were.
+bool readSlots(const TableInfo &table, const string &filePath, uint64_t firstSlot, size_t count,
+               const vector<int> &columns, char *records);
+
+// Write `count` row-major records to the slots from `firstSlot` on, widen the
+// zone map over them and add them to the Bloom filters
+bool writeSlots(const TableInfo &table, const string &filePath, uint64_t firstSlot, const char *records,
+                size_t count, bool create = false);
+
+// Columns a query touches: the listed ones plus ID, which marks tombstones
+vector<int> withIdColumn(const TableInfo &table, vector<int> columns);
+
+#endif //SIMDB_COLUMNAR_H
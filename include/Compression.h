@@ -0,0 +1,49 @@
+#ifndef SIMDB_COMPRESSION_H
+#define SIMDB_COMPRESSION_H
+
+#include "Catalog.h"
+
+// Compressed tables, for data that is written once and read rarely.
+//
+// COMPRESS TABLE rewrites a table the way VACUUM does, then cuts the records
+// of the new data file into blocks of header.blockRecords slots' worth of
+// bytes and compresses each block on its own. The blocks follow the header
+// back to back; the block index (blockIndexFileType) holds the offset and
+// length of each. A block decompresses to exactly the bytes the uncompressed
+// file holds there, so slots, segments and string encodings are unchanged and
+// a read decompresses only the blocks under it.
+//
+// A compressed table is read-only. VACUUM rewrites it uncompressed.
+
+// Uncompressed bytes per block, rounded down to whole records
+constexpr size_t compressedBlockBytes = 64 * 1024;
+
+enum class BlockCodec : uint32_t {
+    Stored = 0, // the block didn't shrink and is kept as is
+    Lz = 1,     // lzCompress
+};
+
+// Byte-oriented LZ77 in the style of LZ4: runs of literals, each followed by
+// a back reference of at least 4 bytes into the last 64 KB
+void lzCompress(const char *input, size_t length, string &output);
+
+// Decompress into exactly `outputLength` bytes. False if the input is corrupt.
+bool lzDecompress(const char *input, size_t length, char *output, size_t outputLength);
+
+inline bool isCompressed(const TableInfo &table) {
+    return table.header.blockRecords > 0;
+}
+
+// Read bytes of a table's data file as the uncompressed file would hold them.
+// Decompressed blocks are cached.
+bool readTableBytes(const TableInfo &table, const string &filePath, uint64_t offset, char *buffer, size_t length);
+
+// Compress the records of the uncompressed data file at `filePath` in place
+// and write its block index. `header` describes the file and gets its
+// blockRecords set.
+bool compressDataFile(const string &filePath, DBHeader &header, int recordSize);
+
+// Forget every cached block, for when table files are replaced
+void invalidateCompressedBlocks();
+
+#endif //SIMDB_COMPRESSION_H
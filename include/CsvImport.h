@@ -0,0 +1,33 @@
+#ifndef SIMDB_CSVIMPORT_H
+#define SIMDB_CSVIMPORT_H
+
+#include <bits/stdc++.h>
+using namespace std;
+
+// The input is cut into chunks of about this size at line boundaries. Each
+// chunk is parsed and encoded by one worker.
+constexpr size_t csvImportChunkBytes = 8 * 1024 * 1024;
+const string importThreadsEnv = "SIMDB_IMPORT_THREADS";
+
+// Split one comma separated line into `fields`. Commas inside double quotes
+// don't split; fields are trimmed and lose their enclosing quotes.
+void splitCsvLine(string_view line, vector<string> &fields);
+void splitCsvLine(string_view line, vector<string_view> &fields);
+
+// Append every line of a CSV file to the table.
+//
+// The file is mapped into memory and split into chunks at newlines outside
+// quotes, so a quoted field may hold commas and newlines. Worker threads scan their chunks for delimiters
+// 32 bytes at a time with AVX2 when the CPU has it, parse numbers with
+// from_chars and encode records into local buffers. The calling thread is the
+// only appender: it takes finished chunks in file order, so IDs follow the
+// input, and appends each with appendRecords.
+//
+// Returns the number of rows imported. Throws runtime_error if the file
+// can't be read or a row is invalid; the chunks before the bad one stay
+// imported. Workers default to the hardware thread count, SIMDB_IMPORT_THREADS
+// overrides it.
+size_t importCsv(const string &tableName, const string &filePath, bool skipHeader,
+                 size_t chunkBytes = csvImportChunkBytes);
+
+#endif //SIMDB_CSVIMPORT_H
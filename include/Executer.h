@@ -4,7 +4,17 @@
 #include <bits/stdc++.h>
 using namespace std;
 #include "Storage.h"
-void executeInsert(const std::string &tableName, const std::vector<std::string> &values);
+void executeInsert(const std::string &tableName, const std::vector<std::vector<std::string>> &rows);
+void executeCopy(const std::string &tableName, const std::string &filePath, bool header);
 void executeSelect(const std::string &tableName, const std::vector<std::string> &columns, const std::vector<Condition> &conditions);
 void executeDelete(const std::string &tableName, int id);
-void executeCreateTable(const std::string &tableName, const std::string &columnsInfo);
+void executeCreateTable(const std::string &tableName, const std::string &columnsInfo,
+                        TableLayout layout = TableLayout::Row);
+void executeCreateIndex(const std::string &tableName, const std::string &indexName, const std::string &columnName);
+void executeDropIndex(const std::string &tableName, const std::string &indexName);
+void executeCreateBloomFilter(const std::string &tableName, const std::string &columnName);
+void executeDropBloomFilter(const std::string &tableName, const std::string &columnName);
+void executeCreateBitmapIndex(const std::string &tableName, const std::string &columnName);
+void executeDropBitmapIndex(const std::string &tableName, const std::string &columnName);
+void executeVacuum(const std::string &tableName);
+void executeCompress(const std::string &tableName);
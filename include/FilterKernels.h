@@ -0,0 +1,37 @@
+#ifndef SIMDB_FILTERKERNELS_H
+#define SIMDB_FILTERKERNELS_H
+
+#include "Storage.h"
+
+// Batch filter kernels for int and float columns. A batch is `count` values
+// laid out `stride` bytes apart (one per record), and the result is ANDed into
+// a selection bitmap where bit i stands for row i of the batch. Rows whose
+// word is already zero are skipped, so the cheapest predicate should go first.
+enum class SimdLevel { Scalar, AVX2 };
+
+SimdLevel detectSimdLevel();          // what the CPU supports
+SimdLevel activeSimdLevel();          // what the kernels currently use
+void setSimdLevel(SimdLevel level);   // clamped to detectSimdLevel(), used by tests and benchmarks
+const char *simdLevelName(SimdLevel level);
+
+inline size_t selectionWords(size_t count) { return (count + 63) / 64; }
+
+// Set bits [0, count) and clear the tail of the last word
+void selectAll(vector<uint64_t> &selection, size_t count);
+
+void filterInt32(const char *base, size_t stride, size_t count, CompareOp op, int32_t operand,
+                 uint64_t *selection);
+void filterFloat(const char *base, size_t stride, size_t count, CompareOp op, float operand,
+                 uint64_t *selection);
+
+// = or != against packed 16-bit dictionary codes. A negative operand is a
+// value missing from the dictionary: no code equals it.
+void filterCodes(const uint16_t *codes, size_t count, CompareOp op, int operand, uint64_t *selection);
+
+// Word-wise AND / OR of another bitmap of `words` words into `target`, as
+// used to combine bitmap index containers. andBitmaps returns whether any bit
+// of `target` is left.
+bool andBitmaps(uint64_t *target, const uint64_t *other, size_t words);
+void orBitmaps(uint64_t *target, const uint64_t *other, size_t words);
+
+#endif //SIMDB_FILTERKERNELS_H
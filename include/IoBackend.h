@@ -0,0 +1,138 @@
+#ifndef SIMDB_IOBACKEND_H
+#define SIMDB_IOBACKEND_H
+
+#include <bits/stdc++.h>
+#include <sys/uio.h>
+using namespace std;
+
+// How table data and ID map files are read. Writes always go through the
+// buffer pool and the write-ahead log.
+enum class IoBackend {
+    BufferPool, // every read is copied out of pool pages
+    Mmap,       // reads come straight from read-only shared mappings
+    Uring,      // scans and batched lookups read the files through io_uring
+};
+
+// "pool" (the default), "mmap" or "uring", read once at startup
+const string ioBackendEnv = "SIMDB_IO_BACKEND";
+
+IoBackend ioBackend();
+
+// Address space set aside for each mapping. The file is remapped in place as
+// it grows, so pointers handed out earlier stay valid; a file larger than
+// this is read through the buffer pool instead.
+constexpr uint64_t mappingReserveBytes = 1ull << 40;
+
+// Read-only MAP_SHARED view of one file. With the mmap backend every commit
+// writes its pages through to the file, so the mapping shows committed data.
+class FileMapping {
+public:
+    explicit FileMapping(const string &filePath);
+    ~FileMapping();
+
+    FileMapping(const FileMapping &) = delete;
+    FileMapping &operator=(const FileMapping &) = delete;
+
+    // Pointer to bytes [offset, offset + length) of the file, remapping first
+    // if the file has grown past the mapped part. nullptr if the file is
+    // shorter than that or can't be mapped; the caller then reads through the
+    // buffer pool.
+    const char *view(uint64_t offset, size_t length);
+
+    // madvise() the mapped part of [offset, offset + length)
+    void advise(uint64_t offset, uint64_t length, int advice);
+
+private:
+    bool grow(uint64_t size);
+
+    string filePath;
+    char *base = nullptr;
+    atomic<uint64_t> mapped{0};
+    mutex latch;
+};
+
+// One mapping per file, created on first use
+class MappingCache {
+public:
+    // nullptr if the file can't be mapped
+    FileMapping *get(const string &filePath);
+
+    // Unmap a file that is about to be replaced. Nobody may still hold a
+    // pointer into it.
+    void drop(const string &filePath);
+
+private:
+    unordered_map<string, unique_ptr<FileMapping>> mappings;
+    mutex latch;
+};
+
+MappingCache &fileMappings();
+
+// ==================== io_uring ====================
+
+// Reads kept in flight by a table scan with the uring backend
+constexpr unsigned scanReadAheadDepth = 4;
+
+// Submission queue size used for batched lookups
+constexpr unsigned lookupRingEntries = 64;
+
+struct ReadRequest {
+    uint64_t offset;
+    size_t length;
+    char *buffer;
+    int bufferIndex = -1; // registered buffer containing `buffer`, -1 if none
+};
+
+// An io_uring instance driven through the raw system calls. Reads are queued
+// and go to the kernel together on the next wait, so a whole batch costs one
+// io_uring_enter. Every read must finish in full: a short read (the end of the
+// file) counts as a failure and the caller reads through the buffer pool.
+class IoRing {
+public:
+    explicit IoRing(unsigned entries);
+    ~IoRing(); // waits for reads still in flight, their buffers may be freed next
+
+    IoRing(const IoRing &) = delete;
+    IoRing &operator=(const IoRing &) = delete;
+
+    // False when the kernel has no io_uring or refused to set one up
+    bool ready() const { return ringFd >= 0; }
+
+    unsigned capacity() const { return entries; }
+
+    // Pin buffers for READ_FIXED. False if the kernel refused (memlock limit);
+    // the reads then go through plain READ.
+    bool registerBuffers(const vector<iovec> &buffers);
+
+    // Queue a read tagged with `tag`. At most capacity() reads may be queued
+    // or in flight at once.
+    void queueRead(int fd, const ReadRequest &request, uint64_t tag);
+
+    // Submit what is queued and wait until the read tagged `tag` completes.
+    // False if it failed or came back short.
+    bool waitFor(uint64_t tag);
+
+    // Read every request, up to capacity() at a time
+    bool readAll(int fd, const vector<ReadRequest> &requests);
+
+private:
+    bool reapOne();
+
+    int ringFd = -1;
+    unsigned entries = 0;
+    unsigned queued = 0;   // in the submission queue, not yet handed to the kernel
+    unsigned inFlight = 0; // queued or submitted, not yet reaped
+    bool buffersRegistered = false;
+
+    // Ring memory shared with the kernel
+    void *submissionRing = nullptr, *completionRing = nullptr, *entryArray = nullptr;
+    size_t submissionRingSize = 0, completionRingSize = 0, entryArraySize = 0;
+    unsigned *sqTail = nullptr, *sqMask = nullptr, *sqArray = nullptr;
+    unsigned *cqHead = nullptr, *cqTail = nullptr, *cqMask = nullptr;
+    void *completions = nullptr;
+
+    unordered_map<uint64_t, size_t> expected;  // tag -> bytes the read must return
+    unordered_map<uint64_t, bool> completed;   // tag -> read in full
+};
+
+#endif //SIMDB_IOBACKEND_H
@@ -0,0 +1,53 @@
+#ifndef SIMDB_PLANNER_H
+#define SIMDB_PLANNER_H
+
+#include "Predicate.h"
+
+enum class AccessPathType {
+    FullScan,   // TableScanIterator over the whole data file
+    IdLookup,   // probe the ID index for IDs in [lowId, highId]
+    IdList,     // probe the ID index for each of `ids`, as one batch
+    IndexScan,  // range scan of a secondary B+Tree index, records fetched by ID
+    BitmapScan, // IDs from the bitmap indexes of = and IN predicates, records fetched by ID
+    Empty      // the predicates exclude every record
+};
+
+// How a SELECT reaches its records. The conditions are still evaluated on
+// every record the access path returns, the plan only narrows the input.
+struct AccessPath {
+    AccessPathType type = AccessPathType::FullScan;
+    int lowId = 0;  // inclusive
+    int highId = 0; // inclusive
+    vector<int> ids; // IdList and BitmapScan: sorted and distinct
+
+    // IndexScan: the index and its inclusive key bounds, missing bounds are open
+    const IndexInfo *index = nullptr;
+    string columnName;
+    optional<string> lowKey, highKey;
+
+    // BitmapScan: the columns whose bitmaps were combined into `ids`
+    vector<string> bitmapColumns;
+
+    // FullScan of a table with a zone map or Bloom filters: the slot ranges of
+    // the zones the predicates don't rule out, and how many of how many zones
+    // they cover
+    bool zoneMapped = false;
+    bool bloomFiltered = false;
+    vector<pair<uint64_t, uint64_t>> slotRanges;
+    size_t zonesScanned = 0, zoneCount = 0;
+
+    string describe() const;
+};
+
+// Recognize ID =, <, <=, >, >= (and BETWEEN, which the parser splits into
+// >= and <=) and turn them into a point or range probe of the dense ID index;
+// ID IN (...) becomes a batch of point probes within those bounds.
+// Without ID predicates, the same operators on a column with a B+Tree index
+// become an index range scan, preferring an index with an equality predicate.
+// = and IN on columns with bitmap indexes are answered by combining the
+// bitmaps, and the matching IDs fetched unless there are more of them than
+// pages in the table or a B+Tree point lookup would do as well.
+// A full scan reads only the zones the table's zone map can't rule out.
+AccessPath planAccessPath(const TableInfo &table, const vector<CompiledPredicate> &predicates);
+
+#endif //SIMDB_PLANNER_H
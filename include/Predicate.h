@@ -0,0 +1,73 @@
+#ifndef SIMDB_PREDICATE_H
+#define SIMDB_PREDICATE_H
+
+#include "Catalog.h"
+
+// How the record value and operand are compared
+enum class KernelKind { Int, Float, IntAsFloat, String };
+
+// A WHERE condition bound to a table: the column offset is resolved, the
+// operand has the column's type and the kernel is specialized for the
+// operator, so evaluating a record is a single indirect call.
+struct CompiledPredicate {
+    using Kernel = bool (*)(const CompiledPredicate &predicate, const char *record);
+
+    Kernel kernel = nullptr;
+    int columnIndex = -1;
+    int offset = 0;    // byte offset of the column inside a record
+    int size = 0;      // column width in bytes
+    ColumnType type = ColumnType::Int;
+    KernelKind kind = KernelKind::Int;
+    CompareOp op = CompareOp::Equal;
+
+    int intValue = 0;
+    float floatValue = 0;
+    double doubleValue = 0; // IntAsFloat: a float can't hold every int exactly
+    string stringValue;
+
+    // IN: one equality predicate per list value, the record matches if any
+    // does. Int lists are sorted by value so the kernel can binary search.
+    vector<CompiledPredicate> anyOf;
+
+    bool isInList() const { return !anyOf.empty(); }
+
+    // = and != on a string column can be answered from dictionary codes
+    bool comparesCodes() const {
+        return kind == KernelKind::String && !isInList() && (op == CompareOp::Equal || op == CompareOp::NotEqual);
+    }
+    bool matches(const char *record) const { return kernel(*this, record); }
+};
+
+// Compile the conditions once per query. Returns false (after reporting why)
+// when a condition names an unknown column, operator or incompatible value.
+bool compilePredicates(const TableInfo &table, const vector<Condition> &conditions,
+                       vector<CompiledPredicate> &predicates);
+
+// Operand as a fixed-width key of the column, laid out like the record's
+// value. nullopt for a fractional or out of range operand on an int column
+// (IntAsFloat), which no key can stand for.
+optional<string> predicateKey(const TableInfo &table, const CompiledPredicate &predicate);
+
+inline bool matchesAll(const vector<CompiledPredicate> &predicates, const char *record) {
+    for (const auto &predicate: predicates) {
+        if (!predicate.matches(record)) return false;
+    }
+    return true;
+}
+
+// Dictionary codes of a predicate's column for the records of a batch, and
+// the code of the predicate's operand (-1 when the dictionary doesn't hold it)
+struct CodedOperand {
+    const uint16_t *codes = nullptr;
+    int code = -1;
+};
+
+// Evaluate the predicates over `count` contiguous records and leave one bit per
+// surviving row in `selection`. Int and float predicates, and string ones with
+// codes in `coded` (parallel to `predicates`, may be empty), run as vectorized
+// batch kernels, the others (and IN lists) row by row over the rows still
+// selected.
+void filterBatch(const vector<CompiledPredicate> &predicates, const char *records, size_t count,
+                 int recordSize, vector<uint64_t> &selection, const vector<CodedOperand> &coded = {});
+
+#endif //SIMDB_PREDICATE_H
@@ -0,0 +1,65 @@
+#ifndef SIMDB_RESULTCURSOR_H
+#define SIMDB_RESULTCURSOR_H
+
+#include "Predicate.h"
+#include "TableScan.h"
+#include "RowBatch.h"
+#include "Planner.h"
+
+using Value = variant<int, float, string>;
+using Row = vector<Value>;
+
+// Pull-based SELECT result. Rows are produced lazily from the table scan, one
+// filtered chunk at a time, so memory use doesn't depend on the result size and
+// the first row is available as soon as the first chunk has been filtered.
+// Each chunk becomes a columnar RowBatch holding just the projected columns of
+// the rows that passed the filter.
+class ResultCursor {
+public:
+    ResultCursor(const string &tableName, const vector<string> &columnsToReturn,
+                 const vector<Condition> &conditions);
+
+    // False when the table doesn't exist or a condition can't be compiled;
+    // next() then returns no rows.
+    bool isOpen() const { return source != nullptr; }
+
+    // Names of the returned columns, in output order
+    const vector<string> &columnNames() const { return names; }
+
+    // How the records are reached: full scan or ID index lookup
+    const AccessPath &accessPath() const { return path; }
+
+    // Next non-empty batch of matching rows, false at the end of the result.
+    // The batch's string views are invalidated by the following call.
+    bool nextBatch(RowBatch &batch);
+
+    // Fill `row` with the next matching record. The row is reused between calls,
+    // string cells keep their capacity. Returns false at the end of the result.
+    bool next(Row &row);
+
+    size_t rowsReturned() const { return returned; }
+
+private:
+    void decodeColumn(const ColumnInfo &column, ColumnType type, int offset, ColumnVector &vector) const;
+
+    shared_lock<shared_mutex> reading; // keeps VACUUM from swapping the files mid-query
+    shared_ptr<const TableInfo> table;
+    vector<int> columnIndices;
+    vector<string> names;
+    vector<CompiledPredicate> predicates;
+    AccessPath path;
+    unique_ptr<RecordSource> source;
+
+    // Current filtered chunk
+    const char *records = nullptr;
+    vector<uint64_t> selection;
+    vector<uint32_t> selectedRows;
+    vector<CodedOperand> coded; // string predicates evaluated on dictionary codes
+
+    // Batch backing the row-at-a-time API
+    RowBatch rowBatch;
+    size_t rowPosition = 0;
+    size_t returned = 0;
+};
+
+#endif //SIMDB_RESULTCURSOR_H
@@ -0,0 +1,40 @@
+#ifndef SIMDB_ROWBATCH_H
+#define SIMDB_ROWBATCH_H
+
+#include "Storage.h"
+
+// One projected column of a batch, decoded into a typed vector. String cells
+// are views into the scan's chunk buffer (padding stripped) and stay valid
+// until the cursor produces its next batch.
+struct ColumnVector {
+    ColumnType type = ColumnType::Int;
+    vector<int32_t> ints;
+    vector<float> floats;
+    vector<string_view> strings;
+
+    void clear() {
+        ints.clear();
+        floats.clear();
+        strings.clear();
+    }
+};
+
+// Rows that passed the filter, stored column by column. Only the columns
+// named in the projection are decoded, and only for the selected rows.
+struct RowBatch {
+    vector<ColumnVector> columns;
+    size_t size = 0;
+
+    // Copy one cell out of the batch
+    variant<int, float, string> value(size_t column, size_t row) const {
+        const ColumnVector &vector = columns[column];
+        switch (vector.type) {
+            case ColumnType::Int: return vector.ints[row];
+            case ColumnType::Float: return vector.floats[row];
+            case ColumnType::String: return string(vector.strings[row]);
+        }
+        return 0;
+    }
+};
+
+#endif //SIMDB_ROWBATCH_H
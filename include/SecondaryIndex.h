@@ -0,0 +1,36 @@
+#ifndef SIMDB_SECONDARYINDEX_H
+#define SIMDB_SECONDARYINDEX_H
+
+#include "Catalog.h"
+#include "BTree.h"
+
+// "<index>:<column>" per line, one line per secondary index of the table
+const string indexListFileType = ".indexes";
+
+string indexFilePath(const string &tableName, const string &indexName);
+
+// (index name, column name) pairs registered for the table, empty if none
+vector<pair<string, string>> readIndexList(const string &tableName);
+
+// Index builds sort (value, ID) entries in runs of at most this many bytes;
+// a larger table spills its runs to temporary files and merges them
+constexpr size_t indexSortRunBytes = 64 * 1024 * 1024;
+const string indexRunFileType = ".run";
+
+// Bulk load a B+Tree at `filePath` from the sorted values of a column
+bool buildIndex(const TableInfo &table, int column, const string &filePath, size_t runBytes = indexSortRunBytes);
+
+// Build a B+Tree over an existing column by bulk loading its sorted values,
+// then register it. Returns false (after reporting why) on bad names.
+bool createIndex(const string &tableName, const string &indexName, const string &columnName);
+bool dropIndex(const string &tableName, const string &indexName);
+
+// Remove every index of a table, used when the table is recreated
+void dropAllIndexes(const string &tableName);
+
+// Keep every index of the table in step with a record added under `id` or
+// removed from it. `record` is the serialized record.
+bool indexInsertRecord(const TableInfo &table, const char *record, int id);
+bool indexRemoveRecord(const TableInfo &table, const char *record, int id);
+
+#endif //SIMDB_SECONDARYINDEX_H
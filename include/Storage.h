@@ -1,40 +1,115 @@
 //
 // Created by abdallah-selim on 3/7/25.
 //
+#ifndef SIMDB_STORAGE_H
+#define SIMDB_STORAGE_H
+
 #include <bits/stdc++.h>
 using namespace std ;
 const string dataPath = "../data/";
 const string dataFileType = ".bin";
 const string schemaFileType = ".schema";
-const string indexFileType =".idx";
+const string indexFileType =".idx"; // ID -> offset array of tables written before the .map file
+// ID -> slot map, one int per ID ever assigned, read a page at a time through
+// the buffer pool. Deleted IDs leave a -1 hole that is never filled again.
+const string idMapFileType = ".map";
+constexpr int noSlot = -1;
+const string freeListFileType = ".free";
+// Columnar tables: how each column of each segment is encoded (Columnar.h)
+const string segmentFileType = ".seg";
+// Compressed tables: where each compressed block of the data file is (Compression.h)
+const string blockIndexFileType = ".blk";
+// Min/max of every column per zone of slots, for skipping zones in scans (ZoneMap.h)
+const string zoneMapFileType = ".zmap";
 const string ID_COLUMN = "ID";
 
+// A deleted record keeps its slot; its ID column is overwritten with this
+constexpr int tombstoneId = -1;
+
 constexpr int headerSize=60 ;
 
+// Record IDs and slot numbers are 32-bit: the ID column is a 4-byte int.
+// Byte offsets and counts are 64-bit, so a table file can pass 4 GB.
+using RecordId = int32_t;
+using FileOffset = uint64_t;
+constexpr uint64_t maxRecordId = numeric_limits<RecordId>::max();
+
+// How the records of a table file are laid out
+enum class TableLayout : uint32_t {
+    Row = 0,      // each record's columns back to back
+    Columnar = 1, // PAX: inside each segment of slots, each column's values back to back
+};
+
+// Slots per segment of a new columnar table
+constexpr uint32_t defaultSegmentRecords = 4096;
+
+// Packed to 4 bytes so the 64-bit fields fit in the 60 bytes before the first
+// record, like the 32-bit fields of older headers did
+#pragma pack(push, 4)
 struct DBHeader {
-    char magic[4];       // File identifier (e.g., "SDB1")
-    int numRecords; // Number of records in the file
-    uint32_t freeOffset; // Next free space for writing new records
-    char reserved[48];   // Reserved space for future use (padding)
+    char magic[4];           // File identifier, "SDB2"
+    uint64_t numRecords;     // Number of live records in the file
+    FileOffset freeOffset;   // Next free space for writing new records
+    uint64_t slotCount;      // Slots ever used, live or deleted
+    uint64_t freeSlots;      // Deleted slots waiting on the .free stack
+    uint64_t nextRecordId;   // IDs are handed out from here and never reused
+    TableLayout layout;      // Zero (row) in files written before columnar tables
+    uint32_t segmentRecords; // Columnar: slots per segment
+    uint32_t blockRecords;   // Compressed: slots per compressed block, zero if not compressed
+    char reserved[4];        // Reserved space for future use (padding)
 
     DBHeader() {
-        memcpy(magic, "SDB1", 4);
+        memcpy(magic, "SDB2", 4);
         numRecords = 0;
-        freeOffset = sizeof(DBHeader);
+        freeOffset = headerSize;
+        slotCount = 0;
+        freeSlots = 0;
+        nextRecordId = 0;
+        layout = TableLayout::Row;
+        segmentRecords = 0;
+        blockRecords = 0;
         memset(reserved, 0, sizeof(reserved));
     }
 };
+#pragma pack(pop)
+static_assert(sizeof(DBHeader) == headerSize, "records start right after the header");
+
+// Files with any other magic use an older header layout and are upgraded
+// when first loaded
+constexpr char currentHeaderMagic[4] = {'S', 'D', 'B', '2'};
+
+// Records never move, so slot N of a table file always sits at the same offset.
+// In a columnar table this is where slot N would start in a row table; the
+// values themselves are found with columnValueOffset (Columnar.h).
+inline FileOffset slotOffset(uint64_t slot, int recordSize) {
+    return headerSize + static_cast<FileOffset>(slot) * recordSize;
+}
+// Path of another file of the table a data file belongs to, e.g.
+// ("t.bin", ".seg") -> "t.seg". The new data file a VACUUM writes
+// ("t.bin.new") gets new companions too ("t.seg.new").
+string companionFilePath(const string &dataFilePath, const string &fileType);
+
 struct ColumnInfo {
     string name;
     string type;  // "int", "string(20)", "float", etc.
     int size;  // Size in bytes (calculated for strings)
 };
 
+// Typed form of ColumnInfo::type, resolved once when a schema is loaded
+enum class ColumnType { Int, Float, String };
+
+inline ColumnType columnTypeOf(const ColumnInfo &column) {
+    if (column.type == "int") return ColumnType::Int;
+    if (column.type == "float") return ColumnType::Float;
+    return ColumnType::String;
+}
+
 // Define a simple condition structure
 struct Condition {
     string columnName;
-    string operatorType;  // "=", "<", ">", "<=", ">=", "!="
+    string operatorType;  // "=", "<", ">", "<=", ">=", "!=", "IN"
     variant<int, float, string> value;
+    vector<variant<int, float, string>> values; // IN: the list, `value` is unused
 
     // Constructor for int values
     Condition(const string& col, const string& op, int val)
@@ -47,6 +122,10 @@ struct Condition {
     // Constructor for string values
     Condition(const string& col, const string& op, const string& val)
         : columnName(col), operatorType(op), value(val) {}
+
+    // Constructor for IN lists
+    Condition(const string& col, vector<variant<int, float, string>> vals)
+        : columnName(col), operatorType("IN"), value(0), values(move(vals)) {}
 };
 
 // Template function to compare values based on operator
@@ -61,16 +140,63 @@ bool applyComparison(const T &recordValue, const T &conditionValue, const string
     return false;
 }
 
+enum class CompareOp { Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual };
+
+// Map "=", "!=", "<", "<=", ">", ">=" to a CompareOp, false for anything else
+inline bool parseCompareOp(const string &op, CompareOp &result) {
+    static const unordered_map<string, CompareOp> operators = {
+        {"=", CompareOp::Equal}, {"!=", CompareOp::NotEqual},
+        {"<", CompareOp::Less}, {"<=", CompareOp::LessEqual},
+        {">", CompareOp::Greater}, {">=", CompareOp::GreaterEqual},
+    };
+    auto it = operators.find(op);
+    if (it == operators.end()) return false;
+    result = it->second;
+    return true;
+}
+
+// Same comparison with the operator fixed at compile time, no per-call dispatch
+template <CompareOp Op, typename T>
+bool applyComparison(const T &recordValue, const T &conditionValue) {
+    if constexpr (Op == CompareOp::Equal) return recordValue == conditionValue;
+    if constexpr (Op == CompareOp::NotEqual) return recordValue != conditionValue;
+    if constexpr (Op == CompareOp::Less) return recordValue < conditionValue;
+    if constexpr (Op == CompareOp::LessEqual) return recordValue <= conditionValue;
+    if constexpr (Op == CompareOp::Greater) return recordValue > conditionValue;
+    if constexpr (Op == CompareOp::GreaterEqual) return recordValue >= conditionValue;
+    return false;
+}
+
 void writeHeader(const string &tableName,const DBHeader &header)  ;
 struct DBHeader readHeader(const string &tableName) ;
 ColumnInfo parseSchemaLine(const string &line) ;
 vector<ColumnInfo> readSchema(const string &tableName);
 int calculateRecordSize(const string &tableName) ;
 void writeRecord(const string &tableName,vector<string>values) ;
+
+// Rows are appended in batches of at most this many bytes; each batch is one
+// data write, one .idx write, one header update and one log record.
+constexpr size_t bulkLoadBatchBytes = 4 * 1024 * 1024;
+
+struct TableInfo;
+
+// Serialize one row (every column but ID, as text) into `record`, which must
+// hold recordSize bytes. Throws runtime_error on a bad value or value count.
+void encodeRecord(const TableInfo &table, const vector<string_view> &values, int id, char *record);
+void encodeRecord(const TableInfo &table, const vector<string> &values, int id, char *record);
+
+// Append `count` encoded records laid out back to back. Records get
+// consecutive new IDs from the header's counter, patched into their ID column
+// in place. Slots freed by deletes are filled first, the rest go after the
+// last slot. Returns `count`; throws runtime_error if a write fails.
+size_t appendRecords(const string &tableName, char *records, size_t count);
+
+// Encode and append rows through appendRecords. Returns the number of
+// rows written; throws runtime_error on a bad row before writing any.
+size_t writeRecords(const string &tableName, const vector<vector<string>> &rows);
 void readRecords(const string &tableName) ;
 
-void createTable(const string &tableName,const string &columnsInfoPartq) ;
-bool updateIndex(const string &tableName, const int offset)  ;
+void createTable(const string &tableName, const string &columnsInfoPartq, TableLayout layout = TableLayout::Row);
 void readRecordWithIndex(const string &tableName, int id) ;
 bool updateRecord(const string &tableName, int id, const vector<string> &newValues) ;
 bool deleteRecord(const string &tableName, int id) ;
@@ -82,4 +208,6 @@ vector<vector<variant<int, float, string>>> getRecordsWithCondition(
 );
 void displayQueryResults(const string& tableName,
                           const vector<string>& columns,
-                          const vector<Condition>& conditions) ;
\ No newline at end of file
+                          const vector<Condition>& conditions) ;
+
+#endif //SIMDB_STORAGE_H
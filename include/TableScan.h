@@ -0,0 +1,166 @@
+#ifndef SIMDB_TABLESCAN_H
+#define SIMDB_TABLESCAN_H
+
+#include <bits/stdc++.h>
+#include "IoBackend.h"
+using namespace std;
+
+struct TableInfo;
+struct SegmentDictionary;
+
+constexpr size_t defaultScanChunkBytes = 256 * 1024;
+
+// Buffers a pool backend scan alternates between: one is filtered while the
+// prefetch thread reads the next chunk into the other
+constexpr size_t scanPrefetchBuffers = 2;
+
+// Produces the records a query reads, one batch of contiguous records at a time
+class RecordSource {
+public:
+    virtual ~RecordSource() = default;
+
+    // Next run of records laid out back to back. Returns the number of records
+    // available at `records`, 0 once the source is exhausted.
+    virtual size_t nextBatch(const char *&records) = 0;
+
+    // Dictionary codes of a string column for the records of the last batch,
+    // with the dictionary they index. nullptr when the column isn't encoded
+    // there; the records then hold its values.
+    virtual const uint16_t *columnCodes(int /*column*/, const SegmentDictionary *&/*dictionary*/) {
+        return nullptr;
+    }
+};
+
+// Streams the records of a table file in physical order, from the end of the
+// header up to the table's free offset. Records are read in large contiguous
+// chunks through the buffer pool; the index file is never touched. With the
+// mmap backend the chunks point straight into the file mapping instead, and
+// with the uring backend the next scanReadAheadDepth chunks are read ahead
+// into registered buffers while the current one is consumed. A pool backend
+// scan of more than one chunk reads the next chunk on a prefetch thread,
+// straight from the file for every page the pool holds no newer copy of.
+class TableScanIterator : public RecordSource {
+public:
+    TableScanIterator(const string &tableName, int recordSize, uint64_t endOffset,
+                      size_t chunkBytes = defaultScanChunkBytes);
+    ~TableScanIterator() override;
+
+    // Call before the first chunk. Columnar and compressed tables are read
+    // through readSlots; of a columnar table only these columns (all if
+    // empty) are read, the others hold garbage, and chunks stay inside one
+    // segment.
+    void readColumns(const TableInfo &table, vector<int> columns);
+
+    // Call before the first chunk: read only the slots of these ranges
+    // [first, end), given in slot order. Chunks don't cross a range's end.
+    void restrictToSlots(const vector<pair<uint64_t, uint64_t>> &slotRanges);
+
+    // Next record, or nullptr once the scan is exhausted or a read failed.
+    // The pointer stays valid until the next chunk is loaded.
+    const char *next();
+
+    // Next run of contiguous records (at most one chunk). Returns the number of
+    // records available at `records`, 0 at the end of the scan.
+    size_t nextBatch(const char *&records) override;
+
+    const uint16_t *columnCodes(int column, const SegmentDictionary *&dictionary) override;
+
+    // File offset of the record most recently returned by next()
+    uint64_t recordOffset() const { return chunkOffset + (position - 1) * recordSize; }
+
+    bool failed() const { return readFailed; }
+
+private:
+    size_t chunkAt(uint64_t &offset) const;
+    bool loadChunk();
+    void startReadAhead();
+    bool loadReadAheadChunk();
+    void queueReadAhead(size_t slot);
+    bool loadPrefetchedChunk();
+    void prefetchChunks();
+    bool readDirect(uint64_t offset, char *buffer, size_t length);
+
+    string filePath;
+    int recordSize;
+    uint64_t nextOffset;
+    uint64_t endOffset;
+    vector<pair<uint64_t, uint64_t>> ranges; // byte ranges of whole records to read, in file order
+    uint64_t chunkOffset = 0;
+    size_t chunkRecords;
+    size_t available = 0;
+    size_t position = 0;
+    bool readFailed = false;
+    FileMapping *mapping = nullptr;
+    const char *chunkData = nullptr; // the mapping, `chunk` or a read-ahead buffer
+    vector<char> chunk;
+    const TableInfo *table = nullptr; // set for columnar and compressed tables
+    vector<int> columns;
+    size_t batchPosition = 0; // first record of the last batch
+    vector<shared_ptr<const SegmentDictionary>> dictionaries; // handed out for the current chunk
+
+    // Read-ahead: chunk k is read into slot k % scanReadAheadDepth (uring) or
+    // k % scanPrefetchBuffers (prefetch thread). The buffers are declared
+    // before the ring so the ring drains first.
+    bool readAheadStarted = false;
+    int fd = -1;
+    vector<char> readAheadBuffers;
+    unique_ptr<IoRing> ring;
+    uint64_t readAheadOffset = 0; // where the next read-ahead starts
+    size_t loadedChunks = 0;
+
+    enum PrefetchState { PrefetchEmpty, PrefetchReady, PrefetchFailed };
+    thread prefetcher;
+    mutex prefetchLatch;
+    condition_variable prefetchChanged;
+    array<PrefetchState, scanPrefetchBuffers> prefetchState{};
+    bool prefetchStopping = false;
+};
+
+// Fetches the records with IDs in [firstId, lastId], or with the IDs of a sorted
+// list, through the ID map. Each batch reads its slice of the .map file (one
+// read per run of consecutive IDs), skips the holes of deleted IDs, then reads
+// the records, merging reads of records that sit next to each other in the
+// data file. With the mmap backend slots and records are read from the file
+// mappings, and a batch that is one run of records isn't copied at all. With
+// the uring backend all reads of a batch's slots, then all reads of its
+// records, are submitted at once.
+class IndexLookupIterator : public RecordSource {
+public:
+    IndexLookupIterator(const string &tableName, int recordSize, int firstId, int lastId,
+                        size_t chunkBytes = defaultScanChunkBytes);
+    IndexLookupIterator(const string &tableName, int recordSize, vector<int> ids,
+                        size_t chunkBytes = defaultScanChunkBytes);
+    ~IndexLookupIterator() override;
+
+    // Columnar and compressed tables: read records through readSlots, of a
+    // columnar table only these columns (all if empty)
+    void readColumns(const TableInfo &table, vector<int> columns);
+
+    size_t nextBatch(const char *&records) override;
+
+    bool failed() const { return readFailed; }
+
+private:
+    bool readRuns(const string &filePath, int &fd, const vector<ReadRequest> &runs);
+
+    string dataFilePath;
+    string mapFilePath;
+    int recordSize;
+    long long nextId;
+    long long lastId;
+    vector<int> ids;       // list mode: IDs to fetch, nextId and lastId index into it
+    bool idList = false;
+    size_t chunkRecords;
+    bool readFailed = false;
+    vector<int> slots;
+    FileMapping *dataMapping = nullptr;
+    FileMapping *mapMapping = nullptr;
+    vector<ReadRequest> runs;
+    const TableInfo *table = nullptr; // set for columnar and compressed tables
+    vector<int> columns;
+    int dataFd = -1, mapFd = -1;
+    unique_ptr<IoRing> ring; // created for the first batch with several reads
+    vector<char> chunk;
+};
+
+#endif //SIMDB_TABLESCAN_H
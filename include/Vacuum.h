@@ -0,0 +1,42 @@
+#ifndef SIMDB_VACUUM_H
+#define SIMDB_VACUUM_H
+
+#include <bits/stdc++.h>
+using namespace std;
+
+// Lists the files a VACUUM is swapping in, one final path per line. Each new
+// file sits next to its final path with vacuumNewFileType appended.
+const string vacuumIntentFileType = ".vacuum";
+const string vacuumNewFileType = ".new";
+
+// Seconds between background compaction passes; unset or 0 turns them off
+const string vacuumIntervalEnv = "SIMDB_VACUUM_INTERVAL";
+
+// The background compactor only rewrites tables with at least this share of
+// their slots deleted
+constexpr double vacuumDeadSlotRatio = 0.25;
+
+// Rewrite the live records of a table contiguously in ID order, rebuild its
+// secondary indexes and swap the new files in.
+//
+// Writers are blocked for the whole rewrite. Readers keep using the old files
+// until the new ones are complete and synced; the swap waits for them to
+// finish, then renames every new file over the old one. The renames are
+// driven by an intent file, so a crash after it is written still completes
+// the swap the next time the table is loaded.
+//
+// IDs don't change, only the slots behind them. With `compress` the new data
+// file is compressed in blocks before the swap (COMPRESS TABLE); without it a
+// compressed table comes out uncompressed and writable again. Returns false
+// (after reporting why) if the table can't be read or a file can't be written.
+bool vacuumTable(const string &tableName, bool compress = false);
+
+// Finish a swap a crashed VACUUM had committed to. True if there was none.
+bool completeVacuum(const string &tableName);
+
+// Start or stop the background compactor thread. Starting does nothing
+// unless SIMDB_VACUUM_INTERVAL is set.
+void startBackgroundVacuum();
+void stopBackgroundVacuum();
+
+#endif //SIMDB_VACUUM_H
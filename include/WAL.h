@@ -0,0 +1,97 @@
+#ifndef SIMDB_WAL_H
+#define SIMDB_WAL_H
+
+#include <bits/stdc++.h>
+using namespace std;
+
+const string walFileName = "simdb.wal";
+constexpr uint64_t walCheckpointBytes = 16 * 1024 * 1024;
+
+// Redo-only write-ahead log shared by every table.
+//
+// A mutating statement runs inside a WalTransaction. The buffer pool records
+// the bytes it changes and keeps those pages pinned; at commit the after-image
+// of every changed range goes into one checksummed log record, appended
+// sequentially. Committers wait until their record is durable. Whoever finds
+// no flush in progress becomes the leader and syncs everything appended so far
+// with a single fdatasync, so concurrent commits share it (group commit).
+//
+// Data pages are written back lazily, never before the log record that last
+// changed them. A checkpoint writes back and syncs every dirty page, then
+// empties the log. Recovery replays the complete records left in the log.
+//
+// A failed log write or sync is sticky: nothing appended from then on becomes
+// durable, so commits and checkpoints fail until the process restarts and
+// recovers from what did reach the log.
+class WriteAheadLog {
+public:
+    WriteAheadLog();
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog &) = delete;
+    WriteAheadLog &operator=(const WriteAheadLog &) = delete;
+
+    // Replay the log into the table files, then checkpoint. Call once at
+    // startup, before any table is read.
+    bool recover();
+
+    // Flush all pages and empty the log. Also run before and after DDL, which
+    // isn't logged, so the log never replays onto a schema it predates.
+    bool checkpoint();
+
+    // checkpoint() for a caller that already holds writerLatch()
+    bool checkpointLocked();
+
+    // Append a record and return its LSN; it is durable once waitDurable(lsn)
+    // returns true, false means the log can no longer be written
+    uint64_t append(const string &record, uint32_t writeCount);
+    bool waitDurable(uint64_t lsn);
+
+    bool needsCheckpoint();
+
+    // Serializes mutating statements. Held from the first write of a statement
+    // until its log record has been appended.
+    mutex &writerLatch() { return writer; }
+
+    uint64_t syncCount() const { return syncs; }
+
+private:
+    bool openLog();
+
+    string filePath;
+    int fd = -1;
+    mutex writer;
+
+    mutex latch;
+    condition_variable flushed;
+    string buffer;             // appended, not yet written
+    uint64_t nextLsn = 1;
+    uint64_t durableLsn = 0;
+    uint64_t logSize = 0;      // bytes in the log file plus the buffer
+    bool flushing = false;
+    bool failed = false;       // a log write or sync failed, see above
+    atomic<uint64_t> syncs{0};
+};
+
+WriteAheadLog &wal();
+
+// One logged mutating statement. The constructor takes the writer latch and
+// starts capturing page writes; commit logs them and waits for durability.
+// A statement that stops half way is rolled back by the destructor: its
+// pages go back to how it found them and nothing is logged.
+class WalTransaction {
+public:
+    WalTransaction();
+    ~WalTransaction();
+
+    WalTransaction(const WalTransaction &) = delete;
+    WalTransaction &operator=(const WalTransaction &) = delete;
+
+    bool commit();
+
+private:
+    unique_lock<mutex> writerLock;
+    bool committed = false;
+};
+
+#endif //SIMDB_WAL_H
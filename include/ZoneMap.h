@@ -0,0 +1,34 @@
+#ifndef SIMDB_ZONEMAP_H
+#define SIMDB_ZONEMAP_H
+
+#include "Predicate.h"
+
+// Zone maps: the smallest and largest value of every column over each zone of
+// zoneRecords consecutive slots. The table's zone map file (zoneMapFileType)
+// holds one entry per zone: the number of records folded into it, then a
+// record holding the minimum of each column and one holding the maximum.
+//
+// Every record write widens the bounds of its zone, deletes leave them as
+// they are, so a zone's bounds always cover its live records and a full scan
+// can skip a zone whose bounds rule out a predicate. VACUUM rebuilds the
+// bounds from the live records. Tables written before zone maps have no file
+// and are scanned whole until their first VACUUM.
+
+constexpr uint32_t zoneRecords = 1024;
+
+// Fold `count` row-major records written to the slots from `firstSlot` on into
+// the zone map of the data file at `filePath`. True without doing anything if
+// the table has no zone map.
+bool updateZoneMap(const TableInfo &table, const string &filePath, uint64_t firstSlot, const char *records,
+                   size_t count);
+
+// Slot ranges [first, end) of the zones that may hold records matching every
+// predicate, in slot order with neighbouring zones merged, and how many zones
+// that is. Zones are ruled out by their bounds and, for = and IN on a string
+// column with Bloom filters, by the filters (`bloomFiltered` says if any was
+// consulted). False if there is neither a zone map nor a filter to consult;
+// every slot has to be read then.
+bool zoneSlotRanges(const TableInfo &table, const vector<CompiledPredicate> &predicates,
+                    vector<pair<uint64_t, uint64_t>> &ranges, size_t &zonesScanned, bool &bloomFiltered);
+
+#endif //SIMDB_ZONEMAP_H
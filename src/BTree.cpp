@@ -0,0 +1,491 @@
+#include "../include/BTree.h"
+
+using namespace std;
+
+// Node layout: a 16 byte header (leaf flag, entry count, right sibling for
+// leaves), then the entries. Internal nodes keep their separators first and
+// the child page numbers after the last separator slot.
+constexpr size_t nodeHeaderSize = 16;
+constexpr char btreeMagic[4] = {'S', 'B', 'T', '1'};
+
+int compareKeys(ColumnType keyType, int keySize, const char *a, const char *b) {
+    switch (keyType) {
+        case ColumnType::Int: {
+            int32_t x, y;
+            memcpy(&x, a, sizeof(x));
+            memcpy(&y, b, sizeof(y));
+            return (x > y) - (x < y);
+        }
+        case ColumnType::Float: {
+            float x, y;
+            memcpy(&x, a, sizeof(x));
+            memcpy(&y, b, sizeof(y));
+            return (x > y) - (x < y);
+        }
+        case ColumnType::String:
+            return memcmp(a, b, keySize);
+    }
+    return 0;
+}
+
+// ==================== Pages ====================
+
+BTree::PageGuard::PageGuard(const string &filePath, uint32_t pageNo)
+    : filePath(filePath), pageNo(pageNo), page(bufferPool().fetchPage(filePath, pageNo)) {
+    if (!page) {
+        throw runtime_error("Failed to fetch page " + to_string(pageNo) + " of " + filePath);
+    }
+}
+
+BTree::PageGuard::~PageGuard() {
+    bufferPool().unpinPage(filePath, pageNo, dirty, dirtyBegin, dirtyEnd - dirtyBegin);
+}
+
+void BTree::PageGuard::markDirty(size_t offset, size_t length) {
+    dirtyBegin = dirty ? min(dirtyBegin, offset) : offset;
+    dirtyEnd = dirty ? max(dirtyEnd, offset + length) : offset + length;
+    dirty = true;
+}
+
+BTree::BTree(const string &filePath, ColumnType keyType, int keySize)
+    : filePath(filePath), keyType(keyType), keySize(keySize), entrySize(keySize + sizeof(int32_t)) {
+    leafCapacity = (PAGE_SIZE - nodeHeaderSize) / entrySize;
+    internalCapacity = (PAGE_SIZE - nodeHeaderSize - sizeof(uint32_t)) / (entrySize + sizeof(uint32_t));
+}
+
+int BTree::maxKeySize() {
+    const size_t leafKey = (PAGE_SIZE - nodeHeaderSize) / 2 - sizeof(int32_t);
+    const size_t internalKey = (PAGE_SIZE - nodeHeaderSize - sizeof(uint32_t)) / 2 - 2 * sizeof(uint32_t);
+    return static_cast<int>(min(leafKey, internalKey));
+}
+
+bool BTree::readMeta(Meta &meta) {
+    PageGuard page(filePath, 0);
+    memcpy(&meta, page.data(), sizeof(Meta));
+    if (memcmp(meta.magic, btreeMagic, 4) != 0 || meta.keySize != static_cast<uint32_t>(keySize)) {
+        cerr << "Error: " << filePath << " is not a B+Tree index for this column" << endl;
+        return false;
+    }
+    return true;
+}
+
+bool BTree::writeMeta(const Meta &meta) {
+    PageGuard page(filePath, 0);
+    memcpy(page.data(), &meta, sizeof(Meta));
+    page.markDirty(0, sizeof(Meta));
+    return true;
+}
+
+uint32_t BTree::allocatePage(Meta &meta) {
+    const uint32_t pageNo = meta.pageCount++;
+    PageGuard page(filePath, pageNo);
+    memset(page.data(), 0, PAGE_SIZE);
+    page.markDirty();
+    return pageNo;
+}
+
+// ==================== Node Accessors ====================
+
+uint16_t &BTree::count(char *node) { return *reinterpret_cast<uint16_t *>(node + 2); }
+uint16_t BTree::count(const char *node) { return *reinterpret_cast<const uint16_t *>(node + 2); }
+bool BTree::isLeaf(const char *node) { return node[0] != 0; }
+uint32_t &BTree::nextLeaf(char *node) { return *reinterpret_cast<uint32_t *>(node + 4); }
+
+char *BTree::entry(char *node, size_t i) const { return node + nodeHeaderSize + i * entrySize; }
+const char *BTree::entry(const char *node, size_t i) const { return node + nodeHeaderSize + i * entrySize; }
+
+uint32_t *BTree::children(char *node) const {
+    return reinterpret_cast<uint32_t *>(node + nodeHeaderSize + internalCapacity * entrySize);
+}
+
+const uint32_t *BTree::children(const char *node) const {
+    return reinterpret_cast<const uint32_t *>(node + nodeHeaderSize + internalCapacity * entrySize);
+}
+
+// ==================== Search ====================
+
+int BTree::compareEntries(const char *a, const char *b) const {
+    const int keyOrder = compareKeys(keyType, keySize, a, b);
+    if (keyOrder != 0) return keyOrder;
+    int32_t x, y;
+    memcpy(&x, a + keySize, sizeof(x));
+    memcpy(&y, b + keySize, sizeof(y));
+    return (x > y) - (x < y);
+}
+
+size_t BTree::lowerBound(const char *node, const char *target) const {
+    size_t low = 0, high = count(node);
+    while (low < high) {
+        const size_t mid = (low + high) / 2;
+        if (compareEntries(entry(node, mid), target) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+size_t BTree::childIndex(const char *node, const char *target) const {
+    // Separator i is the smallest entry of child i + 1
+    size_t low = 0, high = count(node);
+    while (low < high) {
+        const size_t mid = (low + high) / 2;
+        if (compareEntries(entry(node, mid), target) <= 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// ==================== Construction ====================
+
+bool BTree::create() {
+    bufferPool().dropFile(filePath);
+    ofstream file(filePath, ios::binary | ios::trunc);
+    if (!file) {
+        cerr << "Error creating index file: " << filePath << endl;
+        return false;
+    }
+    file.close();
+
+    Meta meta{};
+    memcpy(meta.magic, btreeMagic, 4);
+    meta.keyType = static_cast<uint32_t>(keyType);
+    meta.keySize = keySize;
+    meta.pageCount = 1;
+    meta.height = 1;
+
+    try {
+        meta.root = allocatePage(meta);
+        PageGuard root(filePath, meta.root);
+        root.data()[0] = 1;
+        root.markDirty();
+        return writeMeta(meta);
+    } catch (const exception &e) {
+        cerr << "Error: " << e.what() << endl;
+        return false;
+    }
+}
+
+bool BTree::bulkLoad(const vector<pair<string, int>> &sortedEntries) {
+    string current(entrySize, '\0');
+    size_t position = 0;
+    return bulkLoad([&]() -> const char * {
+        if (position == sortedEntries.size()) {
+            return nullptr;
+        }
+        memcpy(current.data(), sortedEntries[position].first.data(), keySize);
+        memcpy(current.data() + keySize, &sortedEntries[position].second, sizeof(int32_t));
+        position++;
+        return current.data();
+    });
+}
+
+bool BTree::bulkLoad(const function<const char *()> &next) {
+    if (!create()) {
+        return false;
+    }
+
+    try {
+        Meta meta;
+        if (!readMeta(meta)) {
+            return false;
+        }
+
+        // Leaves, reusing the empty root as the first one. Only the first
+        // entry of each node is kept for the levels above.
+        vector<pair<string, uint32_t>> level; // first entry and page of each node
+        uint32_t pageNo = meta.root;
+        const char *pending = next();
+        while (pending) {
+            if (!level.empty()) {
+                const uint32_t nextPage = allocatePage(meta);
+                PageGuard previous(filePath, pageNo);
+                nextLeaf(previous.data()) = nextPage;
+                previous.markDirty();
+                pageNo = nextPage;
+            }
+
+            PageGuard leaf(filePath, pageNo);
+            char *node = leaf.data();
+            node[0] = 1;
+            size_t filled = 0;
+            for (; pending && filled < leafCapacity; pending = next()) {
+                memcpy(entry(node, filled++), pending, entrySize);
+            }
+            count(node) = static_cast<uint16_t>(filled);
+            leaf.markDirty();
+            level.emplace_back(string(entry(node, 0), entrySize), pageNo);
+            meta.entries += filled;
+        }
+        if (level.empty()) {
+            return true;
+        }
+
+        // Internal levels until a single root remains
+        while (level.size() > 1) {
+            vector<pair<string, uint32_t>> parents;
+            for (size_t first = 0; first < level.size(); first += internalCapacity + 1) {
+                const size_t last = min(first + internalCapacity + 1, level.size());
+                const uint32_t parentPage = allocatePage(meta);
+                PageGuard parent(filePath, parentPage);
+                char *node = parent.data();
+                count(node) = static_cast<uint16_t>(last - first - 1);
+                for (size_t i = first; i < last; i++) {
+                    children(node)[i - first] = level[i].second;
+                    if (i > first) {
+                        memcpy(entry(node, i - first - 1), level[i].first.data(), entrySize);
+                    }
+                }
+                parent.markDirty();
+                parents.emplace_back(level[first].first, parentPage);
+            }
+            level = move(parents);
+            meta.height++;
+        }
+
+        meta.root = level[0].second;
+        return writeMeta(meta);
+    } catch (const exception &e) {
+        cerr << "Error: " << e.what() << endl;
+        return false;
+    }
+}
+
+// ==================== Modification ====================
+
+bool BTree::insert(const char *key, int id) {
+    try {
+        Meta meta;
+        if (!readMeta(meta)) {
+            return false;
+        }
+
+        string target(entrySize, '\0');
+        memcpy(target.data(), key, keySize);
+        memcpy(target.data() + keySize, &id, sizeof(int32_t));
+
+        // Descend to the leaf, remembering the way back up for splits
+        vector<pair<uint32_t, size_t>> path;
+        uint32_t pageNo = meta.root;
+        while (true) {
+            PageGuard page(filePath, pageNo);
+            if (isLeaf(page.data())) break;
+            const size_t child = childIndex(page.data(), target.data());
+            path.emplace_back(pageNo, child);
+            pageNo = children(page.data())[child];
+        }
+
+        PageGuard leaf(filePath, pageNo);
+        char *node = leaf.data();
+        const size_t n = count(node);
+        const size_t position = lowerBound(node, target.data());
+        if (position < n && compareEntries(entry(node, position), target.data()) == 0) {
+            return true; // already indexed
+        }
+
+        if (n < leafCapacity) {
+            memmove(entry(node, position + 1), entry(node, position), (n - position) * entrySize);
+            memcpy(entry(node, position), target.data(), entrySize);
+            count(node)++;
+            leaf.markDirty(0, nodeHeaderSize + (n + 1) * entrySize);
+            meta.entries++;
+            return writeMeta(meta);
+        }
+
+        // Split the full leaf: the upper half moves to a new right sibling
+        vector<char> merged((n + 1) * entrySize);
+        memcpy(merged.data(), entry(node, 0), position * entrySize);
+        memcpy(merged.data() + position * entrySize, target.data(), entrySize);
+        memcpy(merged.data() + (position + 1) * entrySize, entry(node, position), (n - position) * entrySize);
+
+        const size_t leftCount = (n + 1) / 2;
+        const size_t rightCount = n + 1 - leftCount;
+        const uint32_t rightPage = allocatePage(meta);
+        PageGuard right(filePath, rightPage);
+        char *sibling = right.data();
+        sibling[0] = 1;
+        count(sibling) = static_cast<uint16_t>(rightCount);
+        nextLeaf(sibling) = nextLeaf(node);
+        memcpy(entry(sibling, 0), merged.data() + leftCount * entrySize, rightCount * entrySize);
+        right.markDirty();
+
+        count(node) = static_cast<uint16_t>(leftCount);
+        nextLeaf(node) = rightPage;
+        memcpy(entry(node, 0), merged.data(), leftCount * entrySize);
+        leaf.markDirty();
+
+        const string separator(entry(sibling, 0), entrySize);
+        meta.entries++;
+        return insertIntoParent(meta, path, pageNo, separator, rightPage) && writeMeta(meta);
+    } catch (const exception &e) {
+        cerr << "Error: " << e.what() << endl;
+        return false;
+    }
+}
+
+bool BTree::insertIntoParent(Meta &meta, vector<pair<uint32_t, size_t>> &path, uint32_t leftPage,
+                             const string &separator, uint32_t rightPage) {
+    if (path.empty()) {
+        // The root split: grow the tree by one level
+        const uint32_t rootPage = allocatePage(meta);
+        PageGuard root(filePath, rootPage);
+        count(root.data()) = 1;
+        memcpy(entry(root.data(), 0), separator.data(), entrySize);
+        children(root.data())[0] = leftPage;
+        children(root.data())[1] = rightPage;
+        root.markDirty();
+        meta.root = rootPage;
+        meta.height++;
+        return true;
+    }
+
+    const auto [pageNo, position] = path.back();
+    path.pop_back();
+
+    PageGuard parent(filePath, pageNo);
+    char *node = parent.data();
+    const size_t n = count(node);
+    if (n < internalCapacity) {
+        memmove(entry(node, position + 1), entry(node, position), (n - position) * entrySize);
+        memcpy(entry(node, position), separator.data(), entrySize);
+        uint32_t *child = children(node);
+        memmove(child + position + 2, child + position + 1, (n - position) * sizeof(uint32_t));
+        child[position + 1] = rightPage;
+        count(node)++;
+        parent.markDirty();
+        return true;
+    }
+
+    // Split the full internal node around its middle separator, which moves up
+    vector<char> separators((n + 1) * entrySize);
+    memcpy(separators.data(), entry(node, 0), position * entrySize);
+    memcpy(separators.data() + position * entrySize, separator.data(), entrySize);
+    memcpy(separators.data() + (position + 1) * entrySize, entry(node, position), (n - position) * entrySize);
+
+    vector<uint32_t> pages(children(node), children(node) + n + 1);
+    pages.insert(pages.begin() + position + 1, rightPage);
+
+    const size_t middle = (n + 1) / 2;
+    const size_t rightCount = n - middle;
+    const uint32_t siblingPage = allocatePage(meta);
+    PageGuard right(filePath, siblingPage);
+    char *sibling = right.data();
+    count(sibling) = static_cast<uint16_t>(rightCount);
+    memcpy(entry(sibling, 0), separators.data() + (middle + 1) * entrySize, rightCount * entrySize);
+    memcpy(children(sibling), pages.data() + middle + 1, (rightCount + 1) * sizeof(uint32_t));
+    right.markDirty();
+
+    count(node) = static_cast<uint16_t>(middle);
+    memcpy(entry(node, 0), separators.data(), middle * entrySize);
+    memcpy(children(node), pages.data(), (middle + 1) * sizeof(uint32_t));
+    parent.markDirty();
+
+    const string promoted(separators.data() + middle * entrySize, entrySize);
+    return insertIntoParent(meta, path, pageNo, promoted, siblingPage);
+}
+
+bool BTree::remove(const char *key, int id) {
+    try {
+        Meta meta;
+        if (!readMeta(meta)) {
+            return false;
+        }
+
+        string target(entrySize, '\0');
+        memcpy(target.data(), key, keySize);
+        memcpy(target.data() + keySize, &id, sizeof(int32_t));
+
+        uint32_t pageNo = meta.root;
+        while (true) {
+            PageGuard page(filePath, pageNo);
+            if (isLeaf(page.data())) break;
+            pageNo = children(page.data())[childIndex(page.data(), target.data())];
+        }
+
+        PageGuard leaf(filePath, pageNo);
+        char *node = leaf.data();
+        const size_t n = count(node);
+        const size_t position = lowerBound(node, target.data());
+        if (position == n || compareEntries(entry(node, position), target.data()) != 0) {
+            return true; // nothing to remove
+        }
+
+        memmove(entry(node, position), entry(node, position + 1), (n - position - 1) * entrySize);
+        count(node)--;
+        leaf.markDirty(0, nodeHeaderSize + n * entrySize);
+        meta.entries--;
+        return writeMeta(meta);
+    } catch (const exception &e) {
+        cerr << "Error: " << e.what() << endl;
+        return false;
+    }
+}
+
+// ==================== Scans ====================
+
+bool BTree::scanRange(const char *lowKey, const char *highKey,
+                      const function<bool(const char *key, int id)> &visitor) {
+    try {
+        Meta meta;
+        if (!readMeta(meta)) {
+            return false;
+        }
+
+        // The smallest possible ID makes the probe sort before every entry with lowKey
+        string target(entrySize, '\0');
+        if (lowKey) {
+            const int32_t smallestId = numeric_limits<int32_t>::min();
+            memcpy(target.data(), lowKey, keySize);
+            memcpy(target.data() + keySize, &smallestId, sizeof(int32_t));
+        }
+
+        uint32_t pageNo = meta.root;
+        while (true) {
+            PageGuard page(filePath, pageNo);
+            if (isLeaf(page.data())) break;
+            pageNo = children(page.data())[lowKey ? childIndex(page.data(), target.data()) : 0];
+        }
+
+        size_t position = 0;
+        while (pageNo != 0) {
+            PageGuard leaf(filePath, pageNo);
+            const char *node = leaf.data();
+            if (lowKey && position == 0) {
+                position = lowerBound(node, target.data());
+            }
+
+            for (size_t n = count(node); position < n; position++) {
+                const char *key = entry(node, position);
+                if (highKey && compareKeys(keyType, keySize, key, highKey) > 0) {
+                    return true;
+                }
+                int32_t id;
+                memcpy(&id, key + keySize, sizeof(int32_t));
+                if (!visitor(key, id)) {
+                    return true;
+                }
+            }
+
+            pageNo = nextLeaf(leaf.data());
+            position = 0;
+            lowKey = nullptr; // every following entry is past the lower bound
+        }
+        return true;
+    } catch (const exception &e) {
+        cerr << "Error: " << e.what() << endl;
+        return false;
+    }
+}
+
+uint64_t BTree::size() {
+    try {
+        Meta meta;
+        return readMeta(meta) ? meta.entries : 0;
+    } catch (const exception &) {
+        return 0;
+    }
+}
@@ -0,0 +1,646 @@
+#include "../include/BitmapIndex.h"
+#include "../include/BufferPool.h"
+#include "../include/Columnar.h"
+#include "../include/FilterKernels.h"
+#include "../include/TableScan.h"
+#include "../include/WAL.h"
+
+using namespace std;
+
+string bitmapFilePath(const string &tableName, const string &columnName) {
+    return dataPath + tableName + "." + columnName + bitmapFileType;
+}
+
+// ==================== File Layout ====================
+
+constexpr size_t bitmapBlockBytes = 8192;
+constexpr uint32_t chunkBits = 16;
+constexpr uint32_t chunkIds = 1U << chunkBits;
+constexpr size_t containerWords = chunkIds / 64;
+constexpr uint32_t arrayMaxIds = bitmapBlockBytes / sizeof(uint16_t); // 4096, an array container fills a block
+
+struct BitmapHeader {
+    uint32_t valueCount;
+    uint32_t blockCount; // header blocks included, the next block goes here
+};
+
+// Directory entry of one chunk of one value, block 0 (a header block) if the
+// value never had an ID in the chunk
+struct ContainerRef {
+    uint32_t block;
+    uint32_t count;
+};
+
+constexpr uint32_t directoryChunks = bitmapBlockBytes / sizeof(ContainerRef);
+constexpr uint32_t valueDirectories = (maxRecordId + 1) / (uint64_t(chunkIds) * directoryChunks);
+
+static uint64_t keysOffset() {
+    return sizeof(BitmapHeader);
+}
+
+static uint64_t directoriesOffset(int keySize) {
+    return keysOffset() + uint64_t(bitmapMaxValues) * keySize;
+}
+
+static uint32_t headerBlocks(int keySize) {
+    const uint64_t bytes = directoriesOffset(keySize) + uint64_t(bitmapMaxValues) * valueDirectories * sizeof(uint32_t);
+    return static_cast<uint32_t>((bytes + bitmapBlockBytes - 1) / bitmapBlockBytes);
+}
+
+static uint64_t blockOffset(uint32_t block) {
+    return uint64_t(block) * bitmapBlockBytes;
+}
+
+// Values that compare equal share a bitmap: -0.0 is stored as 0.0 and every
+// NaN as the same NaN
+static void normalizeKey(ColumnType type, char *key) {
+    if (type != ColumnType::Float) {
+        return;
+    }
+    float number;
+    memcpy(&number, key, sizeof(float));
+    if (isnan(number)) {
+        number = numeric_limits<float>::quiet_NaN();
+    } else if (number == 0) {
+        number = 0;
+    }
+    memcpy(key, &number, sizeof(float));
+}
+
+// ==================== Containers ====================
+
+// The index of one column, its header and values read once per operation
+class BitmapFile {
+public:
+    BitmapFile(const TableInfo &table, int column)
+        : path(bitmapFilePath(table.name, table.columns[column].name)), keySize(table.columns[column].size) {}
+
+    // Start an empty index in place of whatever the file held
+    bool create() {
+        bufferPool().dropFile(path);
+        remove(path.c_str());
+        const vector<char> blocks(blockOffset(headerBlocks(keySize)));
+        header = {0, headerBlocks(keySize)};
+        values.clear();
+        return bufferPool().writeBytes(path, 0, blocks.data(), blocks.size(), true) && writeHeader();
+    }
+
+    bool open() {
+        if (!bufferPool().readBytes(path, 0, reinterpret_cast<char *>(&header), sizeof(header))) {
+            cerr << "Error: Failed to read bitmap index " << path << endl;
+            return false;
+        }
+        string keys(size_t(header.valueCount) * keySize, '\0');
+        if (!keys.empty() && !bufferPool().readBytes(path, keysOffset(), keys.data(), keys.size())) {
+            return false;
+        }
+        for (uint32_t value = 0; value < header.valueCount; value++) {
+            values.emplace(keys.substr(size_t(value) * keySize, keySize), value);
+        }
+        return true;
+    }
+
+    // Number of the value stored in `key` (column width, normalized), -1 if
+    // the index doesn't hold it
+    int find(const string &key) const {
+        const auto it = values.find(key);
+        return it == values.end() ? -1 : it->second;
+    }
+
+    // Like find, but a new value gets the next number. -1 if there's no room
+    // for one or it can't be written.
+    int findOrAdd(const string &key) {
+        const int known = find(key);
+        if (known != -1 || header.valueCount == bitmapMaxValues) {
+            return known;
+        }
+        const uint32_t value = header.valueCount++;
+        if (!bufferPool().writeBytes(path, keysOffset() + uint64_t(value) * keySize, key.data(), keySize) ||
+            !writeHeader()) {
+            return -1;
+        }
+        values.emplace(key, value);
+        return value;
+    }
+
+    // Directory entries of a value for the chunks [0, chunkCount)
+    bool readRefs(int value, uint64_t chunkCount, vector<ContainerRef> &refs) {
+        refs.assign(chunkCount, {0, 0});
+        for (uint64_t first = 0; first < chunkCount; first += directoryChunks) {
+            uint32_t directory;
+            if (!readDirectory(value, first / directoryChunks, directory)) {
+                return false;
+            }
+            const size_t count = min<uint64_t>(chunkCount - first, directoryChunks);
+            if (directory != 0 &&
+                !bufferPool().readBytes(path, blockOffset(directory), reinterpret_cast<char *>(&refs[first]),
+                                        count * sizeof(ContainerRef))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // OR the IDs of a container into a chunk bitmap
+    bool orInto(const ContainerRef &ref, uint64_t *words) {
+        if (ref.count <= arrayMaxIds) {
+            array.resize(ref.count);
+            if (!bufferPool().readBytes(path, blockOffset(ref.block), reinterpret_cast<char *>(array.data()),
+                                        ref.count * sizeof(uint16_t))) {
+                return false;
+            }
+            for (const uint16_t low: array) {
+                words[low / 64] |= uint64_t(1) << (low % 64);
+            }
+            return true;
+        }
+        bits.resize(containerWords);
+        if (!bufferPool().readBytes(path, blockOffset(ref.block), reinterpret_cast<char *>(bits.data()),
+                                    bitmapBlockBytes)) {
+            return false;
+        }
+        orBitmaps(words, bits.data(), containerWords);
+        return true;
+    }
+
+    // Add sorted, distinct low bits of IDs in `chunk` to the value's container
+    bool addToContainer(int value, uint64_t chunk, const vector<uint16_t> &lows) {
+        uint64_t refOffset;
+        ContainerRef ref;
+        if (!readRef(value, chunk, true, refOffset, ref)) {
+            return false;
+        }
+        if (ref.block == 0 && !allocateBlock(ref.block)) {
+            return false;
+        }
+        const uint64_t base = blockOffset(ref.block);
+
+        if (ref.count > arrayMaxIds) {
+            // Bitmap: set the bits, write back the words that hold them
+            const size_t firstWord = lows.front() / 64, lastWord = lows.back() / 64;
+            bits.resize(lastWord - firstWord + 1);
+            const uint64_t offset = base + firstWord * sizeof(uint64_t);
+            char *span = reinterpret_cast<char *>(bits.data());
+            if (!bufferPool().readBytes(path, offset, span, bits.size() * sizeof(uint64_t))) {
+                return false;
+            }
+            for (const uint16_t low: lows) {
+                uint64_t &word = bits[low / 64 - firstWord];
+                ref.count += !(word >> (low % 64) & 1);
+                word |= uint64_t(1) << (low % 64);
+            }
+            if (!bufferPool().writeBytes(path, offset, span, bits.size() * sizeof(uint64_t))) {
+                return false;
+            }
+            return writeRef(refOffset, ref);
+        }
+
+        array.resize(ref.count);
+        if (ref.count > 0 && !bufferPool().readBytes(path, base, reinterpret_cast<char *>(array.data()),
+                                                     ref.count * sizeof(uint16_t))) {
+            return false;
+        }
+        vector<uint16_t> merged;
+        merged.reserve(array.size() + lows.size());
+        set_union(array.begin(), array.end(), lows.begin(), lows.end(), back_inserter(merged));
+        ref.count = merged.size();
+
+        bool written;
+        if (merged.size() > arrayMaxIds) {
+            // Too many for an array, the container becomes a bitmap
+            bits.assign(containerWords, 0);
+            for (const uint16_t low: merged) {
+                bits[low / 64] |= uint64_t(1) << (low % 64);
+            }
+            written = bufferPool().writeBytes(path, base, reinterpret_cast<const char *>(bits.data()),
+                                              bitmapBlockBytes);
+        } else {
+            // Only the entries from the first new one on move, appended IDs write just themselves
+            const size_t first = lower_bound(array.begin(), array.end(), lows.front()) - array.begin();
+            written = bufferPool().writeBytes(path, base + first * sizeof(uint16_t),
+                                              reinterpret_cast<const char *>(merged.data() + first),
+                                              (merged.size() - first) * sizeof(uint16_t));
+        }
+        return written && writeRef(refOffset, ref);
+    }
+
+    bool removeFromContainer(int value, uint64_t chunk, uint16_t low) {
+        uint64_t refOffset;
+        ContainerRef ref;
+        if (!readRef(value, chunk, false, refOffset, ref)) {
+            return false;
+        }
+        if (ref.count == 0) {
+            return false;
+        }
+        const uint64_t base = blockOffset(ref.block);
+
+        if (ref.count > arrayMaxIds + 1) {
+            const uint64_t offset = base + low / 64 * sizeof(uint64_t);
+            uint64_t word;
+            if (!bufferPool().readBytes(path, offset, reinterpret_cast<char *>(&word), sizeof(word)) ||
+                !(word >> (low % 64) & 1)) {
+                return false;
+            }
+            word &= ~(uint64_t(1) << (low % 64));
+            ref.count--;
+            return bufferPool().writeBytes(path, offset, reinterpret_cast<const char *>(&word), sizeof(word)) &&
+                   writeRef(refOffset, ref);
+        }
+
+        if (ref.count > arrayMaxIds) {
+            // Down to an array's worth, the bitmap becomes an array again
+            bits.resize(containerWords);
+            if (!bufferPool().readBytes(path, base, reinterpret_cast<char *>(bits.data()), bitmapBlockBytes)) {
+                return false;
+            }
+            array.clear();
+            for (size_t word = 0; word < containerWords; word++) {
+                for (uint64_t set = bits[word]; set; set &= set - 1) {
+                    array.push_back(word * 64 + __builtin_ctzll(set));
+                }
+            }
+        } else {
+            array.resize(ref.count);
+            if (!bufferPool().readBytes(path, base, reinterpret_cast<char *>(array.data()),
+                                        ref.count * sizeof(uint16_t))) {
+                return false;
+            }
+        }
+
+        const auto it = lower_bound(array.begin(), array.end(), low);
+        if (it == array.end() || *it != low) {
+            return false;
+        }
+        const size_t first = ref.count > arrayMaxIds ? 0 : it - array.begin();
+        array.erase(it);
+        ref.count--;
+        return (first == array.size() ||
+                bufferPool().writeBytes(path, base + first * sizeof(uint16_t),
+                                        reinterpret_cast<const char *>(array.data() + first),
+                                        (array.size() - first) * sizeof(uint16_t))) &&
+               writeRef(refOffset, ref);
+    }
+
+private:
+    bool writeHeader() {
+        return bufferPool().writeBytes(path, 0, reinterpret_cast<const char *>(&header), sizeof(header));
+    }
+
+    // Blocks are handed out zeroed and never freed; an emptied container keeps its block
+    bool allocateBlock(uint32_t &block) {
+        const vector<char> zeros(bitmapBlockBytes);
+        block = header.blockCount++;
+        return bufferPool().writeBytes(path, blockOffset(block), zeros.data(), zeros.size(), true) && writeHeader();
+    }
+
+    uint64_t directorySlot(int value, uint64_t directory) const {
+        return directoriesOffset(keySize) + (uint64_t(value) * valueDirectories + directory) * sizeof(uint32_t);
+    }
+
+    bool readDirectory(int value, uint64_t directory, uint32_t &block) {
+        return bufferPool().readBytes(path, directorySlot(value, directory), reinterpret_cast<char *>(&block),
+                                      sizeof(block));
+    }
+
+    // Where the value's entry for `chunk` is and what it holds. With
+    // `allocate`, a missing directory block is added.
+    bool readRef(int value, uint64_t chunk, bool allocate, uint64_t &refOffset, ContainerRef &ref) {
+        uint32_t directory;
+        if (!readDirectory(value, chunk / directoryChunks, directory)) {
+            return false;
+        }
+        if (directory == 0) {
+            if (!allocate) {
+                ref = {0, 0};
+                return false;
+            }
+            if (!allocateBlock(directory) ||
+                !bufferPool().writeBytes(path, directorySlot(value, chunk / directoryChunks),
+                                         reinterpret_cast<const char *>(&directory), sizeof(directory))) {
+                return false;
+            }
+        }
+        refOffset = blockOffset(directory) + chunk % directoryChunks * sizeof(ContainerRef);
+        return bufferPool().readBytes(path, refOffset, reinterpret_cast<char *>(&ref), sizeof(ref));
+    }
+
+    bool writeRef(uint64_t refOffset, const ContainerRef &ref) {
+        return bufferPool().writeBytes(path, refOffset, reinterpret_cast<const char *>(&ref), sizeof(ref));
+    }
+
+    string path;
+    int keySize;
+    BitmapHeader header{};
+    unordered_map<string, int> values;
+
+    // Scratch space of the container being read or changed
+    vector<uint16_t> array;
+    vector<uint64_t> bits;
+};
+
+// The column value of a record as a normalized key
+static string recordKey(const TableInfo &table, int column, const char *record) {
+    string key(record + table.columnOffsets[column], table.columns[column].size);
+    normalizeKey(table.columnTypes[column], key.data());
+    return key;
+}
+
+// Add IDs, sorted ascending, to one value's bitmap, a container at a time
+static bool addIds(BitmapFile &file, int value, const vector<int> &ids) {
+    vector<uint16_t> lows;
+    for (size_t first = 0; first < ids.size();) {
+        const uint64_t chunk = uint64_t(ids[first]) >> chunkBits;
+        lows.clear();
+        size_t last = first;
+        for (; last < ids.size() && uint64_t(ids[last]) >> chunkBits == chunk; last++) {
+            lows.push_back(static_cast<uint16_t>(ids[last]));
+        }
+        if (!file.addToContainer(value, chunk, lows)) {
+            return false;
+        }
+        first = last;
+    }
+    return true;
+}
+
+// ==================== Index Registry ====================
+
+vector<string> readBitmapList(const string &tableName) {
+    vector<string> columns;
+    ifstream file(dataPath + tableName + bitmapListFileType);
+    string line;
+    while (getline(file, line)) {
+        if (!line.empty()) columns.push_back(line);
+    }
+    return columns;
+}
+
+static bool writeBitmapList(const string &tableName, const vector<string> &columns) {
+    const string listPath = dataPath + tableName + bitmapListFileType;
+    if (columns.empty()) {
+        remove(listPath.c_str());
+        return true;
+    }
+
+    ofstream file(listPath, ios::trunc);
+    if (!file) {
+        cerr << "Error writing bitmap index list: " << listPath << endl;
+        return false;
+    }
+    for (const auto &column: columns) {
+        file << column << "\n";
+    }
+    return true;
+}
+
+// ==================== DDL ====================
+
+// The bitmaps of a column, built from one pass over its records
+static bool buildBitmapIndex(const TableInfo &table, int column) {
+    BitmapFile file(table, column);
+    if (!file.create()) {
+        return false;
+    }
+
+    vector<vector<int>> idsByValue;
+    const int idOffset = table.columnOffsets[table.columnIndex(ID_COLUMN)];
+    {
+        shared_lock<shared_mutex> reading(catalog().swapLatch());
+        TableScanIterator scan(table.name, table.recordSize, table.header.freeOffset);
+        scan.readColumns(table, withIdColumn(table, {column}));
+        while (const char *record = scan.next()) {
+            int id;
+            memcpy(&id, record + idOffset, sizeof(int));
+            if (id == tombstoneId) continue;
+            const int value = file.findOrAdd(recordKey(table, column, record));
+            if (value == -1) {
+                cerr << "Error: " << table.columns[column].name << " has more than " << bitmapMaxValues
+                     << " distinct values, too many for a bitmap index" << endl;
+                return false;
+            }
+            idsByValue.resize(max<size_t>(idsByValue.size(), value + 1));
+            idsByValue[value].push_back(id);
+        }
+        if (scan.failed()) {
+            return false;
+        }
+    }
+
+    // Reused slots hold newer IDs than the records after them
+    for (size_t value = 0; value < idsByValue.size(); value++) {
+        sort(idsByValue[value].begin(), idsByValue[value].end());
+        if (!addIds(file, value, idsByValue[value])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool createBitmapIndex(const string &tableName, const string &columnName) {
+    // Writers wait, so no record can miss the index between the build and
+    // the registration
+    lock_guard<mutex> writing(wal().writerLatch());
+    shared_ptr<const TableInfo> table = catalog().getTable(tableName);
+    if (!table) {
+        cerr << "Error: Table " << tableName << " not found" << endl;
+        return false;
+    }
+
+    const int column = table->columnIndex(columnName);
+    if (column == -1) {
+        cerr << "Error: Column '" << columnName << "' not found in " << tableName << endl;
+        return false;
+    }
+    if (columnName == ID_COLUMN) {
+        cerr << "Error: " << ID_COLUMN << " is already indexed by the ID index" << endl;
+        return false;
+    }
+    vector<string> columns = readBitmapList(tableName);
+    if (find(columns.begin(), columns.end(), columnName) != columns.end()) {
+        cerr << "Error: " << tableName << "(" << columnName << ") already has a bitmap index" << endl;
+        return false;
+    }
+
+    // Index DDL isn't logged: start from an empty log, checkpoint the new bitmaps
+    const string filePath = bitmapFilePath(tableName, columnName);
+    if (!wal().checkpointLocked() || !buildBitmapIndex(*table, column) || !wal().checkpointLocked()) {
+        cerr << "Error: Failed to build the bitmap index on " << columnName << endl;
+        bufferPool().dropFile(filePath);
+        remove(filePath.c_str());
+        return false;
+    }
+
+    columns.push_back(columnName);
+    if (!writeBitmapList(tableName, columns)) {
+        return false;
+    }
+    catalog().invalidate(tableName);
+    return true;
+}
+
+bool dropBitmapIndex(const string &tableName, const string &columnName) {
+    lock_guard<mutex> writing(wal().writerLatch());
+    vector<string> columns = readBitmapList(tableName);
+    const auto it = find(columns.begin(), columns.end(), columnName);
+    if (it == columns.end()) {
+        cerr << "Error: " << tableName << "(" << columnName << ") has no bitmap index" << endl;
+        return false;
+    }
+
+    // The log may still hold writes to the bitmaps, retire them first
+    if (!wal().checkpointLocked()) {
+        return false;
+    }
+    columns.erase(it);
+    if (!writeBitmapList(tableName, columns)) {
+        return false;
+    }
+
+    const string filePath = bitmapFilePath(tableName, columnName);
+    bufferPool().dropFile(filePath);
+    remove(filePath.c_str());
+    catalog().invalidate(tableName);
+    return true;
+}
+
+void dropAllBitmapIndexes(const string &tableName) {
+    for (const auto &column: readBitmapList(tableName)) {
+        const string filePath = bitmapFilePath(tableName, column);
+        bufferPool().dropFile(filePath);
+        remove(filePath.c_str());
+    }
+    writeBitmapList(tableName, {});
+}
+
+// ==================== Maintenance ====================
+
+bool bitmapInsertRecords(const TableInfo &table, const char *records, size_t count, int firstId) {
+    for (const int column: table.bitmapColumns) {
+        BitmapFile file(table, column);
+        if (!file.open()) {
+            return false;
+        }
+
+        // The batch's IDs ascend, so each value's share of them does too
+        vector<vector<int>> idsByValue;
+        for (size_t i = 0; i < count; i++) {
+            const int value = file.findOrAdd(recordKey(table, column, records + i * table.recordSize));
+            if (value == -1) {
+                cerr << "Error: " << table.columns[column].name << " has more than " << bitmapMaxValues
+                     << " distinct values, too many for its bitmap index" << endl;
+                return false;
+            }
+            idsByValue.resize(max<size_t>(idsByValue.size(), value + 1));
+            idsByValue[value].push_back(firstId + static_cast<int>(i));
+        }
+        for (size_t value = 0; value < idsByValue.size(); value++) {
+            if (!idsByValue[value].empty() && !addIds(file, value, idsByValue[value])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool bitmapRemoveRecord(const TableInfo &table, const char *record, int id) {
+    for (const int column: table.bitmapColumns) {
+        BitmapFile file(table, column);
+        if (!file.open()) {
+            return false;
+        }
+        const int value = file.find(recordKey(table, column, record));
+        if (value == -1 || !file.removeFromContainer(value, uint64_t(id) >> chunkBits, static_cast<uint16_t>(id))) {
+            cerr << "Error: Failed to update the bitmap index on " << table.columns[column].name << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// ==================== Lookup ====================
+
+bool bitmapCheckable(const TableInfo &table, const CompiledPredicate &predicate) {
+    const auto &columns = table.bitmapColumns;
+    return find(columns.begin(), columns.end(), predicate.columnIndex) != columns.end() &&
+           (predicate.isInList() || predicate.op == CompareOp::Equal);
+}
+
+// One predicate's values and their directory entries for every chunk
+struct BitmapTerm {
+    unique_ptr<BitmapFile> file;
+    vector<vector<ContainerRef>> refs; // per value the predicate names
+    uint64_t ids = 0;                  // how many IDs they hold together
+};
+
+bool bitmapMatches(const TableInfo &table, const vector<const CompiledPredicate *> &predicates, vector<int> &ids) {
+    ids.clear();
+    const uint64_t chunkCount = (table.header.nextRecordId + chunkIds - 1) / chunkIds;
+    vector<BitmapTerm> terms(predicates.size());
+    for (size_t i = 0; i < predicates.size(); i++) {
+        const CompiledPredicate &predicate = *predicates[i];
+        BitmapTerm &term = terms[i];
+        term.file = make_unique<BitmapFile>(table, predicate.columnIndex);
+        if (!term.file->open()) {
+            return false;
+        }
+
+        // A value the index doesn't hold, or an operand no key stands for, matches nothing
+        vector<int> values;
+        for (const auto &alternative: predicate.isInList() ? predicate.anyOf : vector{predicate}) {
+            optional<string> key = predicateKey(table, alternative);
+            if (!key) continue;
+            normalizeKey(predicate.type, key->data());
+            const int value = term.file->find(*key);
+            if (value != -1 && find(values.begin(), values.end(), value) == values.end()) {
+                values.push_back(value);
+            }
+        }
+        for (const int value: values) {
+            term.refs.emplace_back();
+            if (!term.file->readRefs(value, chunkCount, term.refs.back())) {
+                return false;
+            }
+            for (const auto &ref: term.refs.back()) {
+                term.ids += ref.count;
+            }
+        }
+        if (term.ids == 0) {
+            return true;
+        }
+    }
+
+    // The term with the fewest IDs first, so the AND empties a chunk soonest
+    sort(terms.begin(), terms.end(), [](const BitmapTerm &a, const BitmapTerm &b) { return a.ids < b.ids; });
+
+    vector<uint64_t> matches(containerWords), term(containerWords);
+    for (uint64_t chunk = 0; chunk < chunkCount; chunk++) {
+        bool any = true;
+        for (size_t i = 0; any && i < terms.size(); i++) {
+            // OR the containers of the term's values, then AND the result in
+            uint64_t *words = i == 0 ? matches.data() : term.data();
+            fill_n(words, containerWords, 0);
+            any = false;
+            for (const auto &refs: terms[i].refs) {
+                if (refs[chunk].count == 0) continue;
+                if (!terms[i].file->orInto(refs[chunk], words)) {
+                    return false;
+                }
+                any = true;
+            }
+            if (any && i > 0) {
+                any = andBitmaps(matches.data(), term.data(), containerWords);
+            }
+        }
+        if (!any) {
+            continue;
+        }
+
+        for (size_t word = 0; word < containerWords; word++) {
+            for (uint64_t bits = matches[word]; bits; bits &= bits - 1) {
+                ids.push_back(static_cast<int>(chunk << chunkBits | (word * 64 + __builtin_ctzll(bits))));
+            }
+        }
+    }
+    return true;
+}
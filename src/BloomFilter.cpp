@@ -0,0 +1,249 @@
+#include "../include/BloomFilter.h"
+#include "../include/BufferPool.h"
+#include "../include/Columnar.h"
+#include "../include/TableScan.h"
+#include "../include/WAL.h"
+#include "../include/ZoneMap.h"
+
+using namespace std;
+
+string bloomFilePath(const string &dataFilePath, const string &columnName) {
+    return companionFilePath(dataFilePath, "." + columnName + bloomFileType);
+}
+
+// ==================== Filter Blocks ====================
+
+constexpr size_t bloomBlockWords = 8;
+constexpr size_t bloomBlockBytes = bloomBlockWords * sizeof(uint32_t);
+constexpr size_t bloomZoneBlocks = bloomZoneBytes / bloomBlockBytes;
+
+// One odd multiplier per word; each picks the bit a value sets in that word
+constexpr uint32_t bloomSalts[bloomBlockWords] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                                  0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+// Stored in the filter files, so it must not change between builds
+static uint64_t hashValue(string_view value) {
+    uint64_t hash = 14695981039346656037ULL; // FNV-1a
+    for (const unsigned char c: value) {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+    hash ^= hash >> 33; // spread the low bits over the whole word
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    return hash ^ (hash >> 33);
+}
+
+// The block of a zone's filter a value goes into, and the bit of each word
+static size_t blockOf(uint64_t hash) {
+    return ((hash >> 32) * bloomZoneBlocks) >> 32;
+}
+
+static uint32_t bitOf(uint64_t hash, size_t word) {
+    return 1U << ((static_cast<uint32_t>(hash) * bloomSalts[word]) >> 27);
+}
+
+static size_t addValue(char *zoneFilter, string_view value) {
+    const uint64_t hash = hashValue(value);
+    const size_t block = blockOf(hash);
+    uint32_t words[bloomBlockWords];
+    char *bytes = zoneFilter + block * bloomBlockBytes;
+    memcpy(words, bytes, bloomBlockBytes);
+    for (size_t word = 0; word < bloomBlockWords; word++) {
+        words[word] |= bitOf(hash, word);
+    }
+    memcpy(bytes, words, bloomBlockBytes);
+    return block;
+}
+
+bool bloomMayContain(const char *zoneFilter, string_view value) {
+    const uint64_t hash = hashValue(value);
+    uint32_t words[bloomBlockWords];
+    memcpy(words, zoneFilter + blockOf(hash) * bloomBlockBytes, bloomBlockBytes);
+    uint32_t missing = 0;
+    for (size_t word = 0; word < bloomBlockWords; word++) {
+        missing |= bitOf(hash, word) & ~words[word];
+    }
+    return missing == 0;
+}
+
+static string_view columnValue(const TableInfo &table, int column, const char *record) {
+    const char *value = record + table.columnOffsets[column];
+    return {value, strnlen(value, table.columns[column].size)};
+}
+
+bool updateBloomFilters(const TableInfo &table, const string &filePath, uint64_t firstSlot, const char *records,
+                        size_t count) {
+    vector<char> filter(bloomZoneBytes);
+    for (const int column: table.bloomColumns) {
+        const string bloomPath = bloomFilePath(filePath, table.columns[column].name);
+        const uint64_t fileBytes = bufferPool().fileSize(bloomPath);
+        for (uint64_t slot = firstSlot; slot < firstSlot + count;) {
+            const uint64_t zone = slot / zoneRecords;
+            const size_t run = min<uint64_t>(firstSlot + count - slot, zoneRecords - slot % zoneRecords);
+
+            // The file ends after the last block written; the rest is empty
+            fill(filter.begin(), filter.end(), 0);
+            const uint64_t start = zone * bloomZoneBytes;
+            const size_t stored = fileBytes > start ? min<uint64_t>(fileBytes - start, bloomZoneBytes) : 0;
+            if (stored > 0 && !bufferPool().readBytes(bloomPath, start, filter.data(), stored)) {
+                return false;
+            }
+
+            // Only the blocks that changed are written, a single INSERT logs 32 bytes
+            size_t firstBlock = bloomZoneBlocks, lastBlock = 0;
+            for (size_t i = 0; i < run; i++) {
+                const char *record = records + (slot - firstSlot + i) * table.recordSize;
+                const size_t block = addValue(filter.data(), columnValue(table, column, record));
+                firstBlock = min(firstBlock, block);
+                lastBlock = max(lastBlock, block);
+            }
+            if (!bufferPool().writeBytes(bloomPath, start + firstBlock * bloomBlockBytes,
+                                         filter.data() + firstBlock * bloomBlockBytes,
+                                         (lastBlock - firstBlock + 1) * bloomBlockBytes, true)) {
+                return false;
+            }
+            slot += run;
+        }
+    }
+    return true;
+}
+
+bool readBloomFilters(const TableInfo &table, int column, vector<char> &filters) {
+    const string bloomPath = bloomFilePath(dataPath + table.name + dataFileType, table.columns[column].name);
+    const uint64_t fileBytes = bufferPool().fileSize(bloomPath);
+    filters.assign((fileBytes + bloomZoneBytes - 1) / bloomZoneBytes * bloomZoneBytes, 0);
+    return fileBytes == 0 || bufferPool().readBytes(bloomPath, 0, filters.data(), fileBytes);
+}
+
+// ==================== Filter Registry ====================
+
+vector<string> readBloomList(const string &tableName) {
+    vector<string> columns;
+    ifstream file(dataPath + tableName + bloomListFileType);
+    string line;
+    while (getline(file, line)) {
+        if (!line.empty()) columns.push_back(line);
+    }
+    return columns;
+}
+
+static bool writeBloomList(const string &tableName, const vector<string> &columns) {
+    const string listPath = dataPath + tableName + bloomListFileType;
+    if (columns.empty()) {
+        remove(listPath.c_str());
+        return true;
+    }
+
+    ofstream file(listPath, ios::trunc);
+    if (!file) {
+        cerr << "Error writing Bloom filter list: " << listPath << endl;
+        return false;
+    }
+    for (const auto &column: columns) {
+        file << column << "\n";
+    }
+    return true;
+}
+
+// ==================== DDL ====================
+
+// Filters of every zone of a column, built in one pass over its records
+static bool buildBloomFilter(const TableInfo &table, int column, const string &bloomPath) {
+    const uint64_t zones = (table.header.slotCount + zoneRecords - 1) / zoneRecords;
+    vector<char> filters(zones * bloomZoneBytes);
+    const int idOffset = table.columnOffsets[table.columnIndex(ID_COLUMN)];
+    {
+        shared_lock<shared_mutex> reading(catalog().swapLatch());
+        TableScanIterator scan(table.name, table.recordSize, table.header.freeOffset);
+        scan.readColumns(table, withIdColumn(table, {column}));
+        while (const char *record = scan.next()) {
+            int id;
+            memcpy(&id, record + idOffset, sizeof(int));
+            if (id == tombstoneId) continue;
+            const uint64_t slot = (scan.recordOffset() - headerSize) / table.recordSize;
+            addValue(filters.data() + slot / zoneRecords * bloomZoneBytes, columnValue(table, column, record));
+        }
+        if (scan.failed()) {
+            return false;
+        }
+    }
+
+    bufferPool().dropFile(bloomPath);
+    remove(bloomPath.c_str());
+    return bufferPool().writeBytes(bloomPath, 0, filters.data(), filters.size(), true);
+}
+
+bool createBloomFilter(const string &tableName, const string &columnName) {
+    // Writers wait, so no record can miss the filter between the build and
+    // the registration
+    lock_guard<mutex> writing(wal().writerLatch());
+    shared_ptr<const TableInfo> table = catalog().getTable(tableName);
+    if (!table) {
+        cerr << "Error: Table " << tableName << " not found" << endl;
+        return false;
+    }
+
+    const int column = table->columnIndex(columnName);
+    if (column == -1) {
+        cerr << "Error: Column '" << columnName << "' not found in " << tableName << endl;
+        return false;
+    }
+    if (table->columnTypes[column] != ColumnType::String) {
+        cerr << "Error: Bloom filters are for string columns, " << columnName << " isn't one" << endl;
+        return false;
+    }
+    vector<string> columns = readBloomList(tableName);
+    if (find(columns.begin(), columns.end(), columnName) != columns.end()) {
+        cerr << "Error: " << tableName << "(" << columnName << ") already has a Bloom filter" << endl;
+        return false;
+    }
+
+    // Filter DDL isn't logged: start from an empty log, checkpoint the new filters
+    const string bloomPath = bloomFilePath(dataPath + tableName + dataFileType, columnName);
+    if (!wal().checkpointLocked() || !buildBloomFilter(*table, column, bloomPath) || !wal().checkpointLocked()) {
+        cerr << "Error: Failed to build the Bloom filter on " << columnName << endl;
+        return false;
+    }
+
+    columns.push_back(columnName);
+    if (!writeBloomList(tableName, columns)) {
+        return false;
+    }
+    catalog().invalidate(tableName);
+    return true;
+}
+
+bool dropBloomFilter(const string &tableName, const string &columnName) {
+    lock_guard<mutex> writing(wal().writerLatch());
+    vector<string> columns = readBloomList(tableName);
+    const auto it = find(columns.begin(), columns.end(), columnName);
+    if (it == columns.end()) {
+        cerr << "Error: " << tableName << "(" << columnName << ") has no Bloom filter" << endl;
+        return false;
+    }
+
+    // The log may still hold writes to the filters, retire them first
+    if (!wal().checkpointLocked()) {
+        return false;
+    }
+    columns.erase(it);
+    if (!writeBloomList(tableName, columns)) {
+        return false;
+    }
+
+    const string bloomPath = bloomFilePath(dataPath + tableName + dataFileType, columnName);
+    bufferPool().dropFile(bloomPath);
+    remove(bloomPath.c_str());
+    catalog().invalidate(tableName);
+    return true;
+}
+
+void dropAllBloomFilters(const string &tableName) {
+    for (const auto &column: readBloomList(tableName)) {
+        const string bloomPath = bloomFilePath(dataPath + tableName + dataFileType, column);
+        bufferPool().dropFile(bloomPath);
+        remove(bloomPath.c_str());
+    }
+    writeBloomList(tableName, {});
+}
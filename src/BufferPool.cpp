@@ -0,0 +1,524 @@
+#include "../include/BufferPool.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+// ==================== Construction ====================
+
+BufferPool::BufferPool(size_t numPages) {
+    numPages = max<size_t>(numPages, 1);
+    frames.resize(numPages);
+    memory.assign(numPages * PAGE_SIZE, 0);
+    for (size_t i = 0; i < numPages; i++) {
+        frames[i].data = memory.data() + i * PAGE_SIZE;
+    }
+}
+
+BufferPool::~BufferPool() {
+    flushAll();
+    for (auto &file: files) {
+        if (file.fd >= 0) {
+            close(file.fd);
+        }
+    }
+}
+
+size_t BufferPool::capacity() const {
+    lock_guard<mutex> guard(latch);
+    return frames.size();
+}
+
+size_t BufferPool::fileSlotCount() const {
+    lock_guard<mutex> guard(latch);
+    return files.size();
+}
+
+void BufferPool::resize(size_t numPages) {
+    lock_guard<mutex> guard(latch);
+    for (size_t fileId = 0; fileId < files.size(); fileId++) {
+        if (files[fileId].fd >= 0) {
+            flushFileLocked(fileId);
+        }
+    }
+    for (const auto &frame: frames) {
+        if (frame.pinCount > 0) {
+            cerr << "Error: Cannot resize buffer pool while pages are pinned" << endl;
+            return;
+        }
+    }
+
+    numPages = max<size_t>(numPages, 1);
+    pageTable.clear();
+    frames.assign(numPages, Frame{});
+    memory.assign(numPages * PAGE_SIZE, 0);
+    for (size_t i = 0; i < numPages; i++) {
+        frames[i].data = memory.data() + i * PAGE_SIZE;
+    }
+    clockHand = 0;
+}
+
+// ==================== File Table ====================
+
+int BufferPool::lookupFile(const string &filePath) const {
+    auto it = fileIds.find(filePath);
+    return it == fileIds.end() ? -1 : it->second;
+}
+
+int BufferPool::openFile(const string &filePath, bool create) {
+    int fileId = lookupFile(filePath);
+    if (fileId >= 0) {
+        return fileId;
+    }
+
+    int fd = open(filePath.c_str(), O_RDWR | (create ? O_CREAT : 0), 0644);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct stat st{};
+    fstat(fd, &st);
+
+    // Slots of dropped files are reused, so ids stay small enough for pageKey
+    if (!freeFileIds.empty()) {
+        fileId = freeFileIds.back();
+        freeFileIds.pop_back();
+        files[fileId] = {filePath, fd, static_cast<uint64_t>(st.st_size)};
+    } else {
+        files.push_back({filePath, fd, static_cast<uint64_t>(st.st_size)});
+        fileId = static_cast<int>(files.size() - 1);
+    }
+    fileIds[filePath] = fileId;
+    return fileId;
+}
+
+bool BufferPool::fileExists(const string &filePath) {
+    lock_guard<mutex> guard(latch);
+    return openFile(filePath, false) >= 0;
+}
+
+uint64_t BufferPool::fileSize(const string &filePath) {
+    lock_guard<mutex> guard(latch);
+    int fileId = openFile(filePath, false);
+    return fileId < 0 ? 0 : files[fileId].size;
+}
+
+vector<uint64_t> BufferPool::dirtyPages(const string &filePath, uint64_t offset, size_t length) {
+    lock_guard<mutex> guard(latch);
+    vector<uint64_t> pages;
+    const int fileId = lookupFile(filePath);
+    if (fileId < 0 || length == 0) {
+        return pages;
+    }
+    for (uint64_t pageNo = offset / PAGE_SIZE; pageNo <= (offset + length - 1) / PAGE_SIZE; pageNo++) {
+        auto it = pageTable.find(pageKey(fileId, pageNo));
+        if (it != pageTable.end() && frames[it->second].dirty) {
+            pages.push_back(pageNo);
+        }
+    }
+    return pages;
+}
+
+void BufferPool::dropFile(const string &filePath) {
+    lock_guard<mutex> guard(latch);
+    int fileId = lookupFile(filePath);
+    if (fileId < 0) {
+        return;
+    }
+
+    for (size_t i = 0; i < frames.size(); i++) {
+        Frame &frame = frames[i];
+        if (frame.fileId != fileId) continue;
+        if (frame.pinCount > 0) {
+            cerr << "Warning: Dropping pinned page " << frame.pageNo << " of " << filePath << endl;
+        }
+        pageTable.erase(pageKey(fileId, frame.pageNo));
+        frame = Frame{-1, 0, 0, false, false, frame.data, 0};
+    }
+
+    close(files[fileId].fd);
+    files[fileId].fd = -1;
+    fileIds.erase(filePath);
+    freeFileIds.push_back(fileId);
+}
+
+// ==================== Page Operations ====================
+
+int BufferPool::findVictim() {
+    // Two full sweeps are enough: the first one clears reference bits.
+    for (size_t step = 0; step < 2 * frames.size(); step++) {
+        size_t index = clockHand;
+        clockHand = (clockHand + 1) % frames.size();
+
+        Frame &frame = frames[index];
+        if (frame.fileId == -1) return static_cast<int>(index);
+        if (frame.pinCount > 0) continue;
+        if (frame.referenced) {
+            frame.referenced = false;
+            continue;
+        }
+        return static_cast<int>(index);
+    }
+    return -1;
+}
+
+bool BufferPool::writeBack(Frame &frame) {
+    // Write-ahead rule: the log record goes first
+    if (frame.lsn != 0 && logFlusher && !logFlusher(frame.lsn)) {
+        cerr << "Error: Page " << frame.pageNo << " of " << files[frame.fileId].path
+             << " waits for a log record that isn't durable" << endl;
+        return false;
+    }
+
+    const OpenFile &file = files[frame.fileId];
+    const uint64_t pageStart = frame.pageNo * PAGE_SIZE;
+    if (pageStart >= file.size) {
+        frame.dirty = false;
+        return true;
+    }
+
+    // Never write past the logical end so the file size stays exact on disk
+    const size_t length = min<uint64_t>(PAGE_SIZE, file.size - pageStart);
+    if (pwrite(file.fd, frame.data, length, pageStart) != static_cast<ssize_t>(length)) {
+        cerr << "Error: Failed to write page " << frame.pageNo << " of " << file.path << endl;
+        return false;
+    }
+
+    frame.dirty = false;
+    return true;
+}
+
+char *BufferPool::fetchPageLocked(int fileId, uint64_t pageNo) {
+    auto it = pageTable.find(pageKey(fileId, pageNo));
+    if (it != pageTable.end()) {
+        Frame &frame = frames[it->second];
+        frame.pinCount++;
+        frame.referenced = true;
+        hits++;
+        return frame.data;
+    }
+
+    misses++;
+    int victim = findVictim();
+    if (victim < 0) {
+        cerr << "Error: Buffer pool exhausted, every page is pinned" << endl;
+        return nullptr;
+    }
+
+    Frame &frame = frames[victim];
+    if (frame.fileId != -1) {
+        if (frame.dirty && !writeBack(frame)) {
+            return nullptr;
+        }
+        pageTable.erase(pageKey(frame.fileId, frame.pageNo));
+    }
+
+    ssize_t bytesRead = pread(files[fileId].fd, frame.data, PAGE_SIZE, pageNo * PAGE_SIZE);
+    if (bytesRead < 0) {
+        bytesRead = 0;
+    }
+    memset(frame.data + bytesRead, 0, PAGE_SIZE - bytesRead);
+
+    frame.fileId = fileId;
+    frame.pageNo = pageNo;
+    frame.pinCount = 1;
+    frame.dirty = false;
+    frame.referenced = true;
+    frame.lsn = 0;
+    pageTable[pageKey(fileId, pageNo)] = victim;
+    return frame.data;
+}
+
+void BufferPool::unpinPageLocked(int fileId, uint64_t pageNo, bool dirty) {
+    auto it = pageTable.find(pageKey(fileId, pageNo));
+    if (it == pageTable.end()) {
+        return;
+    }
+
+    Frame &frame = frames[it->second];
+    if (frame.pinCount > 0) {
+        frame.pinCount--;
+    }
+    frame.dirty = frame.dirty || dirty;
+}
+
+char *BufferPool::fetchPage(const string &filePath, uint64_t pageNo, bool create) {
+    lock_guard<mutex> guard(latch);
+    int fileId = openFile(filePath, create);
+    if (fileId < 0) {
+        return nullptr;
+    }
+    char *page = fetchPageLocked(fileId, pageNo);
+
+    // The statement being captured may change the page before unpinning it
+    if (page && capturing && this_thread::get_id() == captureOwner) {
+        keepBeforeImageLocked(fileId, pageNo, page);
+    }
+    return page;
+}
+
+void BufferPool::unpinPage(const string &filePath, uint64_t pageNo, bool dirty, size_t dirtyOffset,
+                           size_t dirtyLength) {
+    lock_guard<mutex> guard(latch);
+    int fileId = lookupFile(filePath);
+    if (fileId < 0) {
+        return;
+    }
+    if (dirty) {
+        // A page modified through the pin API becomes part of the file, whole
+        if (capturing) {
+            keepFileSizeLocked(fileId);
+        }
+        files[fileId].size = max(files[fileId].size, (pageNo + 1) * PAGE_SIZE);
+        if (capturing) {
+            captureLocked(fileId, pageNo, pageNo * PAGE_SIZE + dirtyOffset, dirtyLength);
+        }
+    }
+    unpinPageLocked(fileId, pageNo, dirty);
+}
+
+// ==================== Byte Range Operations ====================
+
+bool BufferPool::readBytes(const string &filePath, uint64_t offset, char *buffer, size_t length) {
+    lock_guard<mutex> guard(latch);
+    int fileId = openFile(filePath, false);
+    if (fileId < 0 || offset + length > files[fileId].size) {
+        return false;
+    }
+
+    while (length > 0) {
+        const uint64_t pageNo = offset / PAGE_SIZE;
+        const size_t pageOffset = offset % PAGE_SIZE;
+        const size_t chunk = min(length, PAGE_SIZE - pageOffset);
+
+        char *page = fetchPageLocked(fileId, pageNo);
+        if (!page) {
+            return false;
+        }
+        memcpy(buffer, page + pageOffset, chunk);
+        unpinPageLocked(fileId, pageNo, false);
+
+        buffer += chunk;
+        offset += chunk;
+        length -= chunk;
+    }
+    return true;
+}
+
+bool BufferPool::writeBytes(const string &filePath, uint64_t offset, const char *buffer, size_t length,
+                            bool create) {
+    lock_guard<mutex> guard(latch);
+    int fileId = openFile(filePath, create);
+    if (fileId < 0) {
+        return false;
+    }
+
+    if (capturing) {
+        keepFileSizeLocked(fileId);
+    }
+    files[fileId].size = max(files[fileId].size, offset + length);
+
+    while (length > 0) {
+        const uint64_t pageNo = offset / PAGE_SIZE;
+        const size_t pageOffset = offset % PAGE_SIZE;
+        const size_t chunk = min(length, PAGE_SIZE - pageOffset);
+
+        char *page = fetchPageLocked(fileId, pageNo);
+        if (!page) {
+            return false;
+        }
+        if (capturing) {
+            keepBeforeImageLocked(fileId, pageNo, page);
+        }
+        memcpy(page + pageOffset, buffer, chunk);
+        if (capturing) {
+            captureLocked(fileId, pageNo, offset, chunk);
+        }
+        unpinPageLocked(fileId, pageNo, true);
+
+        buffer += chunk;
+        offset += chunk;
+        length -= chunk;
+    }
+    return true;
+}
+
+// ==================== Write Back ====================
+
+bool BufferPool::flushFileLocked(int fileId) {
+    bool success = true;
+    for (auto &frame: frames) {
+        if (frame.fileId == fileId && frame.dirty) {
+            success = writeBack(frame) && success;
+        }
+    }
+    return success;
+}
+
+bool BufferPool::flushFile(const string &filePath) {
+    lock_guard<mutex> guard(latch);
+    int fileId = lookupFile(filePath);
+    return fileId < 0 || flushFileLocked(fileId);
+}
+
+bool BufferPool::flushAll() {
+    lock_guard<mutex> guard(latch);
+    bool success = true;
+    for (auto &frame: frames) {
+        if (frame.fileId != -1 && frame.dirty) {
+            success = writeBack(frame) && success;
+        }
+    }
+    return success;
+}
+
+bool BufferPool::syncAll() {
+    lock_guard<mutex> guard(latch);
+    bool success = true;
+    for (const auto &file: files) {
+        if (file.fd >= 0 && fdatasync(file.fd) != 0) {
+            cerr << "Error: Failed to sync " << file.path << endl;
+            success = false;
+        }
+    }
+    return success;
+}
+
+// ==================== Write Capture ====================
+
+void BufferPool::captureLocked(int fileId, uint64_t pageNo, uint64_t offset, size_t length) {
+    capturedRanges.push_back({fileId, {offset, length}});
+    if (capturedPages.insert(pageKey(fileId, pageNo)).second) {
+        frames[pageTable[pageKey(fileId, pageNo)]].pinCount++; // held until releaseCapture
+    }
+}
+
+void BufferPool::keepBeforeImageLocked(int fileId, uint64_t pageNo, const char *page) {
+    const uint64_t key = pageKey(fileId, pageNo);
+    if (beforeImages.count(key)) {
+        return;
+    }
+    const Frame &frame = frames[pageTable[key]];
+    beforeImages[key] = {vector<char>(page, page + PAGE_SIZE), frame.dirty, frame.lsn};
+}
+
+void BufferPool::keepFileSizeLocked(int fileId) {
+    capturedSizes.emplace(fileId, files[fileId].size);
+}
+
+void BufferPool::beginCapture() {
+    lock_guard<mutex> guard(latch);
+    capturing = true;
+    captureOwner = this_thread::get_id();
+    capturedRanges.clear();
+    capturedPages.clear();
+    beforeImages.clear();
+    capturedSizes.clear();
+}
+
+vector<WriteRange> BufferPool::endCapture() {
+    lock_guard<mutex> guard(latch);
+    capturing = false;
+
+    // Coalesce overlapping and adjacent ranges of the same file
+    sort(capturedRanges.begin(), capturedRanges.end());
+    vector<WriteRange> ranges;
+    for (const auto &[fileId, range]: capturedRanges) {
+        const auto [offset, length] = range;
+        if (!ranges.empty() && ranges.back().filePath == files[fileId].path &&
+            offset <= ranges.back().offset + ranges.back().length) {
+            WriteRange &last = ranges.back();
+            last.length = max(last.offset + last.length, offset + length) - last.offset;
+            continue;
+        }
+        ranges.push_back({files[fileId].path, offset, length});
+    }
+    capturedRanges.clear();
+    return ranges;
+}
+
+void BufferPool::releaseCapture(uint64_t lsn) {
+    lock_guard<mutex> guard(latch);
+    for (uint64_t key: capturedPages) {
+        auto it = pageTable.find(key);
+        if (it == pageTable.end()) continue;
+        Frame &frame = frames[it->second];
+        frame.lsn = max(frame.lsn, lsn);
+        if (frame.pinCount > 0) {
+            frame.pinCount--;
+        }
+    }
+    capturedPages.clear();
+    beforeImages.clear();
+    capturedSizes.clear();
+}
+
+void BufferPool::abortCapture() {
+    lock_guard<mutex> guard(latch);
+    capturing = false;
+    capturedRanges.clear();
+
+    // Captured pages are pinned, so they are all still cached as changed
+    for (uint64_t key: capturedPages) {
+        auto it = pageTable.find(key);
+        auto image = beforeImages.find(key);
+        if (it == pageTable.end()) continue;
+        Frame &frame = frames[it->second];
+        if (image != beforeImages.end()) {
+            memcpy(frame.data, image->second.data.data(), PAGE_SIZE);
+            frame.dirty = image->second.dirty;
+            frame.lsn = image->second.lsn;
+        }
+        if (frame.pinCount > 0) {
+            frame.pinCount--;
+        }
+    }
+    for (const auto &[fileId, size]: capturedSizes) {
+        files[fileId].size = size;
+    }
+    capturedPages.clear();
+    beforeImages.clear();
+    capturedSizes.clear();
+}
+
+bool BufferPool::writeBackRanges(const vector<WriteRange> &ranges) {
+    lock_guard<mutex> guard(latch);
+    bool success = true;
+    for (const auto &range: ranges) {
+        const int fileId = lookupFile(range.filePath);
+        if (fileId < 0 || range.length == 0) continue;
+
+        const uint64_t lastPage = (range.offset + range.length - 1) / PAGE_SIZE;
+        for (uint64_t pageNo = range.offset / PAGE_SIZE; pageNo <= lastPage; pageNo++) {
+            const uint64_t key = pageKey(fileId, pageNo);
+            auto it = pageTable.find(key);
+            if (it == pageTable.end() || capturedPages.count(key)) continue;
+            Frame &frame = frames[it->second];
+            if (frame.dirty) {
+                success = writeBack(frame) && success;
+            }
+        }
+    }
+    return success;
+}
+
+void BufferPool::setLogFlusher(function<bool(uint64_t lsn)> flusher) {
+    lock_guard<mutex> guard(latch);
+    logFlusher = move(flusher);
+}
+
+BufferPool &bufferPool() {
+    static BufferPool pool([] {
+        size_t megabytes = defaultBufferPoolMB;
+        if (const char *value = getenv(bufferPoolSizeEnv.c_str())) {
+            try {
+                megabytes = max<size_t>(stoul(value), 1);
+            } catch (const exception &) {
+                cerr << "Warning: Invalid " << bufferPoolSizeEnv << ", using " << defaultBufferPoolMB << " MB" << endl;
+            }
+        }
+        return megabytes * 1024 * 1024 / PAGE_SIZE;
+    }());
+    return pool;
+}
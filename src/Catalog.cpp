@@ -0,0 +1,241 @@
+#include "../include/Catalog.h"
+#include "../include/BitmapIndex.h"
+#include "../include/BloomFilter.h"
+#include "../include/BufferPool.h"
+#include "../include/SecondaryIndex.h"
+#include "../include/TableScan.h"
+#include "../include/Vacuum.h"
+
+using namespace std;
+
+int TableInfo::columnIndex(const string &columnName) const {
+    for (size_t i = 0; i < columns.size(); i++) {
+        if (columns[i].name == columnName) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+const IndexInfo *TableInfo::indexOn(int column) const {
+    for (const auto &index: indexes) {
+        if (index.columnIndex == column) {
+            return &index;
+        }
+    }
+    return nullptr;
+}
+
+// Header layout before SDB2, with 32-bit counts and offset. DB01 (and the
+// SDB1 default) only had the first three fields, DB02 added slotCount and
+// freeSlots, DB03 nextRecordId; unused fields are zero.
+struct LegacyDBHeader {
+    char magic[4];
+    int32_t numRecords;
+    uint32_t freeOffset;
+    int32_t slotCount;
+    int32_t freeSlots;
+    int32_t nextRecordId;
+    char reserved[36];
+};
+static_assert(sizeof(LegacyDBHeader) == headerSize, "legacy headers are 60 bytes too");
+
+// Bring a table written by an older version to the current header format.
+// The new map and header are flushed before the .idx file goes, so a crash
+// part way just repeats the upgrade.
+static bool upgradeTable(TableInfo &table) {
+    DBHeader &header = table.header;
+    if (memcmp(header.magic, currentHeaderMagic, 4) == 0) {
+        return true;
+    }
+
+    const string filePath = dataPath + table.name + dataFileType;
+    const string mapPath = dataPath + table.name + idMapFileType;
+    const string indexPath = dataPath + table.name + indexFileType;
+
+    LegacyDBHeader legacy;
+    memcpy(&legacy, &header, sizeof(legacy));
+    const bool slotted = memcmp(legacy.magic, "DB02", 4) == 0 || memcmp(legacy.magic, "DB03", 4) == 0;
+    const bool mapped = memcmp(legacy.magic, "DB03", 4) == 0;
+
+    header = DBHeader{};
+    header.numRecords = legacy.numRecords;
+    header.freeOffset = legacy.freeOffset;
+    header.slotCount = legacy.slotCount;
+    header.freeSlots = legacy.freeSlots;
+    header.nextRecordId = legacy.nextRecordId;
+
+    // Before DB02, deletes swap-removed records, so the records are packed:
+    // every slot is live and nothing past them is
+    if (!slotted) {
+        header.slotCount = header.numRecords;
+        header.freeSlots = 0;
+        header.freeOffset = min(header.freeOffset, slotOffset(header.numRecords, table.recordSize));
+    }
+
+    // Before DB03 there was no ID map. Records keep the ID stored in them: a
+    // DB01 delete moved the last record into the freed slot, so IDs aren't
+    // slot numbers there.
+    if (!mapped) {
+        const int idOffset = table.columnOffsets[table.columnIndex(ID_COLUMN)];
+        vector<int> slots; // ID -> slot
+        vector<int> renumbered;
+        int slot = 0;
+        TableScanIterator scan(table.name, table.recordSize, slotOffset(header.slotCount, table.recordSize));
+        while (const char *record = scan.next()) {
+            int id;
+            memcpy(&id, record + idOffset, sizeof(int));
+            if (id >= 0 && static_cast<size_t>(id) >= slots.size()) {
+                slots.resize(id + 1, noSlot);
+            }
+            if (id >= 0 && slots[id] == noSlot) {
+                slots[id] = slot;
+            } else if (id != tombstoneId) {
+                renumbered.push_back(slot);
+            }
+            slot++;
+        }
+        if (scan.failed() || static_cast<uint64_t>(slot) != header.slotCount) {
+            return false;
+        }
+
+        // A DB01 insert after a delete could hand out an ID that was still in
+        // use; the later record gets a fresh one
+        for (const int duplicate: renumbered) {
+            const int id = static_cast<int>(slots.size());
+            slots.push_back(duplicate);
+            if (!bufferPool().writeBytes(filePath, slotOffset(duplicate, table.recordSize) + idOffset,
+                                         reinterpret_cast<const char *>(&id), sizeof(int))) {
+                return false;
+            }
+        }
+        if (!slots.empty() &&
+            (!bufferPool().writeBytes(mapPath, 0, reinterpret_cast<const char *>(slots.data()),
+                                      slots.size() * sizeof(int), true) ||
+             !bufferPool().flushFile(mapPath))) {
+            return false;
+        }
+        header.nextRecordId = slots.size();
+    }
+
+    if (!bufferPool().writeBytes(filePath, 0, reinterpret_cast<const char *>(&header), sizeof(DBHeader)) ||
+        !bufferPool().flushFile(filePath)) {
+        return false;
+    }
+
+    if (!mapped) {
+        bufferPool().dropFile(indexPath);
+        remove(indexPath.c_str());
+    }
+    return true;
+}
+
+unique_ptr<TableInfo> Catalog::loadTable(const string &tableName) {
+    // A VACUUM that stopped after deciding to swap is finished first
+    if (!completeVacuum(tableName)) {
+        return nullptr;
+    }
+
+    auto table = make_unique<TableInfo>();
+    table->name = tableName;
+    table->columns = readSchema(tableName);
+    if (table->columns.empty()) {
+        return nullptr;
+    }
+
+    for (const auto &column: table->columns) {
+        table->columnOffsets.push_back(table->recordSize);
+        table->columnTypes.push_back(columnTypeOf(column));
+        table->recordSize += column.size;
+    }
+
+    const string filePath = dataPath + tableName + dataFileType;
+    if (!bufferPool().readBytes(filePath, 0, reinterpret_cast<char *>(&table->header), sizeof(DBHeader))) {
+        cerr << "Table file not found: " << tableName << endl;
+        return nullptr;
+    }
+
+    if (!upgradeTable(*table)) {
+        cerr << "Error upgrading table file: " << tableName << endl;
+        return nullptr;
+    }
+
+    for (const auto &[indexName, columnName]: readIndexList(tableName)) {
+        const int column = table->columnIndex(columnName);
+        if (column == -1) {
+            cerr << "Warning: Index " << indexName << " refers to unknown column " << columnName << endl;
+            continue;
+        }
+        table->indexes.push_back({indexName, column, indexFilePath(tableName, indexName)});
+    }
+    for (const auto &columnName: readBloomList(tableName)) {
+        const int column = table->columnIndex(columnName);
+        if (column == -1) {
+            cerr << "Warning: Bloom filter refers to unknown column " << columnName << endl;
+            continue;
+        }
+        table->bloomColumns.push_back(column);
+    }
+    for (const auto &columnName: readBitmapList(tableName)) {
+        const int column = table->columnIndex(columnName);
+        if (column == -1) {
+            cerr << "Warning: Bitmap index refers to unknown column " << columnName << endl;
+            continue;
+        }
+        table->bitmapColumns.push_back(column);
+    }
+
+    return table;
+}
+
+shared_ptr<const TableInfo> Catalog::getTable(const string &tableName) {
+    lock_guard<mutex> guard(latch);
+    auto it = tables.find(tableName);
+    if (it != tables.end()) {
+        return it->second;
+    }
+
+    unique_ptr<TableInfo> table = loadTable(tableName);
+    if (!table) {
+        return nullptr;
+    }
+    return tables[tableName] = move(table);
+}
+
+void Catalog::updateHeader(const string &tableName, const DBHeader &header) {
+    lock_guard<mutex> guard(latch);
+    auto it = tables.find(tableName);
+    if (it != tables.end()) {
+        // Readers may hold the old TableInfo, so publish a changed copy instead
+        auto updated = make_shared<TableInfo>(*it->second);
+        updated->header = header;
+        it->second = move(updated);
+    }
+}
+
+vector<string> Catalog::tableNames() {
+    lock_guard<mutex> guard(latch);
+    vector<string> names;
+    for (const auto &entry: tables) {
+        names.push_back(entry.first);
+    }
+    return names;
+}
+
+void Catalog::invalidate(const string &tableName) {
+    lock_guard<mutex> guard(latch);
+    auto it = tables.find(tableName);
+    if (it != tables.end()) {
+        tables.erase(it);
+    }
+}
+
+void Catalog::clear() {
+    lock_guard<mutex> guard(latch);
+    tables.clear();
+}
+
+Catalog &catalog() {
+    static Catalog instance;
+    return instance;
+}
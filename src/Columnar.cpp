@@ -0,0 +1,415 @@
+#include "../include/Columnar.h"
+#include "../include/BloomFilter.h"
+#include "../include/BufferPool.h"
+#include "../include/Compression.h"
+#include "../include/ZoneMap.h"
+
+using namespace std;
+
+static bool isColumnar(const TableInfo &table) {
+    return table.header.layout == TableLayout::Columnar && table.header.segmentRecords > 0;
+}
+
+// ==================== Segment Directory ====================
+
+// How one column of one segment is stored. The directory holds one entry per
+// column per segment; entries past its end are plain.
+struct SegmentColumnEntry {
+    ColumnEncoding encoding = ColumnEncoding::Plain;
+    uint32_t bytes = 0; // length of the encoded form
+};
+
+static uint64_t entryOffset(const TableInfo &table, uint64_t segment, int column) {
+    return (segment * table.columns.size() + column) * sizeof(SegmentColumnEntry);
+}
+
+static SegmentColumnEntry readEntry(const TableInfo &table, const string &filePath, uint64_t segment, int column) {
+    SegmentColumnEntry entry;
+    if (!bufferPool().readBytes(companionFilePath(filePath, segmentFileType), entryOffset(table, segment, column),
+                                reinterpret_cast<char *>(&entry), sizeof(entry))) {
+        return {};
+    }
+    return entry;
+}
+
+static bool writeEntry(const TableInfo &table, const string &filePath, uint64_t segment, int column,
+                       const SegmentColumnEntry &entry) {
+    return bufferPool().writeBytes(companionFilePath(filePath, segmentFileType), entryOffset(table, segment, column),
+                                   reinterpret_cast<const char *>(&entry), sizeof(entry), true);
+}
+
+// ==================== Encoding ====================
+
+// Encoded column: this header, the distinct values (16-bit length, then the
+// bytes without padding), then `entries` codes or (code, run length - 1) pairs
+struct EncodedHeader {
+    uint32_t valueCount;
+    uint32_t entries;
+};
+
+// Encode `slots` plain values of `size` bytes. False when the encoded form
+// wouldn't be smaller, or there are too many distinct values for 16-bit codes.
+static bool encodeColumn(const char *plain, size_t slots, int size, string &encoded, ColumnEncoding &encoding) {
+    if (slots > 65536) {
+        return false;
+    }
+    unordered_map<string_view, uint16_t> codes;
+    vector<string_view> values;
+    vector<uint16_t> slotCodes(slots);
+    size_t valueBytes = 0, runs = 0;
+    for (size_t i = 0; i < slots; i++) {
+        const char *value = plain + i * size;
+        const string_view text(value, strnlen(value, size));
+        if (codes.emplace(text, 0).second) {
+            values.push_back(text);
+            valueBytes += sizeof(uint16_t) + text.size();
+        }
+    }
+    if (values.size() > 65536) {
+        return false;
+    }
+
+    // Codes in value order, so equal values get equal codes in every encoding
+    sort(values.begin(), values.end());
+    for (size_t code = 0; code < values.size(); code++) {
+        codes[values[code]] = code;
+    }
+    for (size_t i = 0; i < slots; i++) {
+        const char *value = plain + i * size;
+        slotCodes[i] = codes[string_view(value, strnlen(value, size))];
+        runs += i == 0 || slotCodes[i] != slotCodes[i - 1];
+    }
+
+    const size_t dictionaryBytes = sizeof(EncodedHeader) + valueBytes + slots * sizeof(uint16_t);
+    const size_t runLengthBytes = sizeof(EncodedHeader) + valueBytes + runs * 2 * sizeof(uint16_t);
+    if (min(dictionaryBytes, runLengthBytes) >= slots * size) {
+        return false;
+    }
+    encoding = runLengthBytes < dictionaryBytes ? ColumnEncoding::RunLength : ColumnEncoding::Dictionary;
+
+    auto put = [&](const void *bytes, size_t length) { encoded.append(static_cast<const char *>(bytes), length); };
+    encoded.clear();
+    const EncodedHeader header{static_cast<uint32_t>(values.size()),
+                               static_cast<uint32_t>(encoding == ColumnEncoding::RunLength ? runs : slots)};
+    put(&header, sizeof(header));
+    for (const auto &value: values) {
+        const uint16_t length = value.size();
+        put(&length, sizeof(length));
+        put(value.data(), value.size());
+    }
+    if (encoding == ColumnEncoding::Dictionary) {
+        put(slotCodes.data(), slots * sizeof(uint16_t));
+        return true;
+    }
+    for (size_t first = 0; first < slots;) {
+        size_t last = first;
+        while (last + 1 < slots && slotCodes[last + 1] == slotCodes[first]) last++;
+        const uint16_t run[2] = {slotCodes[first], static_cast<uint16_t>(last - first)};
+        put(run, sizeof(run));
+        first = last + 1;
+    }
+    return true;
+}
+
+// Decode an encoded column of `slots` values, checking every count and code
+// against the bytes actually there
+static bool decodeColumn(const char *bytes, size_t length, ColumnEncoding encoding, size_t slots, int size,
+                         SegmentDictionary &dictionary) {
+    const char *end = bytes + length;
+    EncodedHeader header;
+    if (length < sizeof(header)) return false;
+    memcpy(&header, bytes, sizeof(header));
+    bytes += sizeof(header);
+
+    dictionary.valueSize = size;
+    dictionary.values.assign(size_t(header.valueCount) * size, '\0');
+    for (uint32_t code = 0; code < header.valueCount; code++) {
+        uint16_t valueLength;
+        if (end - bytes < static_cast<ptrdiff_t>(sizeof(valueLength))) return false;
+        memcpy(&valueLength, bytes, sizeof(valueLength));
+        bytes += sizeof(valueLength);
+        if (valueLength > size || end - bytes < valueLength) return false;
+        memcpy(dictionary.values.data() + size_t(code) * size, bytes, valueLength);
+        bytes += valueLength;
+    }
+
+    dictionary.codes.resize(slots);
+    if (encoding == ColumnEncoding::Dictionary) {
+        if (header.entries != slots || static_cast<size_t>(end - bytes) < slots * sizeof(uint16_t)) return false;
+        memcpy(dictionary.codes.data(), bytes, slots * sizeof(uint16_t));
+    } else {
+        if (static_cast<size_t>(end - bytes) < header.entries * 2 * sizeof(uint16_t)) return false;
+        size_t slot = 0;
+        for (uint32_t i = 0; i < header.entries; i++, bytes += 2 * sizeof(uint16_t)) {
+            uint16_t run[2];
+            memcpy(run, bytes, sizeof(run));
+            if (slot + run[1] + 1 > slots) return false;
+            fill_n(dictionary.codes.begin() + slot, run[1] + 1, run[0]);
+            slot += run[1] + 1;
+        }
+        if (slot != slots) return false;
+    }
+    for (const uint16_t code: dictionary.codes) {
+        if (code >= header.valueCount) return false;
+    }
+    return true;
+}
+
+int SegmentDictionary::codeOf(string_view value) const {
+    auto valueAt = [&](size_t code) {
+        const char *text = this->value(code);
+        return string_view(text, strnlen(text, valueSize));
+    };
+    size_t low = 0, high = values.size() / max(valueSize, 1);
+    while (low < high) {
+        const size_t middle = (low + high) / 2;
+        if (valueAt(middle) < value) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low < values.size() / max(valueSize, 1) && valueAt(low) == value ? static_cast<int>(low) : -1;
+}
+
+// ==================== Dictionary Cache ====================
+
+// Decoded dictionaries of recently read segments. A scan reads each segment
+// in several chunks; the cache saves decoding it again for every chunk.
+constexpr size_t dictionaryCacheEntries = 64;
+
+static struct {
+    mutex latch;
+    uint64_t generation = 0; // bumped whenever cached entries may be stale
+    map<tuple<string, uint64_t, int>, shared_ptr<const SegmentDictionary>> entries;
+} dictionaryCache;
+
+void invalidateSegmentDictionaries() {
+    lock_guard<mutex> guard(dictionaryCache.latch);
+    dictionaryCache.generation++;
+    dictionaryCache.entries.clear();
+}
+
+// Cache `dictionary` unless the cache changed since `generation` was taken
+static void cacheDictionary(tuple<string, uint64_t, int> key, shared_ptr<const SegmentDictionary> dictionary,
+                            uint64_t generation) {
+    lock_guard<mutex> guard(dictionaryCache.latch);
+    if (generation != dictionaryCache.generation) {
+        return;
+    }
+    if (dictionaryCache.entries.size() >= dictionaryCacheEntries) {
+        dictionaryCache.entries.erase(dictionaryCache.entries.begin());
+    }
+    dictionaryCache.entries[move(key)] = move(dictionary);
+}
+
+bool segmentDictionary(const TableInfo &table, const string &filePath, uint64_t segment, int column,
+                       shared_ptr<const SegmentDictionary> &dictionary) {
+    dictionary.reset();
+    if (!isColumnar(table) || table.columnTypes[column] != ColumnType::String) {
+        return true;
+    }
+    const SegmentColumnEntry entry = readEntry(table, filePath, segment, column);
+    if (entry.encoding == ColumnEncoding::Plain) {
+        return true;
+    }
+
+    auto key = make_tuple(filePath, segment, column);
+    uint64_t generation;
+    {
+        lock_guard<mutex> guard(dictionaryCache.latch);
+        const auto it = dictionaryCache.entries.find(key);
+        if (it != dictionaryCache.entries.end()) {
+            dictionary = it->second;
+            return true;
+        }
+        generation = dictionaryCache.generation;
+    }
+
+    const uint64_t segmentRecords = table.header.segmentRecords;
+    const int size = table.columns[column].size;
+    thread_local vector<char> bytes;
+    bytes.resize(entry.bytes);
+    auto decoded = make_shared<SegmentDictionary>();
+    if (entry.bytes > segmentRecords * size ||
+        !readTableBytes(table, filePath, columnValueOffset(table, segment * segmentRecords, column), bytes.data(),
+                        bytes.size()) ||
+        !decodeColumn(bytes.data(), bytes.size(), entry.encoding, segmentRecords, size, *decoded)) {
+        cerr << "Error: Failed to decode column " << table.columns[column].name << " of segment " << segment
+             << " in " << filePath << endl;
+        return false;
+    }
+    dictionary = decoded;
+    cacheDictionary(move(key), move(decoded), generation);
+    return true;
+}
+
+// Store the whole column of a segment from `plain`: encoded if that is
+// smaller, plain otherwise. A column that was plain and doesn't shrink is
+// left untouched.
+static bool storeColumn(const TableInfo &table, const string &filePath, uint64_t segment, int column,
+                        const char *plain, bool wasEncoded, bool create) {
+    const uint64_t segmentRecords = table.header.segmentRecords;
+    const int size = table.columns[column].size;
+    const FileOffset start = columnValueOffset(table, segment * segmentRecords, column);
+
+    string encoded;
+    SegmentColumnEntry entry;
+    if (!encodeColumn(plain, segmentRecords, size, encoded, entry.encoding)) {
+        if (!wasEncoded) {
+            return true;
+        }
+        invalidateSegmentDictionaries();
+        return bufferPool().writeBytes(filePath, start, plain, segmentRecords * size, create) &&
+               writeEntry(table, filePath, segment, column, {});
+    }
+
+    entry.bytes = encoded.size();
+    invalidateSegmentDictionaries();
+    return bufferPool().writeBytes(filePath, start, encoded.data(), encoded.size(), create) &&
+           writeEntry(table, filePath, segment, column, entry);
+}
+
+// Once its last slot is written, encode the string columns of a segment
+static bool sealSegment(const TableInfo &table, const string &filePath, uint64_t segment, bool create) {
+    const uint64_t segmentRecords = table.header.segmentRecords;
+    thread_local vector<char> plain;
+    for (size_t column = 0; column < table.columns.size(); column++) {
+        if (table.columnTypes[column] != ColumnType::String ||
+            readEntry(table, filePath, segment, column).encoding != ColumnEncoding::Plain) {
+            continue;
+        }
+        plain.resize(segmentRecords * table.columns[column].size);
+        if (!bufferPool().readBytes(filePath, columnValueOffset(table, segment * segmentRecords, column),
+                                    plain.data(), plain.size()) ||
+            !storeColumn(table, filePath, segment, column, plain.data(), false, create)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ==================== Record I/O ====================
+
+FileOffset columnValueOffset(const TableInfo &table, uint64_t slot, int column) {
+    if (!isColumnar(table)) {
+        return slotOffset(slot, table.recordSize) + table.columnOffsets[column];
+    }
+    const uint64_t segmentRecords = table.header.segmentRecords;
+    const uint64_t segment = slot / segmentRecords;
+    return headerSize + segment * segmentRecords * table.recordSize +
+           segmentRecords * table.columnOffsets[column] + (slot % segmentRecords) * table.columns[column].size;
+}
+
+// Call `visit(firstSlot, count)` for each piece of the slot range that stays
+// inside one segment
+template <typename Visit>
+static bool forEachSegmentRun(const TableInfo &table, uint64_t firstSlot, size_t count, Visit visit) {
+    const uint64_t segmentRecords = table.header.segmentRecords;
+    for (uint64_t slot = firstSlot; slot < firstSlot + count;) {
+        const size_t run = min<uint64_t>(firstSlot + count - slot, segmentRecords - slot % segmentRecords);
+        if (!visit(slot, run)) {
+            return false;
+        }
+        slot += run;
+    }
+    return true;
+}
+
+bool readSlots(const TableInfo &table, const string &filePath, uint64_t firstSlot, size_t count,
+               const vector<int> &columns, char *records) {
+    const int recordSize = table.recordSize;
+    if (!isColumnar(table)) {
+        return readTableBytes(table, filePath, slotOffset(firstSlot, recordSize), records, count * recordSize);
+    }
+
+    vector<int> allColumns;
+    if (columns.empty()) {
+        allColumns.resize(table.columns.size());
+        iota(allColumns.begin(), allColumns.end(), 0);
+    }
+    thread_local vector<char> values;
+    return forEachSegmentRun(table, firstSlot, count, [&](uint64_t slot, size_t run) {
+        char *out = records + (slot - firstSlot) * recordSize;
+        for (const int column: columns.empty() ? allColumns : columns) {
+            const int size = table.columns[column].size;
+            const int offset = table.columnOffsets[column];
+            shared_ptr<const SegmentDictionary> dictionary;
+            if (!segmentDictionary(table, filePath, slot / table.header.segmentRecords, column, dictionary)) {
+                return false;
+            }
+            if (dictionary) {
+                const uint16_t *codes = dictionary->codes.data() + slot % table.header.segmentRecords;
+                for (size_t i = 0; i < run; i++) {
+                    memcpy(out + i * recordSize + offset, dictionary->value(codes[i]), size);
+                }
+                continue;
+            }
+            values.resize(run * size);
+            if (!readTableBytes(table, filePath, columnValueOffset(table, slot, column), values.data(), run * size)) {
+                return false;
+            }
+            for (size_t i = 0; i < run; i++) {
+                memcpy(out + i * recordSize + offset, values.data() + i * size, size);
+            }
+        }
+        return true;
+    });
+}
+
+bool writeSlots(const TableInfo &table, const string &filePath, uint64_t firstSlot, const char *records,
+                size_t count, bool create) {
+    const int recordSize = table.recordSize;
+    if (!updateZoneMap(table, filePath, firstSlot, records, count) ||
+        !updateBloomFilters(table, filePath, firstSlot, records, count)) {
+        return false;
+    }
+    if (!isColumnar(table)) {
+        return bufferPool().writeBytes(filePath, slotOffset(firstSlot, recordSize), records, count * recordSize,
+                                       create);
+    }
+
+    const uint64_t segmentRecords = table.header.segmentRecords;
+    thread_local vector<char> values;
+    return forEachSegmentRun(table, firstSlot, count, [&](uint64_t slot, size_t run) {
+        const char *in = records + (slot - firstSlot) * recordSize;
+        const uint64_t segment = slot / segmentRecords;
+        for (size_t column = 0; column < table.columns.size(); column++) {
+            const int size = table.columns[column].size;
+            const int offset = table.columnOffsets[column];
+            shared_ptr<const SegmentDictionary> dictionary;
+            if (!segmentDictionary(table, filePath, segment, column, dictionary)) {
+                return false;
+            }
+
+            // An encoded column is decoded, patched and stored again as a whole
+            const size_t first = dictionary ? 0 : slot % segmentRecords;
+            const size_t slots = dictionary ? segmentRecords : run;
+            values.resize(slots * size);
+            for (size_t i = 0; dictionary && i < slots; i++) {
+                memcpy(values.data() + i * size, dictionary->value(dictionary->codes[i]), size);
+            }
+            char *patch = values.data() + (slot % segmentRecords - first) * size;
+            for (size_t i = 0; i < run; i++) {
+                memcpy(patch + i * size, in + i * recordSize + offset, size);
+            }
+            const bool written = dictionary ? storeColumn(table, filePath, segment, column, values.data(), true, create)
+                                            : bufferPool().writeBytes(filePath, columnValueOffset(table, slot, column),
+                                                                      values.data(), run * size, create);
+            if (!written) {
+                return false;
+            }
+        }
+        return (slot + run) % segmentRecords != 0 || sealSegment(table, filePath, segment, create);
+    });
+}
+
+vector<int> withIdColumn(const TableInfo &table, vector<int> columns) {
+    const int idColumn = table.columnIndex(ID_COLUMN);
+    if (find(columns.begin(), columns.end(), idColumn) == columns.end()) {
+        columns.push_back(idColumn);
+    }
+    sort(columns.begin(), columns.end());
+    columns.erase(unique(columns.begin(), columns.end()), columns.end());
+    return columns;
+}
@@ -0,0 +1,253 @@
+#include "../include/Compression.h"
+#include "../include/BufferPool.h"
+
+using namespace std;
+
+// ==================== LZ Codec ====================
+
+constexpr size_t lzMinMatch = 4;
+constexpr size_t lzMaxOffset = 65535;
+constexpr int lzHashBits = 14;
+
+// Lengths that don't fit a token nibble continue in bytes of 255, ending with one below
+static void putLength(string &output, size_t length) {
+    for (; length >= 255; length -= 255) {
+        output.push_back(static_cast<char>(255));
+    }
+    output.push_back(static_cast<char>(length));
+}
+
+// One sequence: a token (literal count, match length - 4), the literals, then
+// the match offset. The last sequence of a block has no match.
+static void putSequence(string &output, const char *literals, size_t literalCount, size_t offset,
+                        size_t matchLength) {
+    const size_t matchCode = matchLength ? matchLength - lzMinMatch : 0;
+    output.push_back(static_cast<char>(min<size_t>(literalCount, 15) << 4 | min<size_t>(matchCode, 15)));
+    if (literalCount >= 15) putLength(output, literalCount - 15);
+    output.append(literals, literalCount);
+    if (matchLength == 0) {
+        return;
+    }
+    output.push_back(static_cast<char>(offset & 0xFF));
+    output.push_back(static_cast<char>(offset >> 8));
+    if (matchCode >= 15) putLength(output, matchCode - 15);
+}
+
+void lzCompress(const char *input, size_t length, string &output) {
+    output.clear();
+    thread_local vector<uint32_t> positions;
+    positions.assign(size_t(1) << lzHashBits, UINT32_MAX);
+
+    size_t anchor = 0;
+    for (size_t position = 0; position + lzMinMatch <= length;) {
+        uint32_t sequence;
+        memcpy(&sequence, input + position, sizeof(sequence));
+        uint32_t &last = positions[(sequence * 2654435761u) >> (32 - lzHashBits)];
+        const size_t candidate = last;
+        last = static_cast<uint32_t>(position);
+
+        if (candidate == UINT32_MAX || position - candidate > lzMaxOffset ||
+            memcmp(input + candidate, input + position, lzMinMatch) != 0) {
+            position++;
+            continue;
+        }
+        size_t matchLength = lzMinMatch;
+        while (position + matchLength < length && input[candidate + matchLength] == input[position + matchLength]) {
+            matchLength++;
+        }
+        putSequence(output, input + anchor, position - anchor, position - candidate, matchLength);
+        position += matchLength;
+        anchor = position;
+    }
+    putSequence(output, input + anchor, length - anchor, 0, 0);
+}
+
+bool lzDecompress(const char *input, size_t length, char *output, size_t outputLength) {
+    const uint8_t *in = reinterpret_cast<const uint8_t *>(input);
+    const uint8_t *end = in + length;
+    size_t out = 0;
+    auto getLength = [&](size_t &value) {
+        uint8_t byte;
+        do {
+            if (in == end) return false;
+            byte = *in++;
+            value += byte;
+        } while (byte == 255);
+        return true;
+    };
+
+    while (in < end) {
+        const uint8_t token = *in++;
+        size_t literals = token >> 4;
+        if (literals == 15 && !getLength(literals)) return false;
+        if (static_cast<size_t>(end - in) < literals || outputLength - out < literals) return false;
+        memcpy(output + out, in, literals);
+        in += literals;
+        out += literals;
+        if (in == end) break;
+
+        if (end - in < 2) return false;
+        const size_t offset = in[0] | in[1] << 8;
+        in += 2;
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !getLength(matchLength)) return false;
+        matchLength += lzMinMatch;
+        if (offset == 0 || offset > out || outputLength - out < matchLength) return false;
+        // Byte by byte: the match may overlap the bytes it produces
+        for (size_t i = 0; i < matchLength; i++, out++) {
+            output[out] = output[out - offset];
+        }
+    }
+    return out == outputLength;
+}
+
+// ==================== Block Index ====================
+
+struct CompressedBlock {
+    uint64_t offset;    // in the data file
+    uint32_t length;    // compressed bytes
+    uint32_t rawLength; // bytes once decompressed, less than a block only for the last one
+    BlockCodec codec;
+};
+
+static uint64_t blockBytes(const DBHeader &header, int recordSize) {
+    return uint64_t(header.blockRecords) * recordSize;
+}
+
+// ==================== Block Cache ====================
+
+// Decompressed blocks of recent reads. A scan chunk and the blocks under it
+// rarely line up, and point lookups tend to come back to the same blocks.
+constexpr size_t blockCacheEntries = 64;
+
+static struct {
+    mutex latch;
+    uint64_t generation = 0; // bumped whenever cached blocks may be stale
+    map<pair<string, uint64_t>, shared_ptr<const vector<char>>> entries;
+} blockCache;
+
+void invalidateCompressedBlocks() {
+    lock_guard<mutex> guard(blockCache.latch);
+    blockCache.generation++;
+    blockCache.entries.clear();
+}
+
+static bool loadBlock(const string &filePath, uint64_t block, shared_ptr<const vector<char>> &data) {
+    auto key = make_pair(filePath, block);
+    uint64_t generation;
+    {
+        lock_guard<mutex> guard(blockCache.latch);
+        const auto it = blockCache.entries.find(key);
+        if (it != blockCache.entries.end()) {
+            data = it->second;
+            return true;
+        }
+        generation = blockCache.generation;
+    }
+
+    thread_local vector<char> compressed;
+    CompressedBlock entry;
+    const bool read = bufferPool().readBytes(companionFilePath(filePath, blockIndexFileType),
+                                             block * sizeof(CompressedBlock), reinterpret_cast<char *>(&entry),
+                                             sizeof(entry));
+    auto decompressed = make_shared<vector<char>>(read ? entry.rawLength : 0);
+    bool decoded = false;
+    if (read && entry.codec == BlockCodec::Stored) {
+        decoded = entry.length == entry.rawLength &&
+                  bufferPool().readBytes(filePath, entry.offset, decompressed->data(), decompressed->size());
+    } else if (read && entry.codec == BlockCodec::Lz) {
+        compressed.resize(entry.length);
+        decoded = bufferPool().readBytes(filePath, entry.offset, compressed.data(), compressed.size()) &&
+                  lzDecompress(compressed.data(), compressed.size(), decompressed->data(), decompressed->size());
+    }
+    if (!decoded) {
+        cerr << "Error: Failed to decompress block " << block << " of " << filePath << endl;
+        return false;
+    }
+
+    data = decompressed;
+    lock_guard<mutex> guard(blockCache.latch);
+    if (generation == blockCache.generation) {
+        if (blockCache.entries.size() >= blockCacheEntries) {
+            blockCache.entries.erase(blockCache.entries.begin());
+        }
+        blockCache.entries[move(key)] = move(decompressed);
+    }
+    return true;
+}
+
+bool readTableBytes(const TableInfo &table, const string &filePath, uint64_t offset, char *buffer, size_t length) {
+    if (!isCompressed(table) || offset + length <= headerSize) {
+        return bufferPool().readBytes(filePath, offset, buffer, length);
+    }
+    if (offset < headerSize) {
+        return false;
+    }
+
+    const uint64_t size = blockBytes(table.header, table.recordSize);
+    while (length > 0) {
+        const uint64_t block = (offset - headerSize) / size;
+        const size_t within = (offset - headerSize) % size;
+        shared_ptr<const vector<char>> data;
+        if (!loadBlock(filePath, block, data) || data->size() <= within) {
+            return false;
+        }
+        const size_t chunk = min(length, data->size() - within);
+        memcpy(buffer, data->data() + within, chunk);
+        buffer += chunk;
+        offset += chunk;
+        length -= chunk;
+    }
+    return true;
+}
+
+// ==================== Compression ====================
+
+bool compressDataFile(const string &filePath, DBHeader &header, int recordSize) {
+    const string compressedPath = filePath + ".lz";
+    const string blockPath = companionFilePath(filePath, blockIndexFileType);
+    for (const auto &path: {compressedPath, blockPath}) {
+        bufferPool().dropFile(path);
+        remove(path.c_str());
+    }
+
+    header.blockRecords = max<size_t>(compressedBlockBytes / recordSize, 1);
+    const uint64_t size = blockBytes(header, recordSize);
+    // Not freeOffset: the last segment of a columnar table has values past it
+    const uint64_t fileEnd = bufferPool().fileSize(filePath);
+    vector<char> block;
+    string compressed;
+    uint64_t nextOffset = headerSize;
+    vector<CompressedBlock> entries;
+    for (uint64_t start = headerSize; start < fileEnd; start += size) {
+        block.resize(min(size, fileEnd - start));
+        if (!bufferPool().readBytes(filePath, start, block.data(), block.size())) {
+            return false;
+        }
+        lzCompress(block.data(), block.size(), compressed);
+        const auto rawLength = static_cast<uint32_t>(block.size());
+        CompressedBlock entry{nextOffset, static_cast<uint32_t>(compressed.size()), rawLength, BlockCodec::Lz};
+        const char *bytes = compressed.data();
+        if (compressed.size() >= block.size()) {
+            entry = {nextOffset, rawLength, rawLength, BlockCodec::Stored};
+            bytes = block.data();
+        }
+        if (!bufferPool().writeBytes(compressedPath, entry.offset, bytes, entry.length, true)) {
+            return false;
+        }
+        entries.push_back(entry);
+        nextOffset += entry.length;
+    }
+
+    // The compressed file replaces the uncompressed one once it's durable
+    if (!bufferPool().writeBytes(compressedPath, 0, reinterpret_cast<const char *>(&header), sizeof(DBHeader),
+                                 true) ||
+        !bufferPool().writeBytes(blockPath, 0, reinterpret_cast<const char *>(entries.data()),
+                                 entries.size() * sizeof(CompressedBlock), true) ||
+        !bufferPool().flushFile(compressedPath) || !bufferPool().flushFile(blockPath) || !bufferPool().syncAll()) {
+        return false;
+    }
+    bufferPool().dropFile(filePath);
+    bufferPool().dropFile(compressedPath);
+    return rename(compressedPath.c_str(), filePath.c_str()) == 0;
+}
@@ -0,0 +1,312 @@
+#include "../include/CsvImport.h"
+#include "../include/Catalog.h"
+#include "../include/FilterKernels.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMDB_X86_KERNELS 1
+#endif
+
+using namespace std;
+
+// ==================== Fields ====================
+
+// Trim blanks and a trailing \r, then drop enclosing quotes
+static string_view cleanField(string_view field) {
+    const size_t first = field.find_first_not_of(" \t\r");
+    if (first == string_view::npos) {
+        return {};
+    }
+    field = field.substr(first, field.find_last_not_of(" \t\r") - first + 1);
+    if (field.size() >= 2 && field.front() == '"' && field.back() == '"') {
+        field = field.substr(1, field.size() - 2);
+    }
+    return field;
+}
+
+template<typename Field>
+static void splitLine(string_view line, vector<Field> &fields) {
+    fields.clear();
+    bool quoted = false;
+    size_t start = 0;
+    for (size_t i = 0; i < line.size(); i++) {
+        if (line[i] == '"') {
+            quoted = !quoted;
+        } else if (line[i] == ',' && !quoted) {
+            fields.emplace_back(cleanField(line.substr(start, i - start)));
+            start = i + 1;
+        }
+    }
+    fields.emplace_back(cleanField(line.substr(start)));
+}
+
+void splitCsvLine(string_view line, vector<string> &fields) {
+    splitLine(line, fields);
+}
+
+void splitCsvLine(string_view line, vector<string_view> &fields) {
+    splitLine(line, fields);
+}
+
+// ==================== Delimiter Scanning ====================
+
+// Bit i is set when byte i of the 32 byte block is ',', '\n' or '"'
+static uint32_t delimiterMaskScalar(const char *block, size_t length) {
+    uint32_t mask = 0;
+    for (size_t i = 0; i < length; i++) {
+        const char c = block[i];
+        mask |= uint32_t(c == ',' || c == '\n' || c == '"') << i;
+    }
+    return mask;
+}
+
+#ifdef SIMDB_X86_KERNELS
+__attribute__((target("avx2")))
+static uint32_t delimiterMaskAvx2(const char *block) {
+    const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+    const __m256i matches = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(',')),
+                        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n'))),
+        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('"')));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(matches));
+}
+#endif
+
+// Walk the delimiters of [begin, end) and hand every complete line's fields
+// to `onLine`. Blank lines are skipped; a last line without '\n' still counts.
+template<typename OnLine>
+static void scanLines(const char *begin, const char *end, vector<string_view> &fields, const OnLine &onLine) {
+#ifdef SIMDB_X86_KERNELS
+    const bool avx2 = activeSimdLevel() == SimdLevel::AVX2;
+#endif
+    const char *fieldStart = begin;
+    bool quoted = false;
+    fields.clear();
+
+    auto endLine = [&] {
+        if (!(fields.size() == 1 && fields[0].empty())) {
+            onLine(fields);
+        }
+        fields.clear();
+    };
+
+    for (const char *block = begin; block < end; block += 32) {
+        const size_t length = min<size_t>(32, end - block);
+#ifdef SIMDB_X86_KERNELS
+        uint32_t mask = avx2 && length == 32 ? delimiterMaskAvx2(block) : delimiterMaskScalar(block, length);
+#else
+        uint32_t mask = delimiterMaskScalar(block, length);
+#endif
+
+        for (; mask; mask &= mask - 1) {
+            const char *position = block + __builtin_ctz(mask);
+            if (*position == '"') {
+                quoted = !quoted;
+                continue;
+            }
+            if (quoted) continue;
+
+            fields.push_back(cleanField(string_view(fieldStart, position - fieldStart)));
+            fieldStart = position + 1;
+            if (*position == '\n') {
+                endLine();
+            }
+        }
+    }
+
+    if (fieldStart < end || !fields.empty()) {
+        fields.push_back(cleanField(string_view(fieldStart, end - fieldStart)));
+        endLine();
+    }
+}
+
+// ==================== Import ====================
+
+// Read-only view of the whole input file
+class MappedFile {
+public:
+    explicit MappedFile(const string &filePath) {
+        const int fd = open(filePath.c_str(), O_RDONLY);
+        struct stat st{};
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            if (fd >= 0) close(fd);
+            throw runtime_error("Cannot open CSV file: " + filePath);
+        }
+
+        length = st.st_size;
+        if (length > 0) {
+            void *mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                close(fd);
+                throw runtime_error("Cannot map CSV file: " + filePath);
+            }
+            madvise(mapping, length, MADV_SEQUENTIAL);
+            bytes = static_cast<const char *>(mapping);
+        }
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (bytes) munmap(const_cast<char *>(bytes), length);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *begin() const { return bytes; }
+    const char *end() const { return bytes + length; }
+
+private:
+    const char *bytes = nullptr;
+    size_t length = 0;
+};
+
+// Encoded records of one chunk, waiting for the appender
+struct EncodedChunk {
+    vector<char> records;
+    size_t count = 0;
+    string error;
+    bool done = false;
+};
+
+static size_t importThreads() {
+    size_t threads = max(thread::hardware_concurrency(), 1u);
+    if (const char *value = getenv(importThreadsEnv.c_str())) {
+        try {
+            threads = max<size_t>(stoul(value), 1);
+        } catch (const exception &) {
+            cerr << "Warning: Invalid " << importThreadsEnv << ", using " << threads << " threads" << endl;
+        }
+    }
+    return threads;
+}
+
+size_t importCsv(const string &tableName, const string &filePath, bool skipHeader, size_t chunkBytes) {
+    shared_ptr<const TableInfo> table = catalog().getTable(tableName);
+    if (!table) {
+        throw runtime_error("Error opening file: " + dataPath + tableName + dataFileType);
+    }
+
+    MappedFile input(filePath);
+    const char *begin = input.begin();
+    const char *end = input.end();
+    if (skipHeader && begin != end) {
+        const char *newline = static_cast<const char *>(memchr(begin, '\n', end - begin));
+        begin = newline ? newline + 1 : end;
+    }
+
+    // Chunk boundaries always sit just after a newline outside quotes, where
+    // the quotes since the start of the chunk are balanced
+    vector<pair<const char *, const char *>> chunks;
+    while (begin < end) {
+        const char *chunkEnd = begin + min<size_t>(max<size_t>(chunkBytes, 1), end - begin);
+        bool quoted = count(begin, chunkEnd, '"') % 2;
+        while (chunkEnd < end) {
+            const char *newline = static_cast<const char *>(memchr(chunkEnd, '\n', end - chunkEnd));
+            if (!newline) {
+                chunkEnd = end;
+                break;
+            }
+            quoted ^= count(chunkEnd, newline, '"') % 2;
+            chunkEnd = newline + 1;
+            if (!quoted) break;
+        }
+        chunks.emplace_back(begin, chunkEnd);
+        begin = chunkEnd;
+    }
+    if (chunks.empty()) {
+        return 0;
+    }
+
+    const size_t threads = min(importThreads(), chunks.size());
+    const size_t window = 2 * threads; // chunks encoded ahead of the appender
+    const int recordSize = table->recordSize;
+
+    vector<EncodedChunk> encoded(chunks.size());
+    mutex latch;
+    condition_variable changed;
+    size_t nextChunk = 0, appended = 0;
+    bool stop = false;
+
+    auto worker = [&] {
+        vector<string_view> fields;
+        while (true) {
+            size_t chunk;
+            {
+                unique_lock<mutex> lock(latch);
+                changed.wait(lock, [&] { return stop || nextChunk == chunks.size() || nextChunk < appended + window; });
+                if (stop || nextChunk == chunks.size()) return;
+                chunk = nextChunk++;
+            }
+
+            EncodedChunk result;
+            const auto [chunkBegin, chunkEnd] = chunks[chunk];
+            result.records.reserve((chunkEnd - chunkBegin) / 8 * recordSize / 4);
+            try {
+                scanLines(chunkBegin, chunkEnd, fields, [&](const vector<string_view> &row) {
+                    result.records.resize((result.count + 1) * recordSize);
+                    try {
+                        encodeRecord(*table, row, 0, result.records.data() + result.count * recordSize);
+                    } catch (const exception &e) {
+                        string line;
+                        for (const auto &field: row) line += (line.empty() ? "" : ",") + string(field);
+                        throw runtime_error(string(e.what()) + " in row '" + line + "'");
+                    }
+                    result.count++;
+                });
+            } catch (const exception &e) {
+                result.error = e.what();
+            }
+
+            lock_guard<mutex> guard(latch);
+            result.done = true;
+            encoded[chunk] = move(result);
+            changed.notify_all();
+        }
+    };
+
+    vector<thread> workers;
+    for (size_t i = 0; i < threads; i++) {
+        workers.emplace_back(worker);
+    }
+    auto finish = [&] {
+        {
+            lock_guard<mutex> guard(latch);
+            stop = true;
+        }
+        changed.notify_all();
+        for (auto &thread: workers) thread.join();
+    };
+
+    // Single appender, in file order
+    size_t imported = 0;
+    try {
+        for (size_t chunk = 0; chunk < chunks.size(); chunk++) {
+            EncodedChunk ready;
+            {
+                unique_lock<mutex> lock(latch);
+                changed.wait(lock, [&] { return encoded[chunk].done; });
+                ready = move(encoded[chunk]);
+            }
+            if (!ready.error.empty()) {
+                throw runtime_error(ready.error);
+            }
+
+            imported += appendRecords(tableName, ready.records.data(), ready.count);
+
+            lock_guard<mutex> guard(latch);
+            appended++;
+            changed.notify_all();
+        }
+    } catch (...) {
+        finish();
+        throw;
+    }
+
+    finish();
+    return imported;
+}
@@ -2,13 +2,38 @@
 // Created by abdallah-selim on 3/11/25.
 //
 #include "../include/Executer.h"
+#include "../include/SecondaryIndex.h"
+#include "../include/BitmapIndex.h"
+#include "../include/BloomFilter.h"
+#include "../include/CsvImport.h"
+#include "../include/Vacuum.h"
+#include "../include/Catalog.h"
+#include <filesystem>
 #include <iostream>
 
 using namespace std;
 
-void executeInsert(const string &tableName, const vector<string> &values) {
-    writeRecord(tableName, values);
-    cout << "✅ Record inserted into " << tableName << endl;
+void executeInsert(const string &tableName, const vector<vector<string>> &rows) {
+    try {
+        if (rows.size() == 1) {
+            writeRecord(tableName, rows[0]);
+            cout << "✅ Record inserted into " << tableName << endl;
+        } else {
+            const size_t inserted = writeRecords(tableName, rows);
+            cout << "✅ " << inserted << " records inserted into " << tableName << endl;
+        }
+    } catch (const exception &e) {
+        cerr << "Error: " << e.what() << endl;
+    }
+}
+
+void executeCopy(const string &tableName, const string &filePath, bool header) {
+    try {
+        const size_t imported = importCsv(tableName, filePath, header);
+        cout << "✅ " << imported << " records copied into " << tableName << endl;
+    } catch (const exception &e) {
+        cerr << "Error: " << e.what() << endl;
+    }
 }
 
 void executeSelect(const string &tableName, const vector<string> &columns, const vector<Condition> &conditions) {
@@ -23,7 +48,66 @@ void executeDelete(const string &tableName, int id) {
     }
 }
 
-void executeCreateTable(const string &tableName, const string &columnsInfo) {
-    createTable(tableName, columnsInfo);
-    cout << "✅ Table '" << tableName << "' created with schema: " << columnsInfo << endl;
+void executeCreateTable(const string &tableName, const string &columnsInfo, TableLayout layout) {
+    createTable(tableName, columnsInfo, layout);
+    cout << "✅ Table '" << tableName << "' created with schema: " << columnsInfo
+         << (layout == TableLayout::Columnar ? " (columnar)" : "") << endl;
+}
+
+void executeCreateIndex(const string &tableName, const string &indexName, const string &columnName) {
+    if (createIndex(tableName, indexName, columnName)) {
+        cout << "✅ Index '" << indexName << "' created on " << tableName << "(" << columnName << ")" << endl;
+    }
+}
+
+void executeDropIndex(const string &tableName, const string &indexName) {
+    if (dropIndex(tableName, indexName)) {
+        cout << "✅ Index '" << indexName << "' dropped from " << tableName << endl;
+    }
+}
+
+void executeCreateBloomFilter(const string &tableName, const string &columnName) {
+    if (createBloomFilter(tableName, columnName)) {
+        cout << "✅ Bloom filter created on " << tableName << "(" << columnName << ")" << endl;
+    }
+}
+
+void executeDropBloomFilter(const string &tableName, const string &columnName) {
+    if (dropBloomFilter(tableName, columnName)) {
+        cout << "✅ Bloom filter dropped from " << tableName << "(" << columnName << ")" << endl;
+    }
+}
+
+void executeCreateBitmapIndex(const string &tableName, const string &columnName) {
+    if (createBitmapIndex(tableName, columnName)) {
+        cout << "✅ Bitmap index created on " << tableName << "(" << columnName << ")" << endl;
+    }
+}
+
+void executeDropBitmapIndex(const string &tableName, const string &columnName) {
+    if (dropBitmapIndex(tableName, columnName)) {
+        cout << "✅ Bitmap index dropped from " << tableName << "(" << columnName << ")" << endl;
+    }
+}
+
+void executeVacuum(const string &tableName) {
+    shared_ptr<const TableInfo> before = catalog().getTable(tableName);
+    const uint64_t sizeBefore = before ? before->header.freeOffset : 0;
+    if (vacuumTable(tableName)) {
+        shared_ptr<const TableInfo> after = catalog().getTable(tableName);
+        const uint64_t sizeAfter = after ? after->header.freeOffset : sizeBefore;
+        cout << "✅ Table '" << tableName << "' vacuumed, " << sizeBefore - sizeAfter << " bytes reclaimed" << endl;
+    }
+}
+
+void executeCompress(const string &tableName) {
+    // The header still counts uncompressed bytes, the file size is what's on disk
+    const string filePath = dataPath + tableName + dataFileType;
+    error_code error;
+    const uintmax_t sizeBefore = filesystem::file_size(filePath, error);
+    if (vacuumTable(tableName, true)) {
+        const uintmax_t sizeAfter = filesystem::file_size(filePath, error);
+        cout << "✅ Table '" << tableName << "' compressed from " << sizeBefore << " to " << sizeAfter << " bytes"
+             << endl;
+    }
 }
@@ -0,0 +1,304 @@
+#include "../include/FilterKernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMDB_X86_KERNELS 1
+#endif
+
+using namespace std;
+
+// ==================== Dispatch ====================
+
+SimdLevel detectSimdLevel() {
+#ifdef SIMDB_X86_KERNELS
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::AVX2;
+    }
+#endif
+    return SimdLevel::Scalar;
+}
+
+static SimdLevel &currentLevel() {
+    static SimdLevel level = detectSimdLevel();
+    return level;
+}
+
+SimdLevel activeSimdLevel() {
+    return currentLevel();
+}
+
+void setSimdLevel(SimdLevel level) {
+    currentLevel() = level == SimdLevel::AVX2 && detectSimdLevel() == SimdLevel::AVX2
+                         ? SimdLevel::AVX2
+                         : SimdLevel::Scalar;
+}
+
+const char *simdLevelName(SimdLevel level) {
+    return level == SimdLevel::AVX2 ? "AVX2" : "scalar";
+}
+
+void selectAll(vector<uint64_t> &selection, size_t count) {
+    selection.assign(selectionWords(count), ~uint64_t(0));
+    if (count % 64 != 0) {
+        selection.back() = (uint64_t(1) << (count % 64)) - 1;
+    }
+}
+
+// ==================== Scalar Kernels ====================
+
+template <typename T, CompareOp Op>
+static void filterScalar(const char *base, size_t stride, size_t count, T operand, uint64_t *selection) {
+    for (size_t word = 0; word < selectionWords(count); word++) {
+        if (selection[word] == 0) continue;
+
+        const size_t rows = min<size_t>(64, count - word * 64);
+        const char *value = base + word * 64 * stride;
+        uint64_t bits = 0;
+        for (size_t i = 0; i < rows; i++, value += stride) {
+            T recordValue;
+            memcpy(&recordValue, value, sizeof(T));
+            bits |= uint64_t(applyComparison<Op>(recordValue, operand)) << i;
+        }
+        selection[word] &= bits;
+    }
+}
+
+template <CompareOp Op>
+static void filterCodesScalar(const uint16_t *codes, size_t count, uint16_t operand, uint64_t *selection) {
+    for (size_t word = 0; word < selectionWords(count); word++) {
+        if (selection[word] == 0) continue;
+
+        const size_t rows = min<size_t>(64, count - word * 64);
+        const uint16_t *code = codes + word * 64;
+        uint64_t bits = 0;
+        for (size_t i = 0; i < rows; i++) {
+            bits |= uint64_t(applyComparison<Op>(code[i], operand)) << i;
+        }
+        selection[word] &= bits;
+    }
+}
+
+static bool andBitmapsScalar(uint64_t *target, const uint64_t *other, size_t words) {
+    uint64_t any = 0;
+    for (size_t i = 0; i < words; i++) {
+        target[i] &= other[i];
+        any |= target[i];
+    }
+    return any != 0;
+}
+
+static void orBitmapsScalar(uint64_t *target, const uint64_t *other, size_t words) {
+    for (size_t i = 0; i < words; i++) {
+        target[i] |= other[i];
+    }
+}
+
+// ==================== AVX2 Kernels ====================
+
+#ifdef SIMDB_X86_KERNELS
+
+// Eight 32-bit values `stride` bytes apart: a plain load when they are packed,
+// a gather otherwise (row-major records)
+__attribute__((target("avx2")))
+static inline __m256i load8(const char *base, size_t stride, __m256i gatherOffsets) {
+    if (stride == sizeof(int32_t)) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(base));
+    }
+    return _mm256_i32gather_epi32(reinterpret_cast<const int *>(base), gatherOffsets, 1);
+}
+
+template <CompareOp Op>
+__attribute__((target("avx2")))
+static inline __m256i compare8(__m256i values, __m256i operand) {
+    const __m256i allOnes = _mm256_set1_epi32(-1);
+    if constexpr (Op == CompareOp::Equal) return _mm256_cmpeq_epi32(values, operand);
+    if constexpr (Op == CompareOp::NotEqual) return _mm256_xor_si256(_mm256_cmpeq_epi32(values, operand), allOnes);
+    if constexpr (Op == CompareOp::Less) return _mm256_cmpgt_epi32(operand, values);
+    if constexpr (Op == CompareOp::LessEqual) return _mm256_xor_si256(_mm256_cmpgt_epi32(values, operand), allOnes);
+    if constexpr (Op == CompareOp::Greater) return _mm256_cmpgt_epi32(values, operand);
+    return _mm256_xor_si256(_mm256_cmpgt_epi32(operand, values), allOnes);
+}
+
+// Ordered predicates except for !=, matching the scalar semantics for NaN
+template <CompareOp Op>
+__attribute__((target("avx2")))
+static inline __m256 compare8(__m256 values, __m256 operand) {
+    if constexpr (Op == CompareOp::Equal) return _mm256_cmp_ps(values, operand, _CMP_EQ_OQ);
+    if constexpr (Op == CompareOp::NotEqual) return _mm256_cmp_ps(values, operand, _CMP_NEQ_UQ);
+    if constexpr (Op == CompareOp::Less) return _mm256_cmp_ps(values, operand, _CMP_LT_OQ);
+    if constexpr (Op == CompareOp::LessEqual) return _mm256_cmp_ps(values, operand, _CMP_LE_OQ);
+    if constexpr (Op == CompareOp::Greater) return _mm256_cmp_ps(values, operand, _CMP_GT_OQ);
+    return _mm256_cmp_ps(values, operand, _CMP_GE_OQ);
+}
+
+template <typename T, CompareOp Op>
+__attribute__((target("avx2")))
+static void filterAvx2(const char *base, size_t stride, size_t count, T operand, uint64_t *selection) {
+    const int32_t step = static_cast<int32_t>(stride);
+    const __m256i gatherOffsets = _mm256_setr_epi32(0, step, 2 * step, 3 * step,
+                                                    4 * step, 5 * step, 6 * step, 7 * step);
+
+    for (size_t word = 0; word < selectionWords(count); word++) {
+        if (selection[word] == 0) continue;
+
+        const size_t rows = min<size_t>(64, count - word * 64);
+        const char *value = base + word * 64 * stride;
+        uint64_t bits = 0;
+        size_t i = 0;
+
+        for (; i + 8 <= rows; i += 8, value += 8 * stride) {
+            const __m256i raw = load8(value, stride, gatherOffsets);
+            int mask;
+            if constexpr (is_same_v<T, float>) {
+                mask = _mm256_movemask_ps(compare8<Op>(_mm256_castsi256_ps(raw), _mm256_set1_ps(operand)));
+            } else {
+                mask = _mm256_movemask_ps(_mm256_castsi256_ps(compare8<Op>(raw, _mm256_set1_epi32(operand))));
+            }
+            bits |= uint64_t(static_cast<uint8_t>(mask)) << i;
+        }
+
+        for (; i < rows; i++, value += stride) {
+            T recordValue;
+            memcpy(&recordValue, value, sizeof(T));
+            bits |= uint64_t(applyComparison<Op>(recordValue, operand)) << i;
+        }
+        selection[word] &= bits;
+    }
+}
+
+// Sixteen codes per compare; the 16-bit lane masks are packed to bytes so
+// movemask yields one bit per code
+template <CompareOp Op>
+__attribute__((target("avx2")))
+static void filterCodesAvx2(const uint16_t *codes, size_t count, uint16_t operand, uint64_t *selection) {
+    const __m256i operands = _mm256_set1_epi16(static_cast<short>(operand));
+    for (size_t word = 0; word < selectionWords(count); word++) {
+        if (selection[word] == 0) continue;
+
+        const size_t rows = min<size_t>(64, count - word * 64);
+        const uint16_t *code = codes + word * 64;
+        uint64_t bits = 0;
+        size_t i = 0;
+        for (; i + 16 <= rows; i += 16) {
+            const __m256i equal = _mm256_cmpeq_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(code + i)),
+                                                     operands);
+            const __m128i packed = _mm_packs_epi16(_mm256_castsi256_si128(equal), _mm256_extracti128_si256(equal, 1));
+            uint64_t mask = static_cast<uint16_t>(_mm_movemask_epi8(packed));
+            if constexpr (Op == CompareOp::NotEqual) mask ^= 0xFFFF;
+            bits |= mask << i;
+        }
+        for (; i < rows; i++) {
+            bits |= uint64_t(applyComparison<Op>(code[i], operand)) << i;
+        }
+        selection[word] &= bits;
+    }
+}
+
+// Four words per instruction, the tail word by word
+__attribute__((target("avx2")))
+static bool andBitmapsAvx2(uint64_t *target, const uint64_t *other, size_t words) {
+    __m256i any = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= words; i += 4) {
+        auto *out = reinterpret_cast<__m256i *>(target + i);
+        const __m256i both = _mm256_and_si256(_mm256_loadu_si256(out),
+                                              _mm256_loadu_si256(reinterpret_cast<const __m256i *>(other + i)));
+        _mm256_storeu_si256(out, both);
+        any = _mm256_or_si256(any, both);
+    }
+    const bool left = !_mm256_testz_si256(any, any);
+    return andBitmapsScalar(target + i, other + i, words - i) || left;
+}
+
+__attribute__((target("avx2")))
+static void orBitmapsAvx2(uint64_t *target, const uint64_t *other, size_t words) {
+    size_t i = 0;
+    for (; i + 4 <= words; i += 4) {
+        auto *out = reinterpret_cast<__m256i *>(target + i);
+        _mm256_storeu_si256(out, _mm256_or_si256(_mm256_loadu_si256(out),
+                                                 _mm256_loadu_si256(reinterpret_cast<const __m256i *>(other + i))));
+    }
+    orBitmapsScalar(target + i, other + i, words - i);
+}
+
+#endif
+
+// ==================== Entry Points ====================
+
+template <typename T, CompareOp Op>
+static void filterDispatch(const char *base, size_t stride, size_t count, T operand, uint64_t *selection) {
+#ifdef SIMDB_X86_KERNELS
+    // Gather offsets are 32-bit, very wide records stay on the scalar path
+    if (currentLevel() == SimdLevel::AVX2 && stride <= INT32_MAX / 8) {
+        filterAvx2<T, Op>(base, stride, count, operand, selection);
+        return;
+    }
+#endif
+    filterScalar<T, Op>(base, stride, count, operand, selection);
+}
+
+template <typename T>
+static void filterColumn(const char *base, size_t stride, size_t count, CompareOp op, T operand,
+                         uint64_t *selection) {
+    switch (op) {
+        case CompareOp::Equal: return filterDispatch<T, CompareOp::Equal>(base, stride, count, operand, selection);
+        case CompareOp::NotEqual: return filterDispatch<T, CompareOp::NotEqual>(base, stride, count, operand, selection);
+        case CompareOp::Less: return filterDispatch<T, CompareOp::Less>(base, stride, count, operand, selection);
+        case CompareOp::LessEqual: return filterDispatch<T, CompareOp::LessEqual>(base, stride, count, operand, selection);
+        case CompareOp::Greater: return filterDispatch<T, CompareOp::Greater>(base, stride, count, operand, selection);
+        case CompareOp::GreaterEqual: return filterDispatch<T, CompareOp::GreaterEqual>(base, stride, count, operand, selection);
+    }
+}
+
+void filterInt32(const char *base, size_t stride, size_t count, CompareOp op, int32_t operand,
+                 uint64_t *selection) {
+    filterColumn<int32_t>(base, stride, count, op, operand, selection);
+}
+
+void filterFloat(const char *base, size_t stride, size_t count, CompareOp op, float operand,
+                 uint64_t *selection) {
+    filterColumn<float>(base, stride, count, op, operand, selection);
+}
+
+template <CompareOp Op>
+static void filterCodesDispatch(const uint16_t *codes, size_t count, uint16_t operand, uint64_t *selection) {
+#ifdef SIMDB_X86_KERNELS
+    if (currentLevel() == SimdLevel::AVX2) {
+        filterCodesAvx2<Op>(codes, count, operand, selection);
+        return;
+    }
+#endif
+    filterCodesScalar<Op>(codes, count, operand, selection);
+}
+
+void filterCodes(const uint16_t *codes, size_t count, CompareOp op, int operand, uint64_t *selection) {
+    if (operand < 0) {
+        // Nothing equals a value the dictionary doesn't hold
+        if (op == CompareOp::Equal) fill_n(selection, selectionWords(count), 0);
+        return;
+    }
+    if (op == CompareOp::Equal) {
+        filterCodesDispatch<CompareOp::Equal>(codes, count, operand, selection);
+    } else {
+        filterCodesDispatch<CompareOp::NotEqual>(codes, count, operand, selection);
+    }
+}
+
+bool andBitmaps(uint64_t *target, const uint64_t *other, size_t words) {
+#ifdef SIMDB_X86_KERNELS
+    if (currentLevel() == SimdLevel::AVX2) {
+        return andBitmapsAvx2(target, other, words);
+    }
+#endif
+    return andBitmapsScalar(target, other, words);
+}
+
+void orBitmaps(uint64_t *target, const uint64_t *other, size_t words) {
+#ifdef SIMDB_X86_KERNELS
+    if (currentLevel() == SimdLevel::AVX2) {
+        orBitmapsAvx2(target, other, words);
+        return;
+    }
+#endif
+    orBitmapsScalar(target, other, words);
+}
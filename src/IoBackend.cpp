@@ -0,0 +1,241 @@
+#include "../include/IoBackend.h"
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+IoBackend ioBackend() {
+    static const IoBackend backend = [] {
+        const char *value = getenv(ioBackendEnv.c_str());
+        if (!value || string(value) == "pool") {
+            return IoBackend::BufferPool;
+        }
+        if (string(value) == "mmap") {
+            return IoBackend::Mmap;
+        }
+        if (string(value) == "uring") {
+            return IoBackend::Uring;
+        }
+        cerr << "Warning: Unknown " << ioBackendEnv << " '" << value << "', reading through the buffer pool" << endl;
+        return IoBackend::BufferPool;
+    }();
+    return backend;
+}
+
+// ==================== File Mapping ====================
+
+FileMapping::FileMapping(const string &filePath) : filePath(filePath) {
+    void *reserved = mmap(nullptr, mappingReserveBytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                          -1, 0);
+    if (reserved != MAP_FAILED) {
+        base = static_cast<char *>(reserved);
+    }
+}
+
+FileMapping::~FileMapping() {
+    if (base) munmap(base, mappingReserveBytes);
+}
+
+// Map the first `size` bytes of the file over the start of the reservation.
+// MAP_FIXED replaces the old mapping in place, so the addresses don't move.
+bool FileMapping::grow(uint64_t size) {
+    const int fd = open(filePath.c_str(), O_RDONLY);
+    struct stat st{};
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) close(fd);
+        return false;
+    }
+
+    const uint64_t fileSize = st.st_size;
+    bool mappedAll = false;
+    if (fileSize >= size && fileSize <= mappingReserveBytes) {
+        mappedAll = mmap(base, fileSize, PROT_READ, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+        if (mappedAll) mapped = fileSize;
+    }
+    close(fd);
+    return mappedAll;
+}
+
+const char *FileMapping::view(uint64_t offset, size_t length) {
+    if (!base) {
+        return nullptr;
+    }
+    if (offset + length > mapped) {
+        lock_guard<mutex> guard(latch);
+        if (offset + length > mapped && !grow(offset + length)) {
+            return nullptr;
+        }
+    }
+    return base + offset;
+}
+
+void FileMapping::advise(uint64_t offset, uint64_t length, int advice) {
+    const uint64_t end = min<uint64_t>(offset + length, mapped);
+    const uint64_t pageStart = offset & ~uint64_t(sysconf(_SC_PAGESIZE) - 1);
+    if (base && pageStart < end) {
+        madvise(base + pageStart, end - pageStart, advice);
+    }
+}
+
+// ==================== Mapping Cache ====================
+
+FileMapping *MappingCache::get(const string &filePath) {
+    lock_guard<mutex> guard(latch);
+    auto it = mappings.find(filePath);
+    if (it == mappings.end()) {
+        it = mappings.emplace(filePath, make_unique<FileMapping>(filePath)).first;
+    }
+    return it->second.get();
+}
+
+void MappingCache::drop(const string &filePath) {
+    lock_guard<mutex> guard(latch);
+    mappings.erase(filePath);
+}
+
+MappingCache &fileMappings() {
+    static MappingCache cache;
+    return cache;
+}
+
+// ==================== io_uring ====================
+
+IoRing::IoRing(unsigned entries) {
+    io_uring_params params{};
+    const int fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0) {
+        return;
+    }
+
+    submissionRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    completionRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    entryArraySize = params.sq_entries * sizeof(io_uring_sqe);
+    const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap) {
+        submissionRingSize = completionRingSize = max(submissionRingSize, completionRingSize);
+    }
+
+    submissionRing = mmap(nullptr, submissionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                          IORING_OFF_SQ_RING);
+    completionRing = singleMmap ? submissionRing
+                                : mmap(nullptr, completionRingSize, PROT_READ | PROT_WRITE,
+                                       MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    entryArray = mmap(nullptr, entryArraySize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                      IORING_OFF_SQES);
+    if (submissionRing == MAP_FAILED || completionRing == MAP_FAILED || entryArray == MAP_FAILED) {
+        if (submissionRing != MAP_FAILED) munmap(submissionRing, submissionRingSize);
+        if (!singleMmap && completionRing != MAP_FAILED) munmap(completionRing, completionRingSize);
+        if (entryArray != MAP_FAILED) munmap(entryArray, entryArraySize);
+        submissionRing = completionRing = entryArray = nullptr;
+        close(fd);
+        return;
+    }
+
+    char *sq = static_cast<char *>(submissionRing);
+    char *cq = static_cast<char *>(completionRing);
+    sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sqMask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cqMask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    completions = cq + params.cq_off.cqes;
+
+    ringFd = fd;
+    this->entries = params.sq_entries;
+}
+
+IoRing::~IoRing() {
+    if (ringFd < 0) {
+        return;
+    }
+    while (inFlight > 0 && reapOne()) {
+    }
+    if (buffersRegistered) {
+        syscall(__NR_io_uring_register, ringFd, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+    }
+    munmap(entryArray, entryArraySize);
+    if (completionRing != submissionRing) munmap(completionRing, completionRingSize);
+    munmap(submissionRing, submissionRingSize);
+    close(ringFd);
+}
+
+bool IoRing::registerBuffers(const vector<iovec> &buffers) {
+    buffersRegistered = ready() && syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_BUFFERS, buffers.data(),
+                                           buffers.size()) == 0;
+    return buffersRegistered;
+}
+
+void IoRing::queueRead(int fd, const ReadRequest &request, uint64_t tag) {
+    const unsigned tail = *sqTail;
+    const unsigned index = tail & *sqMask;
+    io_uring_sqe &entry = static_cast<io_uring_sqe *>(entryArray)[index];
+    memset(&entry, 0, sizeof(entry));
+    const bool fixed = buffersRegistered && request.bufferIndex >= 0;
+    entry.opcode = fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+    entry.fd = fd;
+    entry.off = request.offset;
+    entry.addr = reinterpret_cast<uint64_t>(request.buffer);
+    entry.len = request.length;
+    entry.buf_index = fixed ? request.bufferIndex : 0;
+    entry.user_data = tag;
+    sqArray[index] = index;
+    __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+
+    expected[tag] = request.length;
+    queued++;
+    inFlight++;
+}
+
+// Hand over the queued reads and take one completion, waiting if none is ready
+bool IoRing::reapOne() {
+    unsigned head = *cqHead;
+    while (queued > 0 || head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+        const bool ready = head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        const int submitted = syscall(__NR_io_uring_enter, ringFd, queued, ready ? 0 : 1, IORING_ENTER_GETEVENTS,
+                                      nullptr, 0);
+        if (submitted < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        queued -= min<unsigned>(submitted, queued);
+        if (ready) break;
+    }
+
+    const io_uring_cqe &completion = static_cast<io_uring_cqe *>(completions)[head & *cqMask];
+    const auto it = expected.find(completion.user_data);
+    completed[completion.user_data] = it != expected.end() && completion.res >= 0 &&
+                                      static_cast<size_t>(completion.res) == it->second;
+    if (it != expected.end()) expected.erase(it);
+    __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+    inFlight--;
+    return true;
+}
+
+bool IoRing::waitFor(uint64_t tag) {
+    while (!completed.count(tag)) {
+        if (!expected.count(tag) || !reapOne()) {
+            return false;
+        }
+    }
+    const bool success = completed[tag];
+    completed.erase(tag);
+    return success;
+}
+
+bool IoRing::readAll(int fd, const vector<ReadRequest> &requests) {
+    bool success = true;
+    size_t next = 0;
+    for (size_t done = 0; done < requests.size(); done++) {
+        while (next < requests.size() && inFlight < entries) {
+            queueRead(fd, requests[next], next);
+            next++;
+        }
+        success = waitFor(done) && success;
+    }
+    return success;
+}
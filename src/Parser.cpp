@@ -1,5 +1,6 @@
 #include "../include/Parser.h"
 #include "../include/Executer.h"
+#include "../include/CsvImport.h"
 #include <algorithm>
 #include <sstream>
 #include <iostream>
@@ -13,10 +14,10 @@ string trim(const string &s) {
     return (first == string::npos || last == string::npos) ? "" : s.substr(first, last - first + 1);
 }
 
-// **🔹 INSERT INTO table_name VALUES (value1, value2, ...)**
+// **🔹 INSERT INTO table_name VALUES (value1, value2, ...)[, (value1, value2, ...), ...]**
 void parseInsert(const string &query) {
     stringstream ss(query);
-    string command, intoPart, tableName, valuesPart;
+    string command, intoPart, tableName;
 
     ss >> command >> intoPart >> tableName;
     if (intoPart != "INTO") {
@@ -31,26 +32,122 @@ void parseInsert(const string &query) {
         return;
     }
 
-    size_t start = query.find('(');
-    size_t end = query.find_last_of(')');
-    if (start == string::npos || end == string::npos || start >= end) {
-        cerr << "Syntax Error: Invalid VALUES format" << endl;
-        return;
+    // One row per parenthesized tuple, tuples separated by commas
+    vector<vector<string>> rows;
+    size_t position = query.find("VALUES") + 6;
+    while (true) {
+        const size_t start = query.find_first_not_of(" \t", position);
+        if (start == string::npos || query[start] != '(') {
+            cerr << "Syntax Error: Invalid VALUES format" << endl;
+            return;
+        }
+
+        size_t end = start + 1;
+        for (bool quoted = false; end < query.size() && (quoted || query[end] != ')'); end++) {
+            if (query[end] == '"') quoted = !quoted;
+        }
+        if (end == query.size()) {
+            cerr << "Syntax Error: Invalid VALUES format" << endl;
+            return;
+        }
+
+        rows.emplace_back();
+        splitCsvLine(string_view(query).substr(start + 1, end - start - 1), rows.back());
+
+        const size_t next = query.find_first_not_of(" \t", end + 1);
+        if (next == string::npos) break;
+        if (query[next] != ',') {
+            cerr << "Syntax Error: Expected ',' between VALUES tuples" << endl;
+            return;
+        }
+        position = next + 1;
     }
 
-    valuesPart = query.substr(start + 1, end - start - 1);
-    stringstream valuesStream(valuesPart);
-    vector<string> values;
-    string value;
+    executeInsert(tableName, rows);
+}
 
-    while (getline(valuesStream, value, ',')) {
-        values.push_back(trim(value));
+// Condition value from a literal: numbers become int or float, the rest is text.
+// A literal whose float rounds onto or past a whole number (16777217.5 becomes
+// 16777216) stays text, so an int column compares it at full precision.
+static Condition makeCondition(const string &columnName, const string &op, const string &value) {
+    if (isdigit(value[0]) || (value[0] == '-' && value.size() > 1 && isdigit(value[1]))) {
+        if (value.find_first_of(".eE") != string::npos) {
+            const float number = stof(value);
+            const double exact = stod(value);
+            if (floor(number) != floor(exact) || (floor(number) == number) != (floor(exact) == exact)) {
+                return {columnName, op, value};
+            }
+            return {columnName, op, number};
+        }
+        return {columnName, op, stoi(value)};
     }
+    return {columnName, op, trim(value)};
+}
+
+static string toUpper(string text) {
+    transform(text.begin(), text.end(), text.begin(), ::toupper);
+    return text;
+}
+
+// **🔹 column OP value [AND column OP value ...], column BETWEEN low AND high,
+// column IN (value, ...)**
+static bool parseConditions(stringstream &ss, vector<Condition> &conditions) {
+    string columnName, op;
+    while (ss >> columnName >> op) {
+        if (toUpper(op) == "IN") {
+            char open = 0;
+            string list;
+            ss >> open;
+            if (open != '(' || !getline(ss, list, ')') || ss.eof()) {
+                cerr << "Syntax Error: Expected 'column IN (value, ...)'" << endl;
+                return false;
+            }
+            vector<variant<int, float, string>> values;
+            stringstream listStream(list);
+            string value;
+            while (getline(listStream, value, ',')) {
+                value = trim(value);
+                if (value.empty()) {
+                    cerr << "Syntax Error: Empty value in IN list" << endl;
+                    return false;
+                }
+                values.push_back(makeCondition(columnName, "=", value).value);
+            }
+            if (values.empty()) {
+                cerr << "Syntax Error: Empty IN list" << endl;
+                return false;
+            }
+            conditions.emplace_back(columnName, move(values));
+        } else if (toUpper(op) == "BETWEEN") {
+            string low, andKeyword, high;
+            ss >> low >> andKeyword >> high;
+            if (low.empty() || toUpper(andKeyword) != "AND" || high.empty()) {
+                cerr << "Syntax Error: Expected 'column BETWEEN low AND high'" << endl;
+                return false;
+            }
+            conditions.push_back(makeCondition(columnName, ">=", low));
+            conditions.push_back(makeCondition(columnName, "<=", high));
+        } else {
+            string value;
+            ss >> value;
+            if (value.empty()) {
+                cerr << "Syntax Error: Missing value for column " << columnName << endl;
+                return false;
+            }
+            conditions.push_back(makeCondition(columnName, op, value));
+        }
 
-    executeInsert(tableName, values);
+        string keyword;
+        if (!(ss >> keyword)) break;
+        if (toUpper(keyword) != "AND") {
+            cerr << "Syntax Error: Expected AND between conditions" << endl;
+            return false;
+        }
+    }
+    return true;
 }
 
-// **🔹 SELECT columns FROM table_name WHERE column OP value**
+// **🔹 SELECT columns FROM table_name [WHERE conditions]**
 void parseSelect(const string &query) {
     stringstream ss(query);
     string command, columnsPart, fromClause, tableName, whereKeyword;
@@ -76,16 +173,8 @@ void parseSelect(const string &query) {
     ss >> whereKeyword;
     transform(whereKeyword.begin(), whereKeyword.end(), whereKeyword.begin(), ::toupper);
 
-    if (whereKeyword == "WHERE") {
-        string columnName, op, value;
-        ss >> columnName >> op >> value;
-        if (!columnName.empty() && !op.empty() && !value.empty()) {
-            if (isdigit(value[0])) {
-                conditions.push_back({columnName, op, stoi(value)});
-            } else {
-                conditions.push_back({columnName, op, trim(value)});
-            }
-        }
+    if (whereKeyword == "WHERE" && !parseConditions(ss, conditions)) {
+        return;
     }
 
     executeSelect(tableName, columns, conditions);
@@ -112,7 +201,7 @@ void parseDelete(const string &query) {
     executeDelete(tableName, id);
 }
 
-// **🔹 CREATE TABLE table_name (column1 TYPE, column2 TYPE, ...)**
+// **🔹 CREATE TABLE table_name (column1 TYPE, column2 TYPE, ...) [WITH (layout = row|columnar)]**
 void parseCreateTable(const string &query) {
     stringstream ss(query);
     string command, tableWord, tableName;
@@ -123,22 +212,202 @@ void parseCreateTable(const string &query) {
         return;
     }
 
+    // The column list ends at the parenthesis matching the first one; types like string(20) nest
     size_t start = query.find('(');
-    size_t end = query.find_last_of(')');
-    if (start == string::npos || end == string::npos || start >= end) {
+    size_t end = start;
+    for (int depth = 0; end != string::npos && end < query.size(); end++) {
+        if (query[end] == '(') depth++;
+        if (query[end] == ')' && --depth == 0) break;
+    }
+    if (start == string::npos || end >= query.size()) {
         cerr << "Syntax Error: Invalid CREATE TABLE format" << endl;
         return;
     }
 
+    TableLayout layout = TableLayout::Row;
+    string withClause = query.substr(end + 1);
+    withClause.erase(remove_if(withClause.begin(), withClause.end(), ::isspace), withClause.end());
+    withClause = toUpper(withClause);
+    if (withClause == "WITH(LAYOUT=COLUMNAR)") {
+        layout = TableLayout::Columnar;
+    } else if (!withClause.empty() && withClause != "WITH(LAYOUT=ROW)") {
+        cerr << "Syntax Error: Expected 'WITH (layout = row)' or 'WITH (layout = columnar)'" << endl;
+        return;
+    }
+
     string columnsInfo = query.substr(start + 1, end - start - 1);
-    executeCreateTable(tableName, columnsInfo);
+    executeCreateTable(tableName, columnsInfo, layout);
+}
+
+// **🔹 CREATE INDEX index_name ON table_name (column)**
+void parseCreateIndex(const string &query) {
+    stringstream ss(query);
+    string command, indexWord, indexName, onWord;
+
+    ss >> command >> indexWord >> indexName >> onWord;
+    if (toUpper(onWord) != "ON") {
+        cerr << "Syntax Error: Expected ON keyword" << endl;
+        return;
+    }
+
+    size_t start = query.find('(');
+    size_t end = query.find_last_of(')');
+    if (start == string::npos || end == string::npos || start >= end) {
+        cerr << "Syntax Error: Expected 'CREATE INDEX name ON table (column)'" << endl;
+        return;
+    }
+
+    // The table name runs from after ON up to the opening parenthesis
+    const size_t tableStart = query.find_first_not_of(" \t", static_cast<size_t>(ss.tellg()));
+    const string tableName = trim(query.substr(tableStart, start - tableStart));
+    const string columnName = trim(query.substr(start + 1, end - start - 1));
+    if (tableName.empty() || columnName.empty()) {
+        cerr << "Syntax Error: Expected 'CREATE INDEX name ON table (column)'" << endl;
+        return;
+    }
+
+    executeCreateIndex(tableName, indexName, columnName);
+}
+
+// **🔹 DROP INDEX index_name ON table_name**
+void parseDropIndex(const string &query) {
+    stringstream ss(query);
+    string command, indexWord, indexName, onWord, tableName;
+
+    ss >> command >> indexWord >> indexName >> onWord >> tableName;
+    if (toUpper(indexWord) != "INDEX" || toUpper(onWord) != "ON" || tableName.empty()) {
+        cerr << "Syntax Error: Expected 'DROP INDEX name ON table'" << endl;
+        return;
+    }
+
+    executeDropIndex(tableName, indexName);
+}
+
+// **🔹 CREATE BLOOM FILTER ON table_name (column) / DROP BLOOM FILTER ON table_name (column)**
+void parseBloomFilter(const string &query) {
+    stringstream ss(query);
+    string command, bloomWord, filterWord, onWord;
+
+    ss >> command >> bloomWord >> filterWord >> onWord;
+    command = toUpper(command);
+    const size_t start = query.find('(');
+    const size_t end = query.find_last_of(')');
+    if (toUpper(filterWord) != "FILTER" || toUpper(onWord) != "ON" || start == string::npos ||
+        end == string::npos || start >= end) {
+        cerr << "Syntax Error: Expected '" << command << " BLOOM FILTER ON table (column)'" << endl;
+        return;
+    }
+
+    const size_t tableStart = query.find_first_not_of(" \t", static_cast<size_t>(ss.tellg()));
+    const string tableName = trim(query.substr(tableStart, start - tableStart));
+    const string columnName = trim(query.substr(start + 1, end - start - 1));
+    if (tableName.empty() || columnName.empty()) {
+        cerr << "Syntax Error: Expected '" << command << " BLOOM FILTER ON table (column)'" << endl;
+        return;
+    }
+
+    if (command == "CREATE") {
+        executeCreateBloomFilter(tableName, columnName);
+    } else {
+        executeDropBloomFilter(tableName, columnName);
+    }
+}
+
+// **🔹 CREATE BITMAP INDEX ON table_name (column) / DROP BITMAP INDEX ON table_name (column)**
+void parseBitmapIndex(const string &query) {
+    stringstream ss(query);
+    string command, bitmapWord, indexWord, onWord;
+
+    ss >> command >> bitmapWord >> indexWord >> onWord;
+    command = toUpper(command);
+    const size_t start = query.find('(');
+    const size_t end = query.find_last_of(')');
+    if (toUpper(indexWord) != "INDEX" || toUpper(onWord) != "ON" || start == string::npos ||
+        end == string::npos || start >= end) {
+        cerr << "Syntax Error: Expected '" << command << " BITMAP INDEX ON table (column)'" << endl;
+        return;
+    }
+
+    const size_t tableStart = query.find_first_not_of(" \t", static_cast<size_t>(ss.tellg()));
+    const string tableName = trim(query.substr(tableStart, start - tableStart));
+    const string columnName = trim(query.substr(start + 1, end - start - 1));
+    if (tableName.empty() || columnName.empty()) {
+        cerr << "Syntax Error: Expected '" << command << " BITMAP INDEX ON table (column)'" << endl;
+        return;
+    }
+
+    if (command == "CREATE") {
+        executeCreateBitmapIndex(tableName, columnName);
+    } else {
+        executeDropBitmapIndex(tableName, columnName);
+    }
+}
+
+// **🔹 COPY table_name FROM 'file.csv' [HEADER]**
+void parseCopy(const string &query) {
+    stringstream ss(query);
+    string command, tableName, fromPart;
+
+    ss >> command >> tableName >> fromPart;
+    if (toUpper(fromPart) != "FROM") {
+        cerr << "Syntax Error: Expected FROM keyword" << endl;
+        return;
+    }
+
+    const size_t start = query.find_first_of("'\"");
+    const size_t end = start == string::npos ? string::npos : query.find(query[start], start + 1);
+    if (end == string::npos) {
+        cerr << "Syntax Error: Expected a quoted file path after FROM" << endl;
+        return;
+    }
+
+    stringstream options(query.substr(end + 1));
+    string option;
+    bool header = false;
+    while (options >> option) {
+        if (toUpper(option) != "HEADER") {
+            cerr << "Syntax Error: Unknown COPY option " << option << endl;
+            return;
+        }
+        header = true;
+    }
+
+    executeCopy(tableName, query.substr(start + 1, end - start - 1), header);
+}
+
+// **🔹 VACUUM table_name**
+void parseVacuum(const string &query) {
+    stringstream ss(query);
+    string command, tableName, extra;
+
+    ss >> command >> tableName;
+    if (tableName.empty() || ss >> extra) {
+        cerr << "Syntax Error: Expected 'VACUUM table'" << endl;
+        return;
+    }
+
+    executeVacuum(tableName);
+}
+
+// **🔹 COMPRESS TABLE table_name**
+void parseCompress(const string &query) {
+    stringstream ss(query);
+    string command, keyword, tableName, extra;
+
+    ss >> command >> keyword >> tableName;
+    if (toUpper(keyword) != "TABLE" || tableName.empty() || ss >> extra) {
+        cerr << "Syntax Error: Expected 'COMPRESS TABLE table'" << endl;
+        return;
+    }
+
+    executeCompress(tableName);
 }
 
 // **🔹 Main Function: Determines which SQL command to parse**
 void executeQuery(const string &query) {
     stringstream ss(query);
-    string command;
-    ss >> command;
+    string command, object;
+    ss >> command >> object;
 
     transform(command.begin(), command.end(), command.begin(), ::toupper);
 
@@ -148,8 +417,22 @@ void executeQuery(const string &query) {
         parseSelect(query);
     } else if (command == "DELETE") {
         parseDelete(query);
+    } else if (command == "CREATE" && toUpper(object) == "INDEX") {
+        parseCreateIndex(query);
+    } else if ((command == "CREATE" || command == "DROP") && toUpper(object) == "BLOOM") {
+        parseBloomFilter(query);
+    } else if ((command == "CREATE" || command == "DROP") && toUpper(object) == "BITMAP") {
+        parseBitmapIndex(query);
     } else if (command == "CREATE") {
         parseCreateTable(query);
+    } else if (command == "COPY") {
+        parseCopy(query);
+    } else if (command == "DROP") {
+        parseDropIndex(query);
+    } else if (command == "VACUUM") {
+        parseVacuum(query);
+    } else if (command == "COMPRESS") {
+        parseCompress(query);
     } else {
         cerr << "❌ Error: Unsupported SQL command" << endl;
     }
@@ -0,0 +1,218 @@
+#include "../include/Planner.h"
+#include "../include/BTree.h"
+#include "../include/BitmapIndex.h"
+#include "../include/BufferPool.h"
+#include "../include/ZoneMap.h"
+
+using namespace std;
+
+string AccessPath::describe() const {
+    switch (type) {
+        case AccessPathType::FullScan:
+            if (zoneMapped) {
+                return string("full table scan (") + (bloomFiltered ? "zone map and Bloom filters: " : "zone map: ") +
+                       to_string(zonesScanned) + " of " + to_string(zoneCount) + " zones)";
+            }
+            return "full table scan";
+        case AccessPathType::IdLookup:
+            if (lowId == highId) return "ID index point lookup (ID = " + to_string(lowId) + ")";
+            return "ID index range scan (ID " + to_string(lowId) + " .. " + to_string(highId) + ")";
+        case AccessPathType::IdList:
+            return "ID index batched lookup (" + to_string(ids.size()) + " IDs)";
+        case AccessPathType::IndexScan:
+            return "B+Tree index " + index->name + " on " + columnName +
+                   (lowKey && highKey && *lowKey == *highKey ? " (point lookup)" : " (range scan)");
+        case AccessPathType::BitmapScan: {
+            string columns;
+            for (const auto &column: bitmapColumns) {
+                columns += (columns.empty() ? "" : " AND ") + column;
+            }
+            return string(bitmapColumns.size() > 1 ? "bitmap indexes on " : "bitmap index on ") + columns + " (" +
+                   to_string(ids.size()) + " IDs)";
+        }
+        case AccessPathType::Empty:
+            return "no records can match";
+    }
+    return "";
+}
+
+static AccessPath planIdLookup(const TableInfo &table, const vector<CompiledPredicate> &predicates) {
+    // Every ID in [0, nextRecordId) has an ID map entry; deleted ones are holes
+    long long low = 0;
+    long long high = static_cast<long long>(table.header.nextRecordId) - 1;
+    bool usesIndex = false;
+    optional<vector<int>> ids; // intersection of the IN lists on ID
+
+    const int idColumn = table.columnIndex(ID_COLUMN);
+    for (const auto &predicate: predicates) {
+        if (predicate.columnIndex == idColumn && predicate.isInList()) {
+            // Fractional values can't match an int column and are left out
+            vector<int> values;
+            for (const auto &alternative: predicate.anyOf) {
+                if (alternative.kind == KernelKind::Int) values.push_back(alternative.intValue);
+            }
+            sort(values.begin(), values.end());
+            values.erase(unique(values.begin(), values.end()), values.end());
+            if (ids) {
+                vector<int> both;
+                set_intersection(ids->begin(), ids->end(), values.begin(), values.end(), back_inserter(both));
+                values = move(both);
+            }
+            ids = move(values);
+            usesIndex = true;
+            continue;
+        }
+        if (predicate.columnIndex != idColumn || predicate.kind != KernelKind::Int) {
+            continue;
+        }
+
+        const long long value = predicate.intValue;
+        switch (predicate.op) {
+            case CompareOp::Equal:
+                low = max(low, value);
+                high = min(high, value);
+                break;
+            case CompareOp::Less:
+                high = min(high, value - 1);
+                break;
+            case CompareOp::LessEqual:
+                high = min(high, value);
+                break;
+            case CompareOp::Greater:
+                low = max(low, value + 1);
+                break;
+            case CompareOp::GreaterEqual:
+                low = max(low, value);
+                break;
+            case CompareOp::NotEqual:
+                continue; // left to the filter
+        }
+        usesIndex = true;
+    }
+
+    AccessPath path;
+    if (!usesIndex) {
+        return path;
+    }
+    if (low > high) {
+        path.type = AccessPathType::Empty;
+        return path;
+    }
+
+    if (ids) {
+        const auto first = lower_bound(ids->begin(), ids->end(), low);
+        const auto last = upper_bound(ids->begin(), ids->end(), high);
+        path.ids.assign(first, last);
+        path.type = path.ids.empty() ? AccessPathType::Empty : AccessPathType::IdList;
+        return path;
+    }
+
+    path.type = AccessPathType::IdLookup;
+    path.lowId = static_cast<int>(low);
+    path.highId = static_cast<int>(high);
+    return path;
+}
+
+static AccessPath planIndexScan(const TableInfo &table, const vector<CompiledPredicate> &predicates) {
+    AccessPath best;
+    int bestScore = 0;
+
+    for (const auto &index: table.indexes) {
+        const ColumnInfo &column = table.columns[index.columnIndex];
+        const ColumnType keyType = table.columnTypes[index.columnIndex];
+        auto less = [&](const string &a, const string &b) {
+            return compareKeys(keyType, column.size, a.data(), b.data()) < 0;
+        };
+
+        AccessPath path;
+        int score = 0;
+        for (const auto &predicate: predicates) {
+            if (predicate.columnIndex != index.columnIndex || predicate.op == CompareOp::NotEqual ||
+                predicate.isInList()) {
+                continue;
+            }
+            const optional<string> key = predicateKey(table, predicate);
+            if (!key) {
+                continue;
+            }
+
+            // Strict bounds are widened to inclusive ones, the filter drops the boundary
+            const bool lower = predicate.op == CompareOp::Equal || predicate.op == CompareOp::Greater ||
+                               predicate.op == CompareOp::GreaterEqual;
+            const bool upper = predicate.op == CompareOp::Equal || predicate.op == CompareOp::Less ||
+                               predicate.op == CompareOp::LessEqual;
+            if (lower && (!path.lowKey || less(*path.lowKey, *key))) path.lowKey = key;
+            if (upper && (!path.highKey || less(*key, *path.highKey))) path.highKey = key;
+            score = max(score, predicate.op == CompareOp::Equal ? 2 : 1);
+        }
+
+        if (score > bestScore) {
+            bestScore = score;
+            best = path;
+            best.type = AccessPathType::IndexScan;
+            best.index = &index;
+            best.columnName = column.name;
+            if (best.lowKey && best.highKey && less(*best.highKey, *best.lowKey)) {
+                best.type = AccessPathType::Empty;
+            }
+        }
+    }
+    return best;
+}
+
+// The bitmaps are combined right away, their IDs decide whether to use them
+static AccessPath planBitmapScan(const TableInfo &table, const vector<CompiledPredicate> &predicates,
+                                 size_t minPredicates) {
+    AccessPath path;
+    vector<const CompiledPredicate *> answered;
+    for (const auto &predicate: predicates) {
+        if (bitmapCheckable(table, predicate)) {
+            answered.push_back(&predicate);
+            path.bitmapColumns.push_back(table.columns[predicate.columnIndex].name);
+        }
+    }
+    if (answered.size() < minPredicates) {
+        return {};
+    }
+    if (!bitmapMatches(table, answered, path.ids)) {
+        cerr << "Warning: Failed to read the bitmap indexes of " << table.name << ", scanning instead" << endl;
+        return {};
+    }
+
+    // Fetching a record by ID costs about a page read, with more matches than
+    // the table has pages a scan is cheaper
+    if (path.ids.size() > table.header.freeOffset / PAGE_SIZE) {
+        return {};
+    }
+    path.type = path.ids.empty() ? AccessPathType::Empty : AccessPathType::BitmapScan;
+    return path;
+}
+
+AccessPath planAccessPath(const TableInfo &table, const vector<CompiledPredicate> &predicates) {
+    AccessPath path = planIdLookup(table, predicates);
+    if (path.type != AccessPathType::FullScan) {
+        return path;
+    }
+    path = planIndexScan(table, predicates);
+    if (path.type != AccessPathType::Empty) {
+        // A single bitmap finds no fewer records than a B+Tree point lookup
+        const bool pointLookup = path.type == AccessPathType::IndexScan && path.lowKey && path.highKey &&
+                                 *path.lowKey == *path.highKey;
+        AccessPath bitmaps = planBitmapScan(table, predicates, pointLookup ? 2 : 1);
+        if (bitmaps.type != AccessPathType::FullScan) {
+            return bitmaps;
+        }
+    }
+    if (path.type != AccessPathType::FullScan) {
+        return path;
+    }
+
+    path.zoneMapped = zoneSlotRanges(table, predicates, path.slotRanges, path.zonesScanned, path.bloomFiltered);
+    if (path.zoneMapped) {
+        path.zoneCount = (table.header.slotCount + zoneRecords - 1) / zoneRecords;
+        if (path.zonesScanned == 0 && path.zoneCount > 0) {
+            path.type = AccessPathType::Empty;
+        }
+    }
+    return path;
+}
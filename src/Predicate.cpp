@@ -0,0 +1,258 @@
+#include "../include/Predicate.h"
+#include "../include/FilterKernels.h"
+
+using namespace std;
+
+// ==================== Kernels ====================
+
+template <CompareOp Op>
+static bool intKernel(const CompiledPredicate &predicate, const char *record) {
+    int value;
+    memcpy(&value, record + predicate.offset, sizeof(int));
+    return applyComparison<Op>(value, predicate.intValue);
+}
+
+template <CompareOp Op>
+static bool floatKernel(const CompiledPredicate &predicate, const char *record) {
+    float value;
+    memcpy(&value, record + predicate.offset, sizeof(float));
+    return applyComparison<Op>(value, predicate.floatValue);
+}
+
+// int column compared against a fractional literal, e.g. Age >= 4.5
+template <CompareOp Op>
+static bool intAsFloatKernel(const CompiledPredicate &predicate, const char *record) {
+    int value;
+    memcpy(&value, record + predicate.offset, sizeof(int));
+    return applyComparison<Op>(static_cast<double>(value), predicate.doubleValue);
+}
+
+template <CompareOp Op>
+static bool stringKernel(const CompiledPredicate &predicate, const char *record) {
+    const char *value = record + predicate.offset;
+    const string_view recordValue(value, strnlen(value, predicate.size));
+    return applyComparison<Op>(recordValue.compare(predicate.stringValue), 0);
+}
+
+// IN list of ints, alternatives sorted by value
+static bool intInKernel(const CompiledPredicate &predicate, const char *record) {
+    int value;
+    memcpy(&value, record + predicate.offset, sizeof(int));
+    const auto it = lower_bound(predicate.anyOf.begin(), predicate.anyOf.end(), value,
+                                [](const CompiledPredicate &alternative, int v) { return alternative.intValue < v; });
+    return it != predicate.anyOf.end() && it->intValue == value;
+}
+
+static bool anyOfKernel(const CompiledPredicate &predicate, const char *record) {
+    for (const auto &alternative: predicate.anyOf) {
+        if (alternative.matches(record)) return true;
+    }
+    return false;
+}
+
+template <CompareOp Op>
+static CompiledPredicate::Kernel kernelFor(KernelKind kind) {
+    switch (kind) {
+        case KernelKind::Int: return intKernel<Op>;
+        case KernelKind::Float: return floatKernel<Op>;
+        case KernelKind::IntAsFloat: return intAsFloatKernel<Op>;
+        case KernelKind::String: return stringKernel<Op>;
+    }
+    return nullptr;
+}
+
+static CompiledPredicate::Kernel bindKernel(KernelKind kind, CompareOp op) {
+    switch (op) {
+        case CompareOp::Equal: return kernelFor<CompareOp::Equal>(kind);
+        case CompareOp::NotEqual: return kernelFor<CompareOp::NotEqual>(kind);
+        case CompareOp::Less: return kernelFor<CompareOp::Less>(kind);
+        case CompareOp::LessEqual: return kernelFor<CompareOp::LessEqual>(kind);
+        case CompareOp::Greater: return kernelFor<CompareOp::Greater>(kind);
+        case CompareOp::GreaterEqual: return kernelFor<CompareOp::GreaterEqual>(kind);
+    }
+    return nullptr;
+}
+
+// ==================== Compilation ====================
+
+template <typename Number>
+static bool parseNumber(const string &text, Number &result) {
+    try {
+        size_t parsed = 0;
+        result = is_same_v<Number, float> ? stof(text, &parsed) : stod(text, &parsed);
+        return parsed == text.size();
+    } catch (const exception &) {
+        return false;
+    }
+}
+
+// Bring the condition value to the column's type. Numeric columns accept
+// numeric strings, string columns accept any literal in its text form.
+static bool bindOperand(CompiledPredicate &predicate, const variant<int, float, string> &value) {
+    KernelKind &kind = predicate.kind;
+    switch (predicate.type) {
+        case ColumnType::Int:
+            kind = KernelKind::Int;
+            if (holds_alternative<int>(value)) {
+                predicate.intValue = get<int>(value);
+                return true;
+            }
+            if (holds_alternative<float>(value)) {
+                predicate.doubleValue = get<float>(value);
+            } else if (!parseNumber(get<string>(value), predicate.doubleValue)) {
+                return false;
+            }
+            // Whole literals keep the exact integer comparison
+            if (floor(predicate.doubleValue) == predicate.doubleValue && fabs(predicate.doubleValue) < 2147483648.0) {
+                predicate.intValue = static_cast<int>(predicate.doubleValue);
+            } else {
+                kind = KernelKind::IntAsFloat;
+            }
+            return true;
+
+        case ColumnType::Float:
+            kind = KernelKind::Float;
+            if (holds_alternative<int>(value)) {
+                predicate.floatValue = static_cast<float>(get<int>(value));
+            } else if (holds_alternative<float>(value)) {
+                predicate.floatValue = get<float>(value);
+            } else if (!parseNumber(get<string>(value), predicate.floatValue)) {
+                return false;
+            }
+            return true;
+
+        case ColumnType::String:
+            kind = KernelKind::String;
+            if (holds_alternative<int>(value)) {
+                predicate.stringValue = to_string(get<int>(value));
+            } else if (holds_alternative<float>(value)) {
+                ostringstream text;
+                text << get<float>(value);
+                predicate.stringValue = text.str();
+            } else {
+                predicate.stringValue = get<string>(value);
+            }
+            return true;
+    }
+    return false;
+}
+
+bool compilePredicates(const TableInfo &table, const vector<Condition> &conditions,
+                       vector<CompiledPredicate> &predicates) {
+    predicates.clear();
+    predicates.reserve(conditions.size());
+
+    for (const auto &condition: conditions) {
+        CompiledPredicate predicate;
+        predicate.columnIndex = table.columnIndex(condition.columnName);
+        if (predicate.columnIndex == -1) {
+            cerr << "Warning: Condition column '" << condition.columnName << "' not found" << endl;
+            return false;
+        }
+
+        const bool inList = condition.operatorType == "IN";
+        if (!inList && !parseCompareOp(condition.operatorType, predicate.op)) {
+            cerr << "Warning: Unsupported operator '" << condition.operatorType << "'" << endl;
+            return false;
+        }
+
+        predicate.offset = table.columnOffsets[predicate.columnIndex];
+        predicate.size = table.columns[predicate.columnIndex].size;
+        predicate.type = table.columnTypes[predicate.columnIndex];
+
+        // An IN list compiles to one equality predicate per value
+        vector<variant<int, float, string>> operands = condition.values;
+        if (!inList) operands = {condition.value};
+        vector<CompiledPredicate> alternatives;
+        for (const auto &operand: operands) {
+            CompiledPredicate alternative = predicate;
+            if (!bindOperand(alternative, operand)) {
+                cerr << "Warning: Value for column '" << condition.columnName << "' does not match its type" << endl;
+                return false;
+            }
+            alternative.kernel = bindKernel(alternative.kind, alternative.op);
+            alternatives.push_back(move(alternative));
+        }
+
+        if (!inList) {
+            predicates.push_back(move(alternatives[0]));
+            continue;
+        }
+        const bool allInts = all_of(alternatives.begin(), alternatives.end(), [](const CompiledPredicate &alternative) {
+            return alternative.kind == KernelKind::Int;
+        });
+        if (allInts) {
+            sort(alternatives.begin(), alternatives.end(),
+                 [](const CompiledPredicate &a, const CompiledPredicate &b) { return a.intValue < b.intValue; });
+        }
+        predicate.kind = alternatives[0].kind;
+        predicate.kernel = allInts ? intInKernel : anyOfKernel;
+        predicate.anyOf = move(alternatives);
+        predicates.push_back(move(predicate));
+    }
+    return true;
+}
+
+optional<string> predicateKey(const TableInfo &table, const CompiledPredicate &predicate) {
+    string key(table.columns[predicate.columnIndex].size, '\0');
+    switch (predicate.kind) {
+        case KernelKind::Int:
+            memcpy(key.data(), &predicate.intValue, sizeof(int32_t));
+            return key;
+        case KernelKind::Float:
+            memcpy(key.data(), &predicate.floatValue, sizeof(float));
+            return key;
+        case KernelKind::String:
+            // A literal longer than the column is cut to the column width. The
+            // filter re-checks every record, so a wider match is safe.
+            memcpy(key.data(), predicate.stringValue.data(), min(key.size(), predicate.stringValue.size()));
+            return key;
+        case KernelKind::IntAsFloat:
+            return nullopt;
+    }
+    return nullopt;
+}
+
+// ==================== Batch Evaluation ====================
+
+void filterBatch(const vector<CompiledPredicate> &predicates, const char *records, size_t count,
+                 int recordSize, vector<uint64_t> &selection, const vector<CodedOperand> &coded) {
+    selectAll(selection, count);
+    auto hasCodes = [&](size_t i) { return i < coded.size() && coded[i].codes; };
+
+    // Vectorized predicates first, they are the cheapest per row
+    for (size_t i = 0; i < predicates.size(); i++) {
+        const CompiledPredicate &predicate = predicates[i];
+        if (predicate.isInList()) {
+            continue;
+        }
+        if (hasCodes(i)) {
+            filterCodes(coded[i].codes, count, predicate.op, coded[i].code, selection.data());
+        } else if (predicate.kind == KernelKind::Int) {
+            filterInt32(records + predicate.offset, recordSize, count, predicate.op, predicate.intValue,
+                        selection.data());
+        } else if (predicate.kind == KernelKind::Float) {
+            filterFloat(records + predicate.offset, recordSize, count, predicate.op, predicate.floatValue,
+                        selection.data());
+        }
+    }
+
+    for (size_t i = 0; i < predicates.size(); i++) {
+        const CompiledPredicate &predicate = predicates[i];
+        if (!predicate.isInList() &&
+            (predicate.kind == KernelKind::Int || predicate.kind == KernelKind::Float || hasCodes(i))) {
+            continue;
+        }
+
+        for (size_t word = 0; word < selection.size(); word++) {
+            uint64_t bits = selection[word];
+            while (bits) {
+                const size_t row = word * 64 + __builtin_ctzll(bits);
+                bits &= bits - 1;
+                if (!predicate.matches(records + row * recordSize)) {
+                    selection[word] &= ~(uint64_t(1) << (row % 64));
+                }
+            }
+        }
+    }
+}
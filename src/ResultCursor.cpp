@@ -0,0 +1,209 @@
+#include "../include/ResultCursor.h"
+#include "../include/BTree.h"
+#include "../include/Columnar.h"
+
+using namespace std;
+
+ResultCursor::ResultCursor(const string &tableName, const vector<string> &columnsToReturn,
+                           const vector<Condition> &conditions)
+    : reading(catalog().swapLatch()) {
+    // Header, schema and column offsets come from the catalog
+    table = catalog().getTable(tableName);
+    if (!table) {
+        cerr << "Error opening data file: " << dataPath + tableName + dataFileType << endl;
+        return;
+    }
+
+    // Determine which columns to return
+    const bool returnAllColumns = (columnsToReturn.size() == 1 && columnsToReturn[0] == "*");
+    if (returnAllColumns) {
+        for (size_t i = 0; i < table->columns.size(); i++) {
+            columnIndices.push_back(i);
+            names.push_back(table->columns[i].name);
+        }
+    } else {
+        for (const auto &columnName: columnsToReturn) {
+            const int index = table->columnIndex(columnName);
+            if (index == -1) {
+                cerr << "Warning: Column '" << columnName << "' not found in schema" << endl;
+                continue;
+            }
+            columnIndices.push_back(index);
+            names.push_back(columnName);
+        }
+    }
+
+    // Resolve columns, types and operators once for the whole query
+    if (!compilePredicates(*table, conditions, predicates)) {
+        return;
+    }
+
+    // Deleted slots are still scanned; drop them before the user's conditions
+    if (table->header.freeSlots > 0) {
+        vector<CompiledPredicate> live;
+        compilePredicates(*table, {Condition(ID_COLUMN, "!=", tombstoneId)}, live);
+        predicates.insert(predicates.begin(), live.begin(), live.end());
+    }
+
+    // A columnar table only reads the columns that are returned or filtered on
+    vector<int> readColumns = columnIndices;
+    for (const auto &predicate: predicates) {
+        readColumns.push_back(predicate.columnIndex);
+    }
+    readColumns = withIdColumn(*table, move(readColumns));
+    auto lookup = [&](auto &&...arguments) {
+        auto iterator = make_unique<IndexLookupIterator>(tableName, table->recordSize,
+                                                         forward<decltype(arguments)>(arguments)...);
+        iterator->readColumns(*table, readColumns);
+        return iterator;
+    };
+
+    // Narrow the input with the ID index, a B+Tree index or bitmap indexes when the conditions allow it
+    path = planAccessPath(*table, predicates);
+    switch (path.type) {
+        case AccessPathType::FullScan: {
+            auto scan = make_unique<TableScanIterator>(tableName, table->recordSize, table->header.freeOffset);
+            scan->readColumns(*table, readColumns);
+            if (path.zoneMapped) {
+                scan->restrictToSlots(path.slotRanges);
+            }
+            source = move(scan);
+            break;
+        }
+        case AccessPathType::IdLookup:
+            source = lookup(path.lowId, path.highId);
+            break;
+        case AccessPathType::IndexScan: {
+            // Fetch in ID order so neighbouring records share reads
+            const int column = path.index->columnIndex;
+            BTree tree(path.index->filePath, table->columnTypes[column], table->columns[column].size);
+            vector<int> ids;
+            const bool scanned = tree.scanRange(path.lowKey ? path.lowKey->data() : nullptr,
+                                                path.highKey ? path.highKey->data() : nullptr,
+                                                [&](const char *, int id) {
+                                                    ids.push_back(id);
+                                                    return true;
+                                                });
+            if (!scanned) {
+                cerr << "Error: Failed to scan index " << path.index->name << endl;
+                return;
+            }
+            sort(ids.begin(), ids.end());
+            source = lookup(move(ids));
+            break;
+        }
+        case AccessPathType::IdList:
+        case AccessPathType::BitmapScan:
+            source = lookup(path.ids);
+            break;
+        case AccessPathType::Empty:
+            source = lookup(0, -1);
+            break;
+    }
+}
+
+// Decode one projected column for the selected rows of the current chunk
+void ResultCursor::decodeColumn(const ColumnInfo &column, ColumnType type, int offset, ColumnVector &vector) const {
+    const int recordSize = table->recordSize;
+    vector.type = type;
+    vector.clear();
+
+    switch (type) {
+        case ColumnType::Int:
+            vector.ints.resize(selectedRows.size());
+            for (size_t i = 0; i < selectedRows.size(); i++) {
+                memcpy(&vector.ints[i], records + selectedRows[i] * recordSize + offset, sizeof(int32_t));
+            }
+            break;
+        case ColumnType::Float:
+            vector.floats.resize(selectedRows.size());
+            for (size_t i = 0; i < selectedRows.size(); i++) {
+                memcpy(&vector.floats[i], records + selectedRows[i] * recordSize + offset, sizeof(float));
+            }
+            break;
+        case ColumnType::String:
+            vector.strings.resize(selectedRows.size());
+            for (size_t i = 0; i < selectedRows.size(); i++) {
+                const char *value = records + selectedRows[i] * recordSize + offset;
+                vector.strings[i] = string_view(value, strnlen(value, column.size));
+            }
+            break;
+    }
+}
+
+bool ResultCursor::nextBatch(RowBatch &batch) {
+    if (!source) {
+        return false;
+    }
+
+    // Skip chunks where nothing passes the filter
+    while (true) {
+        const size_t count = source->nextBatch(records);
+        if (count == 0) {
+            batch.size = 0;
+            return false;
+        }
+
+        // Encoded string columns compare codes instead of values
+        coded.assign(table->header.layout == TableLayout::Columnar ? predicates.size() : 0, {});
+        for (size_t i = 0; i < coded.size(); i++) {
+            const SegmentDictionary *dictionary;
+            if (predicates[i].comparesCodes() &&
+                (coded[i].codes = source->columnCodes(predicates[i].columnIndex, dictionary))) {
+                coded[i].code = dictionary->codeOf(predicates[i].stringValue);
+            }
+        }
+        filterBatch(predicates, records, count, table->recordSize, selection, coded);
+
+        selectedRows.clear();
+        for (size_t word = 0; word < selection.size(); word++) {
+            for (uint64_t bits = selection[word]; bits; bits &= bits - 1) {
+                selectedRows.push_back(word * 64 + __builtin_ctzll(bits));
+            }
+        }
+        if (!selectedRows.empty()) break;
+    }
+
+    // Late materialization: only projected columns, only selected rows
+    batch.columns.resize(columnIndices.size());
+    for (size_t i = 0; i < columnIndices.size(); i++) {
+        const int column = columnIndices[i];
+        decodeColumn(table->columns[column], table->columnTypes[column], table->columnOffsets[column],
+                     batch.columns[i]);
+    }
+    batch.size = selectedRows.size();
+    returned += batch.size;
+    return true;
+}
+
+bool ResultCursor::next(Row &row) {
+    if (rowPosition == rowBatch.size) {
+        if (!nextBatch(rowBatch)) {
+            return false;
+        }
+        rowPosition = 0;
+    }
+
+    row.resize(rowBatch.columns.size());
+    for (size_t i = 0; i < rowBatch.columns.size(); i++) {
+        const ColumnVector &column = rowBatch.columns[i];
+        switch (column.type) {
+            case ColumnType::Int:
+                row[i] = column.ints[rowPosition];
+                break;
+            case ColumnType::Float:
+                row[i] = column.floats[rowPosition];
+                break;
+            case ColumnType::String:
+                if (auto *text = get_if<string>(&row[i])) {
+                    text->assign(column.strings[rowPosition]); // reuse the cell's buffer
+                } else {
+                    row[i] = string(column.strings[rowPosition]);
+                }
+                break;
+        }
+    }
+
+    rowPosition++;
+    return true;
+}
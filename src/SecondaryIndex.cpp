@@ -0,0 +1,312 @@
+#include "../include/SecondaryIndex.h"
+#include "../include/BufferPool.h"
+#include "../include/Columnar.h"
+#include "../include/TableScan.h"
+#include "../include/WAL.h"
+
+using namespace std;
+
+string indexFilePath(const string &tableName, const string &indexName) {
+    return dataPath + tableName + "." + indexName + btreeFileType;
+}
+
+// ==================== Index Registry ====================
+
+vector<pair<string, string>> readIndexList(const string &tableName) {
+    vector<pair<string, string>> indexes;
+    ifstream file(dataPath + tableName + indexListFileType);
+    string line;
+    while (getline(file, line)) {
+        const size_t separator = line.find(':');
+        if (separator == string::npos) continue;
+        indexes.emplace_back(line.substr(0, separator), line.substr(separator + 1));
+    }
+    return indexes;
+}
+
+static bool writeIndexList(const string &tableName, const vector<pair<string, string>> &indexes) {
+    const string listPath = dataPath + tableName + indexListFileType;
+    if (indexes.empty()) {
+        remove(listPath.c_str());
+        return true;
+    }
+
+    ofstream file(listPath, ios::trunc);
+    if (!file) {
+        cerr << "Error writing index list: " << listPath << endl;
+        return false;
+    }
+    for (const auto &[indexName, columnName]: indexes) {
+        file << indexName << ":" << columnName << "\n";
+    }
+    return true;
+}
+
+// ==================== DDL ====================
+
+// Sorted run of (key, ID) entries spilled by an index build, read back in
+// blocks during the merge
+class IndexRun {
+public:
+    IndexRun(const string &filePath, size_t entrySize) : file(filePath, ios::binary), entrySize(entrySize) {}
+
+    // Next entry, nullptr once the run is used up (or unreadable)
+    const char *next() {
+        if (position == block.size()) {
+            block.resize(max<size_t>(runBlockBytes / entrySize, 1) * entrySize);
+            file.read(block.data(), block.size());
+            block.resize(file.gcount() / entrySize * entrySize);
+            position = 0;
+            if (block.empty()) return nullptr;
+        }
+        const char *entry = block.data() + position;
+        position += entrySize;
+        return entry;
+    }
+
+private:
+    static constexpr size_t runBlockBytes = 256 * 1024;
+    ifstream file;
+    size_t entrySize;
+    vector<char> block;
+    size_t position = 0;
+};
+
+bool buildIndex(const TableInfo &table, int column, const string &filePath, size_t runBytes) {
+    const int offset = table.columnOffsets[column];
+    const int keySize = table.columns[column].size;
+    const size_t entrySize = keySize + sizeof(int32_t);
+    const int idOffset = table.columnOffsets[table.columnIndex(ID_COLUMN)];
+    const ColumnType keyType = table.columnTypes[column];
+    auto before = [&](const char *a, const char *b) {
+        const int order = compareKeys(keyType, keySize, a, b);
+        if (order != 0) return order < 0;
+        int32_t x, y;
+        memcpy(&x, a + keySize, sizeof(x));
+        memcpy(&y, b + keySize, sizeof(y));
+        return x < y;
+    };
+
+    // Collect (value, ID) for every record in one sequential pass. Entries go
+    // into a bounded run, which is sorted (through pointers to its entries)
+    // and spilled whenever it fills up.
+    const size_t runEntries = max<size_t>(runBytes / (entrySize + sizeof(const char *)), 1);
+    vector<char> run;
+    vector<const char *> order;
+    vector<string> runPaths;
+    uint64_t entries = 0;
+    auto sortRun = [&] {
+        order.clear();
+        for (size_t i = 0; i < run.size(); i += entrySize) {
+            order.push_back(run.data() + i);
+        }
+        sort(order.begin(), order.end(), before);
+    };
+    auto removeRuns = [&] {
+        for (const auto &path: runPaths) {
+            remove(path.c_str());
+        }
+    };
+    auto spillRun = [&] {
+        sortRun();
+        runPaths.push_back(filePath + indexRunFileType + to_string(runPaths.size()));
+        ofstream file(runPaths.back(), ios::binary | ios::trunc);
+        for (const char *entry: order) {
+            file.write(entry, entrySize);
+        }
+        run.clear();
+        return static_cast<bool>(file.flush());
+    };
+    {
+        // The header read under the latch matches the files being scanned
+        shared_lock<shared_mutex> reading(catalog().swapLatch());
+        shared_ptr<const TableInfo> current = catalog().getTable(table.name);
+        if (!current) {
+            return false;
+        }
+        run.reserve(min<uint64_t>(runEntries, current->header.numRecords) * entrySize);
+        TableScanIterator scan(table.name, table.recordSize, current->header.freeOffset);
+        scan.readColumns(*current, withIdColumn(*current, {column}));
+        while (const char *record = scan.next()) {
+            int id;
+            memcpy(&id, record + idOffset, sizeof(int));
+            if (id == tombstoneId) continue;
+            if (run.size() == runEntries * entrySize && !spillRun()) {
+                cerr << "Error: Failed to write a sorted run of " << filePath << endl;
+                removeRuns();
+                return false;
+            }
+            run.insert(run.end(), record + offset, record + offset + keySize);
+            const char *idBytes = reinterpret_cast<const char *>(&id);
+            run.insert(run.end(), idBytes, idBytes + sizeof(int));
+            entries++;
+        }
+        if (scan.failed()) {
+            removeRuns();
+            return false;
+        }
+    }
+
+    // A table that fit in one run loads straight from memory
+    BTree tree(filePath, keyType, keySize);
+    if (runPaths.empty()) {
+        sortRun();
+        size_t position = 0;
+        return tree.bulkLoad([&]() -> const char * {
+            return position < order.size() ? order[position++] : nullptr;
+        });
+    }
+    if (!run.empty() && !spillRun()) {
+        cerr << "Error: Failed to write a sorted run of " << filePath << endl;
+        removeRuns();
+        return false;
+    }
+    run.clear();
+    run.shrink_to_fit();
+
+    // k-way merge of the runs, smallest head entry first
+    vector<IndexRun> runs;
+    runs.reserve(runPaths.size());
+    auto later = [&](const pair<const char *, size_t> &a, const pair<const char *, size_t> &b) {
+        return before(b.first, a.first);
+    };
+    priority_queue<pair<const char *, size_t>, vector<pair<const char *, size_t>>, decltype(later)> heads(later);
+    for (size_t i = 0; i < runPaths.size(); i++) {
+        runs.emplace_back(runPaths[i], entrySize);
+        if (const char *entry = runs[i].next()) {
+            heads.emplace(entry, i);
+        }
+    }
+    string current(entrySize, '\0');
+    const bool loaded = tree.bulkLoad([&]() -> const char * {
+        if (heads.empty()) {
+            return nullptr;
+        }
+        const auto [entry, i] = heads.top();
+        heads.pop();
+        memcpy(current.data(), entry, entrySize);
+        if (const char *following = runs[i].next()) {
+            heads.emplace(following, i);
+        }
+        return current.data();
+    });
+    removeRuns();
+
+    // A run that couldn't be read back ends early
+    if (loaded && tree.size() != entries) {
+        cerr << "Error: Failed to read back the sorted runs of " << filePath << endl;
+        return false;
+    }
+    return loaded;
+}
+
+bool createIndex(const string &tableName, const string &indexName, const string &columnName) {
+    // Writers wait, so no record can miss the tree between the build and the
+    // registration
+    lock_guard<mutex> writing(wal().writerLatch());
+    shared_ptr<const TableInfo> table = catalog().getTable(tableName);
+    if (!table) {
+        cerr << "Error: Table " << tableName << " not found" << endl;
+        return false;
+    }
+
+    const int column = table->columnIndex(columnName);
+    if (column == -1) {
+        cerr << "Error: Column '" << columnName << "' not found in " << tableName << endl;
+        return false;
+    }
+    if (columnName == ID_COLUMN) {
+        cerr << "Error: " << ID_COLUMN << " is already indexed by the ID index" << endl;
+        return false;
+    }
+    if (table->columns[column].size > BTree::maxKeySize()) {
+        cerr << "Error: Column '" << columnName << "' is too wide to index (" << table->columns[column].size
+             << " bytes, at most " << BTree::maxKeySize() << ")" << endl;
+        return false;
+    }
+
+    vector<pair<string, string>> indexes = readIndexList(tableName);
+    for (const auto &index: indexes) {
+        if (index.first == indexName) {
+            cerr << "Error: Index " << indexName << " already exists on " << tableName << endl;
+            return false;
+        }
+    }
+
+    // Index DDL isn't logged: start from an empty log, checkpoint the new tree
+    const string filePath = indexFilePath(tableName, indexName);
+    if (!wal().checkpointLocked() || !buildIndex(*table, column, filePath) || !wal().checkpointLocked()) {
+        cerr << "Error: Failed to build index " << indexName << endl;
+        return false;
+    }
+
+    indexes.emplace_back(indexName, columnName);
+    if (!writeIndexList(tableName, indexes)) {
+        return false;
+    }
+    catalog().invalidate(tableName);
+    return true;
+}
+
+bool dropIndex(const string &tableName, const string &indexName) {
+    lock_guard<mutex> writing(wal().writerLatch());
+    vector<pair<string, string>> indexes = readIndexList(tableName);
+    auto it = find_if(indexes.begin(), indexes.end(), [&](const auto &index) { return index.first == indexName; });
+    if (it == indexes.end()) {
+        cerr << "Error: Index " << indexName << " not found on " << tableName << endl;
+        return false;
+    }
+
+    // The log may still hold writes to the tree, retire them first
+    if (!wal().checkpointLocked()) {
+        return false;
+    }
+
+    indexes.erase(it);
+    if (!writeIndexList(tableName, indexes)) {
+        return false;
+    }
+
+    const string filePath = indexFilePath(tableName, indexName);
+    bufferPool().dropFile(filePath);
+    remove(filePath.c_str());
+    catalog().invalidate(tableName);
+    return true;
+}
+
+void dropAllIndexes(const string &tableName) {
+    for (const auto &index: readIndexList(tableName)) {
+        const string filePath = indexFilePath(tableName, index.first);
+        bufferPool().dropFile(filePath);
+        remove(filePath.c_str());
+    }
+    writeIndexList(tableName, {});
+}
+
+// ==================== Maintenance ====================
+
+bool indexInsertRecord(const TableInfo &table, const char *record, int id) {
+    bool success = true;
+    for (const auto &index: table.indexes) {
+        const ColumnInfo &column = table.columns[index.columnIndex];
+        BTree tree(index.filePath, table.columnTypes[index.columnIndex], column.size);
+        if (!tree.insert(record + table.columnOffsets[index.columnIndex], id)) {
+            cerr << "Error: Failed to update index " << index.name << endl;
+            success = false;
+        }
+    }
+    return success;
+}
+
+bool indexRemoveRecord(const TableInfo &table, const char *record, int id) {
+    bool success = true;
+    for (const auto &index: table.indexes) {
+        const ColumnInfo &column = table.columns[index.columnIndex];
+        BTree tree(index.filePath, table.columnTypes[index.columnIndex], column.size);
+        if (!tree.remove(record + table.columnOffsets[index.columnIndex], id)) {
+            cerr << "Error: Failed to update index " << index.name << endl;
+            success = false;
+        }
+    }
+    return success;
+}
@@ -3,6 +3,18 @@
 //
 
 #include "../include/Storage.h"
+#include "../include/BitmapIndex.h"
+#include "../include/BloomFilter.h"
+#include "../include/BufferPool.h"
+#include "../include/Catalog.h"
+#include "../include/TableScan.h"
+#include "../include/ResultCursor.h"
+#include "../include/SecondaryIndex.h"
+#include "../include/WAL.h"
+#include "../include/IoBackend.h"
+#include "../include/Columnar.h"
+#include "../include/Compression.h"
+#include "../include/Vacuum.h"
 #include <string>
 #include <iostream>
 #include <fstream>
@@ -14,41 +26,47 @@ using namespace std;
 
 // ==================== File Header Operations ====================
 
+string companionFilePath(const string &dataFilePath, const string &fileType) {
+    const size_t newSuffix = dataFilePath.size() - min(dataFilePath.size(), vacuumNewFileType.size());
+    if (dataFilePath.compare(newSuffix, string::npos, vacuumNewFileType) == 0) {
+        return companionFilePath(dataFilePath.substr(0, newSuffix), fileType) + vacuumNewFileType;
+    }
+    const size_t typeSuffix = dataFilePath.size() - min(dataFilePath.size(), dataFileType.size());
+    return dataFilePath.substr(0, typeSuffix) + fileType;
+}
+
 void writeHeader(const string &tableName, const DBHeader &header) {
-    fstream file(dataPath + tableName + dataFileType, ios::in | ios::out | ios::binary);
+    const string filePath = dataPath + tableName + dataFileType;
 
-    if (!file) {
+    if (!bufferPool().fileExists(filePath)) {
         // File doesn't exist, create it
-        ofstream newFile(dataPath + tableName + dataFileType, ios::binary);
-        if (!newFile) {
+        if (!bufferPool().writeBytes(filePath, 0, reinterpret_cast<const char *>(&header), sizeof(DBHeader), true)) {
             cerr << "Error creating file while writing a header!" << endl;
             return;
         }
-
-        newFile.write(reinterpret_cast<const char *>(&header), sizeof(DBHeader));
-        newFile.close();
+        bufferPool().flushFile(filePath);
         cout << "New table file created: " << tableName << endl;
         return;
     }
 
     // If file exists, modify only the header
-    file.seekp(0);
-    file.write(reinterpret_cast<const char *>(&header), sizeof(DBHeader));
-    file.close();
+    if (!bufferPool().writeBytes(filePath, 0, reinterpret_cast<const char *>(&header), sizeof(DBHeader))) {
+        cerr << "Error writing header!" << endl;
+        return;
+    }
+    catalog().updateHeader(tableName, header);
 }
 
 DBHeader readHeader(const string &tableName) {
-    ifstream file(dataPath + tableName + dataFileType, ios::binary);
+    const string filePath = dataPath + tableName + dataFileType;
 
-    if (!file) {
+    if (!bufferPool().fileExists(filePath)) {
         cerr << "Table file not found: " << tableName << endl;
         return DBHeader{}; // Return a default-initialized header
     }
 
     DBHeader header{};
-    file.read(reinterpret_cast<char *>(&header), sizeof(DBHeader));
-
-    if (!file) {
+    if (!bufferPool().readBytes(filePath, 0, reinterpret_cast<char *>(&header), sizeof(DBHeader))) {
         cerr << "Error reading header!" << endl;
         return DBHeader{}; // Handle read failure
     }
@@ -56,9 +74,15 @@ DBHeader readHeader(const string &tableName) {
     cout << "Table: " << tableName << endl;
     cout << "Magic: " << string(header.magic, 4) << endl;
     cout << "Number of Records: " << header.numRecords << endl;
+    cout << "Slots: " << header.slotCount << " (" << header.freeSlots << " free)" << endl;
     cout << "Free Offset: " << header.freeOffset << " bytes" << endl;
+    if (header.layout == TableLayout::Columnar) {
+        cout << "Layout: columnar, " << header.segmentRecords << " records per segment" << endl;
+    }
+    if (header.blockRecords > 0) {
+        cout << "Compressed: blocks of " << header.blockRecords << " records" << endl;
+    }
 
-    file.close();
     return header;
 }
 
@@ -75,6 +99,10 @@ ColumnInfo parseSchemaLine(const string &line) {
     }
     index++; // Skip ':'
 
+    // Older schema files kept the blank after the comma in "a:int, b:int"
+    colName.erase(0, colName.find_first_not_of(" \t"));
+    colName.erase(colName.find_last_not_of(" \t") + 1);
+
     // Extract column type
     while (index < line.size() && line[index] != '(' && line[index] != ' ') {
         colType += line[index++];
@@ -106,10 +134,7 @@ vector<ColumnInfo> readSchema(const string &tableName) {
     string line;
 
     while (getline(file, line)) {
-        ColumnInfo column = parseSchemaLine(line);
-        cout << "Column Parsed: " << column.name << " " << column.type
-                << " " << (column.size ? to_string(column.size) : "") << endl;
-        columns.push_back(column);
+        columns.push_back(parseSchemaLine(line));
     }
     file.close();
 
@@ -117,134 +142,38 @@ vector<ColumnInfo> readSchema(const string &tableName) {
 }
 
 int calculateRecordSize(const string &tableName) {
-    vector<ColumnInfo> schemaInfo = readSchema(tableName);
-    int recordSize = 0;
-
-    for (const auto &column: schemaInfo) {
-        recordSize += column.size;
-    }
-
-    return recordSize;
-}
-
-// ==================== Index Operations ====================
-
-bool writeOffsetToFile(ostream &file, const int offset, const int position) {
-    file.seekp(position, ios::beg);
-    file.write(reinterpret_cast<const char *>(&offset), sizeof(int));
-
-    if (!file) {
-        cerr << "Error: Failed to write offset to index file" << endl;
-        return false;
-    }
-
-    return true;
-}
-
-bool createAndWriteIndexFile(const string &indexPath, const string &tableName,
-                             const int offset, const int writePosition) {
-    ofstream newFile(indexPath, ios::binary);
-    if (!newFile) {
-        cerr << "Error: Failed to create index file for table: " << tableName << endl;
-        return false;
-    }
-
-    bool success = writeOffsetToFile(newFile, offset, writePosition);
-    newFile.close();
-
-    if (success) {
-        cout << "New index file created for table: " << tableName << endl;
-    }
-
-    return success;
-}
-
-bool updateIndex(const string &tableName, const int offset) {
-    const string indexPath = dataPath + tableName + indexFileType;
-    const DBHeader fileHeader = readHeader(tableName);
-
-    // Calculate the position to write the new offset
-    const int writePosition = fileHeader.numRecords * sizeof(int);
-
-    // Try to open existing file first
-    fstream file(indexPath, ios::in | ios::out | ios::binary);
-
-    if (!file) {
-        // File doesn't exist, create a new one
-        return createAndWriteIndexFile(indexPath, tableName, offset, writePosition);
-    }
-
-    // Write to existing file
-    bool success = writeOffsetToFile(file, offset, writePosition);
-    file.close();
-    return success;
-}
-
-int getIndex(const string &tableName, const int id) {
-    const string indexPath = dataPath + tableName + indexFileType;
-    ifstream file(indexPath, ios::binary);
-
-    if (!file) {
-        cerr << "Error: Failed to open index file for table: " << tableName << endl;
-        return -1;
-    }
-
-    file.seekg(id * sizeof(int), ios::beg);
-    int offset;
-    file.read(reinterpret_cast<char *>(&offset), sizeof(int));
-
-    if (!file) {
-        cerr << "Error: Failed to read offset for ID " << id << endl;
-        file.close();
-        return -1;
-    }
-
-    file.close();
-    return offset;
+    shared_ptr<const TableInfo> table = catalog().getTable(tableName);
+    return table ? table->recordSize : 0;
 }
 
-void displayIndexOffsets(const string &tableName) {
-    const string indexPath = dataPath + tableName + indexFileType;
-    ifstream file(indexPath, ios::binary);
+// ==================== ID Map Operations ====================
 
-    if (!file) {
-        cerr << "Error: Failed to open index file for table: " << tableName << endl;
-        return;
+// Slot of the record with the given ID, noSlot if the ID was never assigned or
+// the record is deleted
+static int lookupSlot(const TableInfo &table, int id) {
+    if (id < 0 || static_cast<uint64_t>(id) >= table.header.nextRecordId) {
+        return noSlot;
     }
 
-    // Get the file size to determine how many offsets exist
-    file.seekg(0, ios::end);
-    const streampos fileSize = file.tellg();
-    file.seekg(0, ios::beg);
-
-    // Calculate the number of offsets (each offset is an integer)
-    const int numOffsets = fileSize / sizeof(int);
-
-    cout << "\nIndex file for table '" << tableName << "' contains " << numOffsets << " offsets:\n";
-    cout << "-----------------------------------------\n";
-    cout << "ID\t|\tOffset (bytes)\n";
-    cout << "-----------------------------------------\n";
-
-    // Read and display each offset
-    for (int i = 0; i < numOffsets; i++) {
-        int offset;
-        file.read(reinterpret_cast<char *>(&offset), sizeof(int));
-
-        if (!file) {
-            cerr << "Error: Failed to read offset #" << i << endl;
-            break;
+    const string mapPath = dataPath + table.name + idMapFileType;
+    int slot;
+    if (ioBackend() == IoBackend::Mmap) {
+        FileMapping *mapping = fileMappings().get(mapPath);
+        if (const char *mapped = mapping ? mapping->view(id * sizeof(int), sizeof(int)) : nullptr) {
+            memcpy(&slot, mapped, sizeof(int));
+            return slot;
         }
-
-        cout << i << "\t|\t" << offset << endl;
     }
-
-    cout << "-----------------------------------------\n";
-    file.close();
+    if (!bufferPool().readBytes(mapPath, id * sizeof(int), reinterpret_cast<char *>(&slot), sizeof(int))) {
+        cerr << "Error: Failed to read the slot of ID " << id << endl;
+        return noSlot;
+    }
+    return slot;
 }
 
 // ==================== Table Operations ====================
 
-void createTable(const string &tableName, const string &columns) {
+void createTable(const string &tableName, const string &columns, TableLayout layout) {
     string schema, line;
     schema += "ID:int\n"; // Always add ID column first
     stringstream ss(columns);
@@ -252,6 +181,8 @@ void createTable(const string &tableName, const string &columns) {
     while (ss.good()) {
         string substr;
         getline(ss, substr, ',');
+        substr.erase(0, substr.find_first_not_of(" \t"));
+        substr.erase(substr.find_last_not_of(" \t") + 1);
         if (!substr.empty()) {
             schema += substr + "\n";
         }
@@ -262,6 +193,9 @@ void createTable(const string &tableName, const string &columns) {
     cout << "Creating table: " << tableName << endl;
     cout << "Schema: " << schema << endl;
 
+    // DDL isn't logged: start from an empty log and make the new files durable
+    wal().checkpoint();
+
     // Write schema file
     ofstream schemaFile(schemaPath, ios::binary);
     if (!schemaFile) {
@@ -270,290 +204,393 @@ void createTable(const string &tableName, const string &columns) {
     }
     schemaFile.write(schema.c_str(), schema.size());
     schemaFile.close();
+    dropAllIndexes(tableName); // they described the old columns
+    dropAllBloomFilters(tableName);
+    dropAllBitmapIndexes(tableName);
+    catalog().invalidate(tableName);
 
     // Create a default header and write it
     DBHeader newHeader{};
-    strncpy(newHeader.magic, "DB01", 4);
+    memcpy(newHeader.magic, currentHeaderMagic, 4);
     newHeader.numRecords = 0;
-    newHeader.freeOffset = sizeof(DBHeader); // Data starts after the header
+    newHeader.freeOffset = headerSize; // Data starts after the header
+    newHeader.layout = layout;
+    newHeader.segmentRecords = layout == TableLayout::Columnar ? defaultSegmentRecords : 0;
 
     writeHeader(tableName, newHeader);
+
+    // A columnar table starts with an empty segment directory
+    const string segmentPath = dataPath + tableName + segmentFileType;
+    bufferPool().dropFile(segmentPath);
+    remove(segmentPath.c_str());
+    if (layout == TableLayout::Columnar) {
+        bufferPool().writeBytes(segmentPath, 0, nullptr, 0, true);
+    }
+    invalidateSegmentDictionaries();
+
+    // The zone map is kept from the first record on
+    const string zonePath = dataPath + tableName + zoneMapFileType;
+    bufferPool().dropFile(zonePath);
+    remove(zonePath.c_str());
+    bufferPool().writeBytes(zonePath, 0, nullptr, 0, true);
+
+    // New tables are written uncompressed
+    const string blockPath = dataPath + tableName + blockIndexFileType;
+    bufferPool().dropFile(blockPath);
+    remove(blockPath.c_str());
+    invalidateCompressedBlocks();
+    wal().checkpoint();
 }
 
 // ==================== Record Operations ====================
 
-void writeRecord(const string &tableName, vector<string> values) {
-    string filePath = dataPath + tableName + dataFileType;
-    fstream file(filePath, ios::in | ios::out | ios::binary);
-
-    if (!file.is_open()) {
-        throw runtime_error("Error opening file: " + filePath);
+// Parse a whole number the way stoi/stof did: a leading '+' is fine and
+// anything after the number is ignored, but there has to be a number.
+template<typename T>
+static T parseNumber(string_view text, const ColumnInfo &column) {
+    if (!text.empty() && text.front() == '+') {
+        text.remove_prefix(1);
     }
+    T value{};
+    const auto [end, error] = from_chars(text.data(), text.data() + text.size(), value);
+    if (error != errc() || end == text.data()) {
+        throw runtime_error("Invalid " + column.type + " value '" + string(text) + "' for column: " + column.name);
+    }
+    return value;
+}
 
-    vector<ColumnInfo> schemaInfo = readSchema(tableName);
-    DBHeader fileHeader = readHeader(tableName);
-
-    // Seek to the free offset location for writing
-    file.seekp(fileHeader.freeOffset, ios::beg);
+void encodeRecord(const TableInfo &table, const vector<string_view> &values, int id, char *record) {
+    if (values.size() + 1 != table.columns.size()) {
+        throw runtime_error("Expected " + to_string(table.columns.size() - 1) + " values for table " + table.name +
+                            ", got " + to_string(values.size()));
+    }
 
-    int recordSize = 0;
     int columnIndex = 0;
-    for (auto &column: schemaInfo) {
-        if (column.name == "ID") {
-            int newID = fileHeader.numRecords; // Use the incremented value
-            file.write(reinterpret_cast<const char *>(&newID), sizeof(int));
-            recordSize += sizeof(int);
-            cout << "Assigned ID: " << newID << endl;
+    for (size_t i = 0; i < table.columns.size(); i++) {
+        const ColumnInfo &column = table.columns[i];
+        if (column.name == ID_COLUMN) {
+            memcpy(record, &id, sizeof(int));
+            record += sizeof(int);
             continue;
         }
 
-        if (column.type == "int") {
-            int value = stoi(values[columnIndex]);
-            file.write(reinterpret_cast<const char *>(&value), sizeof(int));
-            recordSize += sizeof(int);
-        } else if (column.type == "float") {
-            float value = stof(values[columnIndex]);
-            file.write(reinterpret_cast<const char *>(&value), sizeof(float));
-            recordSize += sizeof(float);
-        } else if (column.type == "string") {
-            string value = values[columnIndex];
-            if (!value.empty() && value.front() == '"' && value.back() == '"') {
-                value = value.substr(1, value.size() - 2); // Remove first and last character
+        switch (table.columnTypes[i]) {
+            case ColumnType::Int: {
+                const int value = parseNumber<int>(values[columnIndex], column);
+                memcpy(record, &value, sizeof(int));
+                break;
+            }
+            case ColumnType::Float: {
+                const float value = parseNumber<float>(values[columnIndex], column);
+                memcpy(record, &value, sizeof(float));
+                break;
             }
-            if (value.size() > column.size) {
-                throw runtime_error("Input exceeds maximum size for column: " + column.name);
+            case ColumnType::String: {
+                string_view value = values[columnIndex];
+                if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+                    value = value.substr(1, value.size() - 2); // Remove first and last character
+                }
+                if (value.size() > static_cast<size_t>(column.size)) {
+                    throw runtime_error("Input exceeds maximum size for column: " + column.name);
+                }
+                memcpy(record, value.data(), value.size());
+                memset(record + value.size(), 0, column.size - value.size()); // Ensure proper size
+                break;
             }
-            value.resize(column.size, '\0'); // Ensure proper size
-            file.write(value.c_str(), column.size);
-            recordSize += column.size;
         }
+        record += column.size;
         columnIndex++;
     }
+}
 
-    // Update header with new free offset and record count
-    fileHeader.numRecords++;
-    fileHeader.freeOffset += recordSize;
+void encodeRecord(const TableInfo &table, const vector<string> &values, int id, char *record) {
+    encodeRecord(table, vector<string_view>(values.begin(), values.end()), id, record);
+}
 
-    // Update index file
-    if (!updateIndex(tableName, fileHeader.freeOffset - recordSize)) {
-        throw runtime_error("Failed to update index for table: " + tableName);
+// Rows per logged batch. Pages written by a batch stay pinned until it commits,
+// so a batch may use at most a quarter of the pool, and fewer rows when every
+// row also touches B+Tree leaves.
+static size_t bulkBatchRows(const TableInfo &table) {
+    const size_t poolBytes = bufferPool().capacity() * PAGE_SIZE / 4;
+    size_t rows = max<size_t>(min(bulkLoadBatchBytes, poolBytes) / table.recordSize, 1);
+    if (!table.indexes.empty()) {
+        rows = min(rows, max<size_t>(bufferPool().capacity() / (8 * table.indexes.size()), 1));
     }
-
-    // Write updated header
-    writeHeader(tableName, fileHeader);
-    file.close();
-    cout << "Record written successfully." << endl;
+    return rows;
 }
 
-void readRecords(const string &tableName) {
-    string filePath = dataPath + tableName + dataFileType;
-    ifstream file(filePath, ios::binary);
+size_t appendRecords(const string &tableName, char *records, size_t count) {
+    const string filePath = dataPath + tableName + dataFileType;
+    const string mapPath = dataPath + tableName + idMapFileType;
+    const string freeListPath = dataPath + tableName + freeListFileType;
 
-    if (!file.is_open()) {
-        cerr << "Error opening file: " << filePath << endl;
-        return;
+    shared_ptr<const TableInfo> table = catalog().getTable(tableName);
+    if (!table) {
+        throw runtime_error("Error opening file: " + filePath);
     }
 
-    // Read file header
-    DBHeader fileHeader = readHeader(tableName);
+    const int recordSize = table->recordSize;
+    const int idOffset = table->columnOffsets[table->columnIndex(ID_COLUMN)];
+    const size_t batchRows = bulkBatchRows(*table);
+    vector<int> slots;
 
-    // Read schema information
-    vector<ColumnInfo> schemaInfo = readSchema(tableName);
+    for (size_t first = 0; first < count; first += batchRows) {
+        const size_t batchCount = min(batchRows, count - first);
+        char *batch = records + first * recordSize;
 
-    // Seek to the start of the records (after the header)
-    file.seekg(headerSize, ios::beg);
+        // Records, map entries, secondary index entries and header are logged as one unit.
+        // The writer latch makes the free slots and the range [freeOffset, freeOffset + batch) ours.
+        WalTransaction transaction;
+        table = catalog().getTable(tableName); // a VACUUM may have replaced it while we waited
+        if (!table) {
+            throw runtime_error("Error opening file: " + filePath);
+        }
+        DBHeader fileHeader = table->header;
+        if (isCompressed(*table)) {
+            throw runtime_error("Table " + tableName + " is compressed, VACUUM it before writing");
+        }
+        if (fileHeader.nextRecordId + batchCount > maxRecordId) {
+            throw runtime_error("Table " + tableName + " has run out of record IDs");
+        }
 
-    cout << "\nReading Records from " << tableName << "...\n";
+        for (size_t i = 0; i < batchCount; i++) {
+            const RecordId id = fileHeader.nextRecordId + i;
+            memcpy(batch + i * recordSize + idOffset, &id, sizeof(int));
+        }
 
-    for (int recordIndex = 0; recordIndex < fileHeader.numRecords; ++recordIndex) {
-        cout << "Record " << (recordIndex + 1) << ":\n";
-
-        for (const auto &column: schemaInfo) {
-            cout << column.name << ": ";
-
-            if (column.type == "int") {
-                int value;
-                file.read(reinterpret_cast<char *>(&value), sizeof(int));
-                cout << value;
-            } else if (column.type == "float") {
-                float value;
-                file.read(reinterpret_cast<char *>(&value), sizeof(float));
-                cout << value;
-            } else if (column.type == "string") {
-                vector<char> buffer(column.size);
-                file.read(buffer.data(), column.size);
-                string value(buffer.data(), strnlen(buffer.data(), column.size));
-                cout << value;
+        // Deleted slots are filled first, popped from the top of the free stack
+        const size_t reused = min<size_t>(fileHeader.freeSlots, batchCount);
+        slots.resize(batchCount);
+        if (reused > 0 &&
+            !bufferPool().readBytes(freeListPath, (fileHeader.freeSlots - reused) * sizeof(int),
+                                    reinterpret_cast<char *>(slots.data()), reused * sizeof(int))) {
+            throw runtime_error("Failed to read the free slot list of table: " + tableName);
+        }
+        for (size_t i = 0; i < reused; i++) {
+            if (!writeSlots(*table, filePath, slots[i], batch + i * recordSize, 1)) {
+                throw runtime_error("Error writing records to file: " + filePath);
             }
+        }
 
-            cout << endl;
+        // The rest go after the last slot
+        const size_t appended = batchCount - reused;
+        for (size_t i = 0; i < appended; i++) {
+            slots[reused + i] = fileHeader.slotCount + i;
+        }
+        if (appended > 0 &&
+            !writeSlots(*table, filePath, fileHeader.slotCount, batch + reused * recordSize, appended)) {
+            throw runtime_error("Error writing records to file: " + filePath);
         }
-        cout << "---------------------\n"; // Separator between records
-    }
 
-    file.close();
-}
+        // The batch's IDs are consecutive, so their map entries are one write
+        if (!bufferPool().writeBytes(mapPath, fileHeader.nextRecordId * sizeof(int),
+                                     reinterpret_cast<const char *>(slots.data()), batchCount * sizeof(int), true)) {
+            throw runtime_error("Failed to update the ID map of table: " + tableName);
+        }
 
-void readRecordWithIndex(const string &tableName, int id) {
-    string filePath = dataPath + tableName + dataFileType;
-    ifstream file(filePath, ios::binary);
+        // Secondary indexes map the column values to the new IDs
+        for (size_t i = 0; i < batchCount; i++) {
+            if (!indexInsertRecord(*table, batch + i * recordSize, fileHeader.nextRecordId + i)) {
+                throw runtime_error("Failed to update secondary indexes for table: " + tableName);
+            }
+        }
+        if (!bitmapInsertRecords(*table, batch, batchCount, fileHeader.nextRecordId)) {
+            throw runtime_error("Failed to update bitmap indexes for table: " + tableName);
+        }
 
-    if (!file.is_open()) {
-        cerr << "Error opening file: " << filePath << endl;
-        return;
+        // Update header with new free offset, counts and ID counter, once per batch
+        fileHeader.numRecords += batchCount;
+        fileHeader.nextRecordId += batchCount;
+        fileHeader.freeSlots -= reused;
+        fileHeader.slotCount += appended;
+        fileHeader.freeOffset += appended * recordSize;
+        writeHeader(tableName, fileHeader);
+        if (!transaction.commit()) {
+            throw runtime_error("Failed to commit records to table: " + tableName);
+        }
     }
+    return count;
+}
 
-    // Get record offset from index
-    int offset = getIndex(tableName, id);
-    if (offset == -1) {
-        cerr << "Error: Could not find record with ID " << id << endl;
-        file.close();
-        return;
+size_t writeRecords(const string &tableName, const vector<vector<string>> &rows) {
+    shared_ptr<const TableInfo> table = catalog().getTable(tableName);
+    if (!table) {
+        throw runtime_error("Error opening file: " + dataPath + tableName + dataFileType);
     }
 
-    // Read schema information
-    vector<ColumnInfo> schemaInfo = readSchema(tableName);
+    // Serialize everything first, a bad row rejects the call before anything is written
+    vector<char> records(rows.size() * table->recordSize);
+    for (size_t i = 0; i < rows.size(); i++) {
+        encodeRecord(*table, rows[i], 0, records.data() + i * table->recordSize);
+    }
+    return appendRecords(tableName, records.data(), rows.size());
+}
 
-    // Seek to the record position
-    file.seekg(offset, ios::beg);
+void writeRecord(const string &tableName, vector<string> values) {
+    shared_ptr<const TableInfo> table = catalog().getTable(tableName);
+    if (!table) {
+        throw runtime_error("Error opening file: " + dataPath + tableName + dataFileType);
+    }
 
-    cout << "\nReading Record with ID: " << id << " from " << tableName << "...\n";
+    vector<char> record(table->recordSize);
+    encodeRecord(*table, values, 0, record.data());
+    appendRecords(tableName, record.data(), 1);
+
+    // appendRecords patched the assigned ID into the record
+    int newID;
+    memcpy(&newID, record.data() + table->columnOffsets[table->columnIndex(ID_COLUMN)], sizeof(int));
+    cout << "Assigned ID: " << newID << endl;
+    cout << "Record written successfully." << endl;
+}
 
+// Print every column of a serialized record
+static void printRecord(const vector<ColumnInfo> &schemaInfo, const char *record) {
     for (const auto &column: schemaInfo) {
         cout << column.name << ": ";
 
         if (column.type == "int") {
             int value;
-            file.read(reinterpret_cast<char *>(&value), sizeof(int));
+            memcpy(&value, record, sizeof(int));
             cout << value;
         } else if (column.type == "float") {
             float value;
-            file.read(reinterpret_cast<char *>(&value), sizeof(float));
+            memcpy(&value, record, sizeof(float));
             cout << value;
         } else if (column.type == "string") {
-            vector<char> buffer(column.size);
-            file.read(buffer.data(), column.size);
-            string value(buffer.data(), strnlen(buffer.data(), column.size));
+            string value(record, strnlen(record, column.size));
             cout << value;
         }
+        record += column.size;
 
         cout << endl;
     }
+}
+
+void readRecords(const string &tableName) {
+    string filePath = dataPath + tableName + dataFileType;
+    shared_lock<shared_mutex> reading(catalog().swapLatch());
+
+    shared_ptr<const TableInfo> table = catalog().getTable(tableName);
+    if (!table) {
+        cerr << "Error opening file: " << filePath << endl;
+        return;
+    }
+
+    cout << "\nReading Records from " << tableName << "...\n";
+
+    // Slots start right after the header and are packed up to the free offset
+    const int idOffset = table->columnOffsets[table->columnIndex(ID_COLUMN)];
+    TableScanIterator scan(tableName, table->recordSize, table->header.freeOffset);
+    scan.readColumns(*table, {});
+    int recordIndex = 0;
+    while (const char *record = scan.next()) {
+        int id;
+        memcpy(&id, record + idOffset, sizeof(int));
+        if (id == tombstoneId) continue;
+
+        cout << "Record " << (++recordIndex) << ":\n";
+        printRecord(table->columns, record);
+        cout << "---------------------\n"; // Separator between records
+    }
+}
+
+void readRecordWithIndex(const string &tableName, int id) {
+    string filePath = dataPath + tableName + dataFileType;
+    shared_lock<shared_mutex> reading(catalog().swapLatch());
+
+    shared_ptr<const TableInfo> table = catalog().getTable(tableName);
+    if (!table) {
+        cerr << "Error opening file: " << filePath << endl;
+        return;
+    }
+
+    // Get the record's slot from the ID map
+    const int slot = lookupSlot(*table, id);
+    if (slot == noSlot) {
+        cerr << "Error: Could not find record with ID " << id << endl;
+        return;
+    }
+
+    vector<char> recordBuffer(table->recordSize);
+    if (!readSlots(*table, filePath, slot, 1, {}, recordBuffer.data())) {
+        cerr << "Error: Failed to read record with ID " << id << endl;
+        return;
+    }
 
+    cout << "\nReading Record with ID: " << id << " from " << tableName << "...\n";
+    printRecord(table->columns, recordBuffer.data());
     cout << "---------------------\n";
-    file.close();
 }
 
 bool deleteRecord(const string &tableName, int id) {
     const string dataFilePath = dataPath + tableName + dataFileType;
-    const string indexFilePath = dataPath + tableName + indexFileType;
+    const string mapPath = dataPath + tableName + idMapFileType;
+    const string freeListPath = dataPath + tableName + freeListFileType;
+    WalTransaction transaction;
 
-    // Display current index status
-    displayIndexOffsets(tableName);
-
-    fstream dataFile(dataFilePath, ios::in | ios::out | ios::binary);
-    if (!dataFile.is_open()) {
+    if (!bufferPool().fileExists(dataFilePath)) {
         cerr << "Error opening file: " << dataFilePath << endl;
         return false;
     }
 
-    fstream indexFile(indexFilePath, ios::in | ios::out | ios::binary);
-    if (!indexFile.is_open()) {
-        cerr << "Error opening index file: " << indexFilePath << endl;
-        dataFile.close();
+    cout << "Deleting record with ID: " << id << endl;
+
+    shared_ptr<const TableInfo> table = catalog().getTable(tableName);
+    if (!table) {
+        cerr << "Error: Failed to read schema for table: " << tableName << endl;
         return false;
     }
 
-    cout << "Deleting record with ID: " << id << endl;
+    if (isCompressed(*table)) {
+        cerr << "Error: Table " << tableName << " is compressed, VACUUM it before deleting" << endl;
+        return false;
+    }
 
-    // Read the header to get the number of records
-    DBHeader fileHeader = readHeader(tableName);
+    // The cached header holds the record counts
+    DBHeader fileHeader = table->header;
 
     // Validate the ID
-    if (id < 0 || id >= fileHeader.numRecords) {
+    if (id < 0 || static_cast<uint64_t>(id) >= fileHeader.nextRecordId) {
         cerr << "Error: Invalid record ID " << id << endl;
-        dataFile.close();
-        indexFile.close();
         return false;
     }
 
-    // Get the schema information and calculate record size
-    vector<ColumnInfo> schemaInfo = readSchema(tableName);
-    if (schemaInfo.empty()) {
-        cerr << "Error: Failed to read schema for table: " << tableName << endl;
-        dataFile.close();
-        indexFile.close();
+    const int slot = lookupSlot(*table, id);
+    if (slot == noSlot) {
+        cerr << "Error: Record with ID " << id << " is already deleted" << endl;
         return false;
     }
 
-    // Calculate record size
-    int recordSize = 0;
-    for (const auto &column: schemaInfo) {
-        if (column.type == "int" || column.type == "float") {
-            recordSize += 4; // 4 bytes for int/float
-        } else if (column.type == "string") {
-            recordSize += column.size;
-        }
-    }
-
-    // Get offset of the record to delete
-    int deleteOffset = getIndex(tableName, id);
-    if (deleteOffset == -1) {
-        cerr << "Error: Could not find index for record with ID " << id << endl;
-        dataFile.close();
-        indexFile.close();
+    // The deleted record's values leave every secondary index
+    vector<char> deletedRecordData(table->recordSize);
+    if (!readSlots(*table, dataFilePath, slot, 1, {}, deletedRecordData.data()) ||
+        !indexRemoveRecord(*table, deletedRecordData.data(), id) ||
+        !bitmapRemoveRecord(*table, deletedRecordData.data(), id)) {
+        cerr << "Error: Failed to remove record ID " << id << " from the secondary indexes" << endl;
         return false;
     }
 
-    cout << "Deleting record ID " << id << " at offset: " << deleteOffset << endl;
-
-    // Get the last record's offset
-    int lastRecordID = fileHeader.numRecords - 1;
-    int lastRecordOffset = getIndex(tableName, lastRecordID);
-
-    // Show the last record that will be moved
-    readRecordWithIndex(tableName, lastRecordID);
-
-    if (lastRecordOffset == -1) {
-        cerr << "Error: Could not find the last record's offset" << endl;
-        dataFile.close();
-        indexFile.close();
+    // Tombstone the record in place so scans skip it, leave a hole in the ID
+    // map and push the slot on the free stack. No other record moves or
+    // changes ID.
+    const uint64_t idOffset = columnValueOffset(*table, slot, table->columnIndex(ID_COLUMN));
+    if (!bufferPool().writeBytes(dataFilePath, idOffset, reinterpret_cast<const char *>(&tombstoneId), sizeof(int)) ||
+        !bufferPool().writeBytes(mapPath, id * sizeof(int), reinterpret_cast<const char *>(&noSlot), sizeof(int)) ||
+        !bufferPool().writeBytes(freeListPath, fileHeader.freeSlots * sizeof(int),
+                                 reinterpret_cast<const char *>(&slot), sizeof(int), true)) {
+        cerr << "Error: Failed to delete record with ID " << id << endl;
         return false;
     }
 
-    // If we're not deleting the last record, move the last record to the deleted position
-    if (id != lastRecordID) {
-        // Read the last record's data
-        vector<char> lastRecordData(recordSize);
-        dataFile.seekg(lastRecordOffset, ios::beg);
-        dataFile.read(lastRecordData.data(), recordSize);
-
-        if (!dataFile) {
-            cerr << "Error: Failed to read the last record's data" << endl;
-            dataFile.close();
-            indexFile.close();
-            return false;
-        }
-
-        // Write the last record's data to the deleted record's position
-        dataFile.seekp(deleteOffset, ios::beg);
-        dataFile.write(lastRecordData.data(), recordSize);
-
-        // Update the index file by shifting entries
-        indexFile.seekg((id + 1) * sizeof(int), ios::beg);
-        vector<char> indexData((lastRecordID - id) * sizeof(int));
-        indexFile.read(indexData.data(), (lastRecordID - id) * sizeof(int));
-
-        indexFile.seekp(id * sizeof(int), ios::beg);
-        indexFile.write(indexData.data(), (lastRecordID - id) * sizeof(int));
-    }
-
-    // Update the record count in the header
+    // Update the record counts in the header
     fileHeader.numRecords--;
+    fileHeader.freeSlots++;
     writeHeader(tableName, fileHeader);
+    if (!transaction.commit()) {
+        cerr << "Error: Failed to commit the delete of record ID " << id << endl;
+        return false;
+    }
 
-    dataFile.close();
-    indexFile.close();
     cout << "Record deleted successfully." << endl;
     return true;
 }
@@ -566,260 +603,56 @@ vector<vector<variant<int, float, string> > > getRecordsWithCondition(
     const vector<string> &columnsToReturn,
     const vector<Condition> &conditions
 ) {
-    // Result container - vector of rows, where each row is a vector of column values
+    // Result container - vector of rows, where each row is a vector of column values.
+    // Materializes a ResultCursor; streaming callers should use the cursor directly.
     vector<vector<variant<int, float, string> > > results;
 
-    string filePath = dataPath + tableName + dataFileType;
-    ifstream dataFile(filePath, ios::binary);
-
-    if (!dataFile.is_open()) {
-        cerr << "Error opening data file: " << filePath << endl;
-        return results;
-    }
-
-    // Read the header
-    DBHeader header = readHeader(tableName);
-
-    // Read the schema
-    vector<ColumnInfo> schema = readSchema(tableName);
-
-    // Calculate column offsets for faster access
-    vector<int> columnOffsets(schema.size(), 0);
-    int currentOffset = 0;
-    for (size_t i = 0; i < schema.size(); i++) {
-        columnOffsets[i] = currentOffset;
-        currentOffset += schema[i].size;
-    }
-
-    // Determine which columns to return
-    vector<int> columnIndices;
-    bool returnAllColumns = (columnsToReturn.size() == 1 && columnsToReturn[0] == "*");
-
-    if (!returnAllColumns) {
-        for (const auto &columnName: columnsToReturn) {
-            bool found = false;
-            for (size_t i = 0; i < schema.size(); i++) {
-                if (schema[i].name == columnName) {
-                    columnIndices.push_back(i);
-                    found = true;
-                    break;
-                }
-            }
-            if (!found) {
-                cerr << "Warning: Column '" << columnName << "' not found in schema" << endl;
-            }
-        }
-    } else {
-        // Return all columns
-        for (size_t i = 0; i < schema.size(); i++) {
-            columnIndices.push_back(i);
-        }
-    }
-
-    // Calculate record size
-    int recordSize = 0;
-    for (const auto &col: schema) {
-        recordSize += col.size;
+    ResultCursor cursor(tableName, columnsToReturn, conditions);
+    Row row;
+    while (cursor.next(row)) {
+        results.push_back(row);
     }
 
-    // Buffer for reading a record
-    vector<char> recordBuffer(recordSize);
-
-    // Process each record
-    for (int recordId = 0; recordId < header.numRecords; recordId++) {
-        // Get the record offset from the index
-        int offset = getIndex(tableName, recordId);
-
-        if (offset == -1) {
-            cerr << "Warning: Could not find offset for record ID " << recordId << endl;
-            continue;
-        }
-
-        // Read the record
-        dataFile.seekg(offset);
-        dataFile.read(recordBuffer.data(), recordSize);
-
-        if (!dataFile) {
-            cerr << "Error reading record ID " << recordId << endl;
-            continue;
-        }
-
-        // Check if record satisfies all conditions
-        bool recordMatches = true;
-
-        for (const auto &condition: conditions) {
-            int colIndex = -1;
-
-            // Find the column index for the condition
-            for (size_t i = 0; i < schema.size(); i++) {
-                if (schema[i].name == condition.columnName) {
-                    colIndex = i;
-                    break;
-                }
-            }
-
-            if (colIndex == -1) {
-                cerr << "Warning: Condition column '" << condition.columnName << "' not found" << endl;
-                recordMatches = false;
-                break;
-            }
-
-            // Get offset to the column in the record
-            int colOffset = columnOffsets[colIndex];
-
-            // Compare based on column type
-            if (schema[colIndex].type == "int") {
-                int recordValue = *reinterpret_cast<int *>(recordBuffer.data() + colOffset);
-                int conditionValue = get<int>(condition.value);
-
-                if (condition.operatorType == "=") {
-                    if (!(recordValue == conditionValue)) recordMatches = false;
-                } else if (condition.operatorType == "!=") {
-                    if (!(recordValue != conditionValue)) recordMatches = false;
-                } else if (condition.operatorType == "<") {
-                    if (!(recordValue < conditionValue)) recordMatches = false;
-                } else if (condition.operatorType == "<=") {
-                    if (!(recordValue <= conditionValue)) recordMatches = false;
-                } else if (condition.operatorType == ">") {
-                    if (!(recordValue > conditionValue)) recordMatches = false;
-                } else if (condition.operatorType == ">=") {
-                    if (!(recordValue >= conditionValue)) recordMatches = false;
-                }
-            } else if (schema[colIndex].type == "float") {
-                float recordValue = *reinterpret_cast<float *>(recordBuffer.data() + colOffset);
-                float conditionValue = get<float>(condition.value);
-
-                if (condition.operatorType == "=") {
-                    if (!(recordValue == conditionValue)) recordMatches = false;
-                } else if (condition.operatorType == "!=") {
-                    if (!(recordValue != conditionValue)) recordMatches = false;
-                } else if (condition.operatorType == "<") {
-                    if (!(recordValue < conditionValue)) recordMatches = false;
-                } else if (condition.operatorType == "<=") {
-                    if (!(recordValue <= conditionValue)) recordMatches = false;
-                } else if (condition.operatorType == ">") {
-                    if (!(recordValue > conditionValue)) recordMatches = false;
-                } else if (condition.operatorType == ">=") {
-                    if (!(recordValue >= conditionValue)) recordMatches = false;
-                }
-            } else if (schema[colIndex].type == "string") {
-                string recordValue(recordBuffer.data() + colOffset,
-                                   strnlen(recordBuffer.data() + colOffset, schema[colIndex].size));
-                string conditionValue = get<string>(condition.value);
-
-                int cmpResult = recordValue.compare(conditionValue);
-
-                if (condition.operatorType == "=") {
-                    if (!(cmpResult == 0)) recordMatches = false;
-                } else if (condition.operatorType == "!=") {
-                    if (!(cmpResult != 0)) recordMatches = false;
-                } else if (condition.operatorType == "<") {
-                    if (!(cmpResult < 0)) recordMatches = false;
-                } else if (condition.operatorType == "<=") {
-                    if (!(cmpResult <= 0)) recordMatches = false;
-                } else if (condition.operatorType == ">") {
-                    if (!(cmpResult > 0)) recordMatches = false;
-                } else if (condition.operatorType == ">=") {
-                    if (!(cmpResult >= 0)) recordMatches = false;
-                }
-            }
-
-            if (!recordMatches) break;
-        }
-
-        // If record matches all conditions, extract requested columns
-        if (recordMatches) {
-            vector<variant<int, float, string> > row;
-
-            for (int colIdx: columnIndices) {
-                int colOffset = columnOffsets[colIdx];
-
-                if (schema[colIdx].type == "int") {
-                    int value = *reinterpret_cast<int *>(recordBuffer.data() + colOffset);
-                    row.push_back(value);
-                } else if (schema[colIdx].type == "float") {
-                    float value = *reinterpret_cast<float *>(recordBuffer.data() + colOffset);
-                    row.push_back(value);
-                } else if (schema[colIdx].type == "string") {
-                    string value(recordBuffer.data() + colOffset,
-                                 strnlen(recordBuffer.data() + colOffset, schema[colIdx].size));
-                    row.push_back(value);
-                }
-            }
-
-            results.push_back(row);
-        }
-    }
-
-    dataFile.close();
     return results;
 }
 
-// Helper function to display the results
-void displayResults(const string &tableName,
-                    const vector<string> &columns,
-                    const vector<vector<variant<int, float, string> > > &results) {
-    // Get schema to determine column types
-    vector<ColumnInfo> schema = readSchema(tableName);
-
-    // Determine column indices and types
-    vector<pair<int, string> > columnInfo;
-    bool displayAllColumns = (columns.size() == 1 && columns[0] == "*");
-
-    if (displayAllColumns) {
-        for (size_t i = 0; i < schema.size(); i++) {
-            columnInfo.push_back({i, schema[i].type});
-        }
-    } else {
-        for (const auto &colName: columns) {
-            for (size_t i = 0; i < schema.size(); i++) {
-                if (schema[i].name == colName) {
-                    columnInfo.push_back({i, schema[i].type});
-                    break;
-                }
-            }
-        }
-    }
-
+// Helper function to display the results, printing each row as the cursor produces it
+void displayResults(ResultCursor &cursor) {
     // Display column headers
     cout << "\n-----------------------------------------\n";
-    if (displayAllColumns) {
-        for (const auto &col: schema) {
-            cout << col.name << "\t";
-        }
-    } else {
-        for (const auto &colName: columns) {
-            cout << colName << "\t";
-        }
+    for (const auto &colName: cursor.columnNames()) {
+        cout << colName << "\t";
     }
     cout << "\n-----------------------------------------\n";
 
-    // Display results
-    for (const auto &row: results) {
-        for (size_t i = 0; i < row.size(); i++) {
-            // Get the value based on its type
-            if (holds_alternative<int>(row[i])) {
-                cout << get<int>(row[i]);
-            } else if (holds_alternative<float>(row[i])) {
-                cout << get<float>(row[i]);
-            } else if (holds_alternative<string>(row[i])) {
-                cout << get<string>(row[i]);
-            }
+    // Display results straight from the column vectors, one batch at a time
+    RowBatch batch;
+    while (cursor.nextBatch(batch)) {
+        for (size_t row = 0; row < batch.size; row++) {
+            for (const auto &column: batch.columns) {
+                // Get the value based on its type
+                if (column.type == ColumnType::Int) {
+                    cout << column.ints[row];
+                } else if (column.type == ColumnType::Float) {
+                    cout << column.floats[row];
+                } else {
+                    cout << column.strings[row];
+                }
 
-            cout << "\t";
+                cout << "\t";
+            }
+            cout << "\n";
         }
-        cout << endl;
     }
     cout << "-----------------------------------------\n";
-    cout << results.size() << " records found" << endl;
+    cout << cursor.rowsReturned() << " records found" << endl;
 }
 
 void displayQueryResults(const string &tableName,
                          const vector<string> &columns,
                          const vector<Condition> &conditions) {
-    // Get the records that match the conditions
-    vector<vector<variant<int, float, string> > > results =
-            getRecordsWithCondition(tableName, columns, conditions);
+    // Open a cursor over the records that match the conditions
+    ResultCursor cursor(tableName, columns, conditions);
 
     // Display query information
     cout << "\nQuery on table: " << tableName << endl;
@@ -842,12 +675,24 @@ void displayQueryResults(const string &tableName,
                     << conditions[i].operatorType << " ";
 
             // Display the condition value based on its type
-            if (holds_alternative<int>(conditions[i].value)) {
-                cout << get<int>(conditions[i].value);
-            } else if (holds_alternative<float>(conditions[i].value)) {
-                cout << get<float>(conditions[i].value);
-            } else if (holds_alternative<string>(conditions[i].value)) {
-                cout << "\"" << get<string>(conditions[i].value) << "\"";
+            auto printValue = [](const variant<int, float, string> &value) {
+                if (holds_alternative<int>(value)) {
+                    cout << get<int>(value);
+                } else if (holds_alternative<float>(value)) {
+                    cout << get<float>(value);
+                } else if (holds_alternative<string>(value)) {
+                    cout << "\"" << get<string>(value) << "\"";
+                }
+            };
+            if (conditions[i].operatorType == "IN") {
+                cout << "(";
+                for (size_t j = 0; j < conditions[i].values.size(); j++) {
+                    printValue(conditions[i].values[j]);
+                    if (j < conditions[i].values.size() - 1) cout << ", ";
+                }
+                cout << ")";
+            } else {
+                printValue(conditions[i].value);
             }
 
             if (i < conditions.size() - 1) cout << " AND ";
@@ -855,6 +700,10 @@ void displayQueryResults(const string &tableName,
         cout << endl;
     }
 
-    // Use the existing displayResults function to show the data
-    displayResults(tableName, columns, results);
+    if (cursor.isOpen()) {
+        cout << "Access path: " << cursor.accessPath().describe() << endl;
+    }
+
+    // Stream the matching rows
+    displayResults(cursor);
 }
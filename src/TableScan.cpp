@@ -0,0 +1,446 @@
+#include "../include/TableScan.h"
+#include "../include/Storage.h"
+#include "../include/BufferPool.h"
+#include "../include/Columnar.h"
+#include "../include/Compression.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace std;
+
+TableScanIterator::TableScanIterator(const string &tableName, int recordSize, uint64_t endOffset,
+                                     size_t chunkBytes)
+    : filePath(dataPath + tableName + dataFileType),
+      recordSize(recordSize),
+      nextOffset(headerSize),
+      endOffset(endOffset),
+      chunkRecords(recordSize > 0 ? max<size_t>(chunkBytes / recordSize, 1) : 0) {
+    if (recordSize <= 0 || endOffset < headerSize) {
+        this->endOffset = headerSize;
+        return;
+    }
+    // Only whole records are scanned; a trailing partial record is ignored
+    const uint64_t wholeEnd = headerSize + (this->endOffset - headerSize) / recordSize * recordSize;
+    if (wholeEnd > headerSize) {
+        ranges.emplace_back(headerSize, wholeEnd);
+    }
+}
+
+void TableScanIterator::restrictToSlots(const vector<pair<uint64_t, uint64_t>> &slotRanges) {
+    const uint64_t wholeEnd = ranges.empty() ? headerSize : ranges.back().second;
+    ranges.clear();
+    for (const auto &[first, end]: slotRanges) {
+        const uint64_t from = slotOffset(first, recordSize), to = min<uint64_t>(slotOffset(end, recordSize), wholeEnd);
+        if (from < to) {
+            ranges.emplace_back(from, to);
+        }
+    }
+}
+
+// Records of the chunk that starts at `offset`. An offset at or past the end
+// of a range moves to the start of the next one; 0 once no range is left.
+size_t TableScanIterator::chunkAt(uint64_t &offset) const {
+    const auto range = upper_bound(ranges.begin(), ranges.end(), offset,
+                                   [](uint64_t value, const pair<uint64_t, uint64_t> &r) { return value < r.second; });
+    if (range == ranges.end()) {
+        return 0;
+    }
+    offset = max(offset, range->first);
+    return min<uint64_t>((range->second - offset) / recordSize, chunkRecords);
+}
+
+void TableScanIterator::readColumns(const TableInfo &table, vector<int> columns) {
+    if (table.header.layout == TableLayout::Columnar || isCompressed(table)) {
+        this->table = &table;
+        this->columns = move(columns);
+    }
+}
+
+// Set up the backend's read-ahead when the first chunk is needed
+void TableScanIterator::startReadAhead() {
+    readAheadStarted = true;
+    if (ioBackend() == IoBackend::Mmap && (mapping = fileMappings().get(filePath))) {
+        mapping->view(headerSize, this->endOffset - headerSize); // map up to the end first
+        for (const auto &[from, to]: ranges) {
+            mapping->advise(from, to - from, MADV_SEQUENTIAL);
+        }
+    }
+    if (ioBackend() == IoBackend::Uring && recordSize > 0 && (fd = open(filePath.c_str(), O_RDONLY)) >= 0) {
+        ring = make_unique<IoRing>(scanReadAheadDepth);
+        if (!ring->ready()) {
+            ring.reset();
+            return;
+        }
+        const size_t chunkBytes = chunkRecords * recordSize;
+        readAheadBuffers.resize(scanReadAheadDepth * chunkBytes);
+        vector<iovec> buffers(scanReadAheadDepth);
+        for (size_t slot = 0; slot < buffers.size(); slot++) {
+            buffers[slot] = {readAheadBuffers.data() + slot * chunkBytes, chunkBytes};
+        }
+        ring->registerBuffers(buffers);
+        readAheadOffset = nextOffset;
+    }
+    // Overlapping the reads with the filter needs a second core
+    if (ioBackend() == IoBackend::BufferPool && recordSize > 0 && thread::hardware_concurrency() > 1 &&
+        (this->endOffset - headerSize) / recordSize > chunkRecords) {
+        // Chunks are read from the file directly, bypassing the pool and its latch
+        fd = open(filePath.c_str(), O_RDONLY);
+        if (fd >= 0) posix_fadvise(fd, nextOffset, chunkRecords * recordSize, POSIX_FADV_WILLNEED);
+        readAheadBuffers.resize(scanPrefetchBuffers * chunkRecords * recordSize);
+        readAheadOffset = nextOffset;
+        prefetcher = thread(&TableScanIterator::prefetchChunks, this);
+    }
+}
+
+TableScanIterator::~TableScanIterator() {
+    if (prefetcher.joinable()) {
+        {
+            lock_guard<mutex> guard(prefetchLatch);
+            prefetchStopping = true;
+        }
+        prefetchChanged.notify_all();
+        prefetcher.join();
+    }
+    ring.reset(); // waits for the reads into readAheadBuffers
+    if (fd >= 0) close(fd);
+}
+
+// Read [offset, offset + length) with pread, except for pages the pool has
+// newer copies of and whatever isn't on disk yet
+bool TableScanIterator::readDirect(uint64_t offset, char *buffer, size_t length) {
+    const uint64_t end = offset + length;
+    uint64_t position = offset;
+    const auto readRun = [&](uint64_t runEnd, bool fromPool) {
+        const uint64_t start = position;
+        char *target = buffer + (start - offset);
+        position = runEnd;
+        if (start == runEnd) return true;
+        if (!fromPool) {
+            size_t done = 0;
+            while (start + done < runEnd) {
+                const ssize_t got = pread(fd, target + done, runEnd - start - done, start + done);
+                if (got <= 0) break;
+                done += got;
+            }
+            if (start + done == runEnd) return true;
+        }
+        return bufferPool().readBytes(filePath, start, target, runEnd - start);
+    };
+    for (const uint64_t pageNo: bufferPool().dirtyPages(filePath, offset, length)) {
+        if (!readRun(max(position, pageNo * PAGE_SIZE), false) ||
+            !readRun(min(end, (pageNo + 1) * PAGE_SIZE), true)) {
+            return false;
+        }
+    }
+    return readRun(end, false);
+}
+
+// Prefetch thread: reads chunk k into buffer k % scanPrefetchBuffers as soon
+// as the scan has moved past the chunk that was in it
+void TableScanIterator::prefetchChunks() {
+    const size_t chunkBytes = chunkRecords * recordSize;
+    for (size_t k = 0;; k++) {
+        const size_t length = chunkAt(readAheadOffset) * recordSize;
+        if (length == 0) return;
+        const size_t slot = k % scanPrefetchBuffers;
+        {
+            unique_lock<mutex> lock(prefetchLatch);
+            prefetchChanged.wait(lock, [&] { return prefetchStopping || prefetchState[slot] == PrefetchEmpty; });
+            if (prefetchStopping) return;
+        }
+
+        // The kernel fetches the following chunk while this one is copied
+        if (fd >= 0) posix_fadvise(fd, readAheadOffset + length, chunkBytes, POSIX_FADV_WILLNEED);
+        char *buffer = readAheadBuffers.data() + slot * chunkBytes;
+        const bool read = fd >= 0 ? readDirect(readAheadOffset, buffer, length)
+                                  : bufferPool().readBytes(filePath, readAheadOffset, buffer, length);
+        readAheadOffset += length;
+        {
+            lock_guard<mutex> guard(prefetchLatch);
+            prefetchState[slot] = read ? PrefetchReady : PrefetchFailed;
+        }
+        prefetchChanged.notify_all();
+        if (!read) return;
+    }
+}
+
+bool TableScanIterator::loadPrefetchedChunk() {
+    unique_lock<mutex> lock(prefetchLatch);
+    if (loadedChunks > 0) {
+        prefetchState[(loadedChunks - 1) % scanPrefetchBuffers] = PrefetchEmpty; // the filter is done with it
+        prefetchChanged.notify_all();
+    }
+    const size_t slot = loadedChunks++ % scanPrefetchBuffers;
+    prefetchChanged.wait(lock, [&] { return prefetchState[slot] != PrefetchEmpty; });
+    chunkData = readAheadBuffers.data() + slot * chunkRecords * recordSize;
+    return prefetchState[slot] == PrefetchReady;
+}
+
+// Start reading the chunk after the last one queued into the given slot
+void TableScanIterator::queueReadAhead(size_t slot) {
+    const size_t length = chunkAt(readAheadOffset) * recordSize;
+    if (length == 0) {
+        return;
+    }
+    const size_t chunkBytes = chunkRecords * recordSize;
+    ring->queueRead(fd, {readAheadOffset, length, readAheadBuffers.data() + slot * chunkBytes, static_cast<int>(slot)},
+                    slot);
+    readAheadOffset += length;
+}
+
+bool TableScanIterator::loadReadAheadChunk() {
+    // The chunk just consumed frees its slot for the read furthest ahead
+    if (loadedChunks == 0) {
+        for (size_t slot = 0; slot < scanReadAheadDepth; slot++) queueReadAhead(slot);
+    } else {
+        queueReadAhead((loadedChunks - 1) % scanReadAheadDepth);
+    }
+
+    const size_t slot = loadedChunks++ % scanReadAheadDepth;
+    char *buffer = readAheadBuffers.data() + slot * chunkRecords * recordSize;
+    chunkData = buffer;
+    if (ring->waitFor(slot)) {
+        return true;
+    }
+    // Pages not yet written back end the file early; the pool has them
+    return bufferPool().readBytes(filePath, nextOffset, buffer, available * recordSize);
+}
+
+bool TableScanIterator::loadChunk() {
+    available = readFailed ? 0 : chunkAt(nextOffset);
+    if (available == 0) {
+        return false;
+    }
+
+    if (table) {
+        // Columnar: only the columns the query reads, gathered into row-major
+        // records, and never past the end of a segment so a batch has one
+        // dictionary. Compressed: decompressed blocks.
+        if (table->header.layout == TableLayout::Columnar) {
+            const uint64_t segmentRecords = table->header.segmentRecords;
+            available = min<uint64_t>(available,
+                                      segmentRecords - (nextOffset - headerSize) / recordSize % segmentRecords);
+        }
+        dictionaries.clear();
+        chunk.resize(chunkRecords * recordSize);
+        chunkData = chunk.data();
+        if (!readSlots(*table, filePath, (nextOffset - headerSize) / recordSize, available, columns,
+                       chunk.data())) {
+            cerr << "Error: Failed to read records at offset " << nextOffset << " from " << filePath << endl;
+            readFailed = true;
+            available = 0;
+            return false;
+        }
+        chunkOffset = nextOffset;
+        nextOffset += available * recordSize;
+        position = 0;
+        return true;
+    }
+    if (!readAheadStarted) {
+        startReadAhead();
+    }
+    if (mapping && (chunkData = mapping->view(nextOffset, available * recordSize))) {
+        chunkOffset = nextOffset;
+        nextOffset += available * recordSize;
+        position = 0;
+        return true;
+    }
+    if (ring || prefetcher.joinable()) {
+        if (!(ring ? loadReadAheadChunk() : loadPrefetchedChunk())) {
+            cerr << "Error: Failed to read records at offset " << nextOffset << " from " << filePath << endl;
+            readFailed = true;
+            available = 0;
+            return false;
+        }
+        chunkOffset = nextOffset;
+        nextOffset += available * recordSize;
+        position = 0;
+        return true;
+    }
+
+    chunk.resize(chunkRecords * recordSize);
+    chunkData = chunk.data();
+    if (!bufferPool().readBytes(filePath, nextOffset, chunk.data(), available * recordSize)) {
+        cerr << "Error: Failed to read records at offset " << nextOffset << " from " << filePath << endl;
+        readFailed = true;
+        available = 0;
+        return false;
+    }
+
+    chunkOffset = nextOffset;
+    nextOffset += available * recordSize;
+    position = 0;
+    return true;
+}
+
+const char *TableScanIterator::next() {
+    if (position == available && !loadChunk()) {
+        return nullptr;
+    }
+    return chunkData + (position++) * recordSize;
+}
+
+size_t TableScanIterator::nextBatch(const char *&records) {
+    if (position == available && !loadChunk()) {
+        return 0;
+    }
+    records = chunkData + position * recordSize;
+    const size_t count = available - position;
+    batchPosition = position;
+    position = available;
+    return count;
+}
+
+const uint16_t *TableScanIterator::columnCodes(int column, const SegmentDictionary *&dictionary) {
+    if (!table || table->header.layout != TableLayout::Columnar) {
+        return nullptr;
+    }
+    const uint64_t segmentRecords = table->header.segmentRecords;
+    const uint64_t slot = (chunkOffset - headerSize) / recordSize + batchPosition;
+    shared_ptr<const SegmentDictionary> held;
+    if (!segmentDictionary(*table, filePath, slot / segmentRecords, column, held) || !held) {
+        return nullptr;
+    }
+    dictionary = held.get();
+    dictionaries.push_back(move(held));
+    return dictionary->codes.data() + slot % segmentRecords;
+}
+
+// ==================== Index Lookups ====================
+
+IndexLookupIterator::IndexLookupIterator(const string &tableName, int recordSize, int firstId, int lastId,
+                                         size_t chunkBytes)
+    : dataFilePath(dataPath + tableName + dataFileType),
+      mapFilePath(dataPath + tableName + idMapFileType),
+      recordSize(recordSize),
+      nextId(max(firstId, 0)),
+      lastId(lastId),
+      chunkRecords(recordSize > 0 ? max<size_t>(chunkBytes / recordSize, 1) : 0) {
+    if (recordSize <= 0) {
+        this->lastId = -1;
+    }
+    // A point lookup only needs room for one record
+    chunkRecords = min<size_t>(chunkRecords, max<long long>(this->lastId - nextId + 1, 1));
+    chunk.resize(chunkRecords * max(recordSize, 0));
+    if (ioBackend() == IoBackend::Mmap) {
+        dataMapping = fileMappings().get(dataFilePath);
+        mapMapping = fileMappings().get(mapFilePath);
+    }
+}
+
+void IndexLookupIterator::readColumns(const TableInfo &table, vector<int> columns) {
+    if (table.header.layout == TableLayout::Columnar || isCompressed(table)) {
+        this->table = &table;
+        this->columns = move(columns);
+    }
+}
+
+IndexLookupIterator::~IndexLookupIterator() {
+    ring.reset(); // waits for reads into `slots` and `chunk`
+    if (dataFd >= 0) close(dataFd);
+    if (mapFd >= 0) close(mapFd);
+}
+
+// Read all runs at once through io_uring. False when the backend isn't uring,
+// there is a single run, or a read failed or came back short; the caller then
+// reads the runs through the pool.
+bool IndexLookupIterator::readRuns(const string &filePath, int &fd, const vector<ReadRequest> &runs) {
+    if (ioBackend() != IoBackend::Uring || runs.size() < 2) {
+        return false;
+    }
+    if (!ring) {
+        ring = make_unique<IoRing>(lookupRingEntries);
+    }
+    if (fd < 0) {
+        fd = open(filePath.c_str(), O_RDONLY);
+    }
+    return ring->ready() && fd >= 0 && ring->readAll(fd, runs);
+}
+
+IndexLookupIterator::IndexLookupIterator(const string &tableName, int recordSize, vector<int> ids,
+                                         size_t chunkBytes)
+    : IndexLookupIterator(tableName, recordSize, 0, static_cast<int>(ids.size()) - 1, chunkBytes) {
+    this->ids = move(ids);
+    idList = true;
+}
+
+size_t IndexLookupIterator::nextBatch(const char *&records) {
+    // A chunk of IDs may be all holes; keep going until one has a live record
+    size_t found = 0;
+    while (found == 0 && nextId <= lastId && !readFailed) {
+        const size_t count = min<long long>(lastId - nextId + 1, chunkRecords);
+        slots.resize(count);
+        runs.clear();
+        for (size_t first = 0; first < count;) {
+            // Slots of consecutive IDs sit next to each other in the map file
+            const long long firstId = idList ? ids[nextId + first] : nextId + first;
+            size_t last = idList ? first : count - 1;
+            while (idList && last + 1 < count && ids[nextId + last + 1] == ids[nextId + last] + 1) {
+                last++;
+            }
+            runs.push_back({static_cast<uint64_t>(firstId) * sizeof(int), (last - first + 1) * sizeof(int),
+                            reinterpret_cast<char *>(&slots[first])});
+            first = last + 1;
+        }
+
+        if (!readRuns(mapFilePath, mapFd, runs)) {
+            for (const auto &run: runs) {
+                const char *mapped = mapMapping ? mapMapping->view(run.offset, run.length) : nullptr;
+                if (mapped) {
+                    memcpy(run.buffer, mapped, run.length);
+                } else if (!bufferPool().readBytes(mapFilePath, run.offset, run.buffer, run.length)) {
+                    cerr << "Error: Failed to read slots for IDs " << run.offset / sizeof(int) << ".."
+                         << (run.offset + run.length) / sizeof(int) - 1 << endl;
+                    readFailed = true;
+                    return 0;
+                }
+            }
+        }
+        nextId += count;
+
+        slots.erase(remove(slots.begin(), slots.end(), noSlot), slots.end());
+        found = slots.size();
+    }
+
+    // One read per run of adjacent records
+    runs.clear();
+    for (size_t first = 0; first < found;) {
+        size_t last = first;
+        while (last + 1 < found && slots[last + 1] == slots[last] + 1) {
+            last++;
+        }
+        runs.push_back({slotOffset(slots[first], recordSize), (last - first + 1) * recordSize,
+                        chunk.data() + first * recordSize});
+        first = last + 1;
+    }
+
+    if (table) {
+        for (const auto &run: runs) {
+            if (!readSlots(*table, dataFilePath, (run.offset - headerSize) / recordSize,
+                           run.length / recordSize, columns, run.buffer)) {
+                cerr << "Error reading the record in slot " << (run.offset - headerSize) / recordSize << endl;
+                readFailed = true;
+                return 0;
+            }
+        }
+    } else if (!readRuns(dataFilePath, dataFd, runs)) {
+        for (const auto &run: runs) {
+            const char *mapped = dataMapping ? dataMapping->view(run.offset, run.length) : nullptr;
+            if (mapped && runs.size() == 1) {
+                records = mapped; // the whole batch is one run, no copy needed
+                return found;
+            }
+            if (mapped) {
+                memcpy(run.buffer, mapped, run.length);
+            } else if (!bufferPool().readBytes(dataFilePath, run.offset, run.buffer, run.length)) {
+                cerr << "Error reading the record in slot " << (run.offset - headerSize) / recordSize << endl;
+                readFailed = true;
+                return 0;
+            }
+        }
+    }
+
+    records = chunk.data();
+    return found;
+}
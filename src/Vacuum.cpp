@@ -0,0 +1,285 @@
+#include "../include/Vacuum.h"
+#include "../include/BloomFilter.h"
+#include "../include/Catalog.h"
+#include "../include/Columnar.h"
+#include "../include/Compression.h"
+#include "../include/BufferPool.h"
+#include "../include/IoBackend.h"
+#include "../include/SecondaryIndex.h"
+#include "../include/TableScan.h"
+#include "../include/WAL.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+// ==================== Swap ====================
+
+// fsync a file or directory by path
+static bool syncPath(const string &path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    const bool synced = fsync(fd) == 0;
+    close(fd);
+    return synced;
+}
+
+// Durably record which files are about to be replaced. Renaming the intent
+// file into place is the point where the VACUUM can no longer be undone.
+static bool writeIntent(const string &tableName, const vector<string> &paths) {
+    const string intentPath = dataPath + tableName + vacuumIntentFileType;
+    const string tempPath = intentPath + vacuumNewFileType;
+    {
+        ofstream file(tempPath, ios::trunc);
+        for (const auto &path: paths) {
+            file << path << "\n";
+        }
+        if (!file) {
+            return false;
+        }
+    }
+    return syncPath(tempPath) && rename(tempPath.c_str(), intentPath.c_str()) == 0 && syncPath(dataPath);
+}
+
+bool completeVacuum(const string &tableName) {
+    const string intentPath = dataPath + tableName + vacuumIntentFileType;
+    ifstream intent(intentPath);
+    if (!intent) {
+        return true;
+    }
+
+    // A path whose new file is gone was renamed before the crash
+    invalidateSegmentDictionaries();
+    invalidateCompressedBlocks();
+    string path;
+    while (getline(intent, path)) {
+        const string newPath = path + vacuumNewFileType;
+        bufferPool().dropFile(path);
+        bufferPool().dropFile(newPath);
+        fileMappings().drop(path);
+        if (access(newPath.c_str(), F_OK) == 0 && rename(newPath.c_str(), path.c_str()) != 0) {
+            cerr << "Error: Failed to swap in " << newPath << endl;
+            return false;
+        }
+    }
+    intent.close();
+
+    // Every slot of the new file is live, nothing is waiting for reuse
+    const string freeListPath = dataPath + tableName + freeListFileType;
+    bufferPool().dropFile(freeListPath);
+    remove(freeListPath.c_str());
+
+    if (!syncPath(dataPath) || remove(intentPath.c_str()) != 0) {
+        cerr << "Error: Failed to finish the VACUUM of " << tableName << endl;
+        return false;
+    }
+    return true;
+}
+
+// ==================== Rewrite ====================
+
+// Copy the live records into `newDataPath` packed from the first slot, in ID
+// order, and write the matching ID map to `newMapPath`. Returns the header of
+// the new file through `header`.
+static bool rewriteRecords(const TableInfo &table, const string &newDataPath, const string &newMapPath,
+                           DBHeader &header) {
+    const int recordSize = table.recordSize;
+    const int idOffset = table.columnOffsets[table.columnIndex(ID_COLUMN)];
+
+    header = table.header;
+    header.blockRecords = 0;
+    header.slotCount = 0;
+    header.freeSlots = 0;
+    header.freeOffset = headerSize;
+
+    IndexLookupIterator live(table.name, recordSize, 0, static_cast<RecordId>(table.header.nextRecordId) - 1);
+    live.readColumns(table, {});
+    TableInfo written = table; // the old file may be compressed, the new one isn't yet
+    written.header = header;
+    vector<int> mapEntries;
+    uint64_t mappedIds = 0; // IDs with a map entry in the new file
+    const char *records;
+    while (const size_t count = live.nextBatch(records)) {
+        if (!writeSlots(written, newDataPath, header.slotCount, records, count, true)) {
+            return false;
+        }
+
+        // Deleted IDs between live ones keep their holes
+        mapEntries.clear();
+        for (size_t i = 0; i < count; i++) {
+            int id;
+            memcpy(&id, records + i * recordSize + idOffset, sizeof(int));
+            mapEntries.resize(id - mappedIds, noSlot);
+            mapEntries.push_back(header.slotCount + i);
+        }
+        if (!bufferPool().writeBytes(newMapPath, mappedIds * sizeof(int),
+                                     reinterpret_cast<const char *>(mapEntries.data()),
+                                     mapEntries.size() * sizeof(int), true)) {
+            return false;
+        }
+        mappedIds += mapEntries.size();
+
+        header.slotCount += count;
+        header.freeOffset += count * recordSize;
+    }
+    if (live.failed()) {
+        return false;
+    }
+
+    mapEntries.assign(header.nextRecordId - mappedIds, noSlot);
+    if (!mapEntries.empty() &&
+        !bufferPool().writeBytes(newMapPath, mappedIds * sizeof(int),
+                                 reinterpret_cast<const char *>(mapEntries.data()),
+                                 mapEntries.size() * sizeof(int), true)) {
+        return false;
+    }
+
+    header.numRecords = header.slotCount;
+    return bufferPool().writeBytes(newDataPath, 0, reinterpret_cast<const char *>(&header), sizeof(DBHeader), true);
+}
+
+bool vacuumTable(const string &tableName, bool compress) {
+    // No writer may change the table while it's copied, and nothing logged
+    // against the old files may be replayed onto the new ones
+    lock_guard<mutex> writing(wal().writerLatch());
+    shared_ptr<const TableInfo> table = catalog().getTable(tableName);
+    if (!table) {
+        cerr << "Error: Table " << tableName << " not found" << endl;
+        return false;
+    }
+    if (!wal().checkpointLocked()) {
+        return false;
+    }
+
+    vector<string> paths = {dataPath + tableName + dataFileType, dataPath + tableName + idMapFileType};
+    for (const auto &index: table->indexes) {
+        paths.push_back(index.filePath);
+    }
+    // Zone bounds and Bloom filters are rebuilt from the live records, which
+    // also gives tables written before zone maps one. These files, and the
+    // segment directory, are swapped in even if nothing gets written to them.
+    const size_t firstSidecar = paths.size();
+    paths.push_back(companionFilePath(paths[0], zoneMapFileType));
+    for (const int column: table->bloomColumns) {
+        paths.push_back(bloomFilePath(paths[0], table->columns[column].name));
+    }
+    if (table->header.layout == TableLayout::Columnar) {
+        paths.push_back(companionFilePath(paths[0], segmentFileType));
+    }
+    const size_t sidecarEnd = paths.size();
+    if (compress) {
+        paths.push_back(companionFilePath(paths[0], blockIndexFileType));
+    }
+    auto discard = [&] {
+        for (const auto &path: paths) {
+            bufferPool().dropFile(path + vacuumNewFileType);
+            remove((path + vacuumNewFileType).c_str());
+        }
+    };
+    discard(); // leftovers of a VACUUM that failed before its intent was written
+
+    DBHeader header;
+    bool written = true;
+    for (size_t i = firstSidecar; written && i < sidecarEnd; i++) {
+        written = bufferPool().writeBytes(paths[i] + vacuumNewFileType, 0, nullptr, 0, true);
+    }
+    written = written && rewriteRecords(*table, paths[0] + vacuumNewFileType, paths[1] + vacuumNewFileType, header);
+
+    // Secondary indexes are rebuilt too: the IDs they hold don't change, but
+    // bulk loading drops the space of lazily deleted entries
+    for (size_t i = 0; written && i < table->indexes.size(); i++) {
+        written = buildIndex(*table, table->indexes[i].columnIndex, paths[2 + i] + vacuumNewFileType);
+    }
+    // Compressed last, once every record of the new file is written
+    written = written && (!compress || compressDataFile(paths[0] + vacuumNewFileType, header, table->recordSize));
+    for (const auto &path: paths) {
+        written = written && bufferPool().flushFile(path + vacuumNewFileType);
+    }
+    written = written && bufferPool().syncAll();
+    if (!written) {
+        cerr << "Error: Failed to rewrite table " << tableName << endl;
+        discard();
+        return false;
+    }
+    for (const auto &path: paths) {
+        bufferPool().dropFile(path + vacuumNewFileType);
+    }
+
+    // Wait for readers of the old files, then swap
+    unique_lock<shared_mutex> swapping(catalog().swapLatch());
+    if (!writeIntent(tableName, paths)) {
+        cerr << "Error: Failed to start swapping files of table " << tableName << endl;
+        discard();
+        return false;
+    }
+    bool swapped = completeVacuum(tableName);
+
+    // A plain VACUUM leaves the table uncompressed
+    const string blockPath = companionFilePath(paths[0], blockIndexFileType);
+    if (swapped && !compress && isCompressed(*table)) {
+        bufferPool().dropFile(blockPath);
+        swapped = remove(blockPath.c_str()) == 0;
+    }
+    catalog().invalidate(tableName);
+    return swapped;
+}
+
+// ==================== Background Compactor ====================
+
+static thread compactor;
+static mutex compactorLatch;
+static condition_variable compactorWake;
+static bool compactorStopping = false;
+
+static bool worthVacuuming(const TableInfo &table) {
+    return table.header.slotCount > 0 &&
+           table.header.freeSlots >= vacuumDeadSlotRatio * table.header.slotCount;
+}
+
+void startBackgroundVacuum() {
+    const char *value = getenv(vacuumIntervalEnv.c_str());
+    if (!value || compactor.joinable()) {
+        return;
+    }
+
+    int seconds = 0;
+    try {
+        seconds = stoi(value);
+    } catch (const exception &) {
+    }
+    if (seconds <= 0) {
+        if (string(value) != "0") {
+            cerr << "Warning: Invalid " << vacuumIntervalEnv << ", background VACUUM is off" << endl;
+        }
+        return;
+    }
+
+    compactorStopping = false;
+    compactor = thread([seconds] {
+        unique_lock<mutex> lock(compactorLatch);
+        while (!compactorWake.wait_for(lock, chrono::seconds(seconds), [] { return compactorStopping; })) {
+            lock.unlock();
+            for (const auto &tableName: catalog().tableNames()) {
+                shared_ptr<const TableInfo> table = catalog().getTable(tableName);
+                if (table && worthVacuuming(*table)) {
+                    vacuumTable(tableName);
+                }
+            }
+            lock.lock();
+        }
+    });
+}
+
+void stopBackgroundVacuum() {
+    if (!compactor.joinable()) {
+        return;
+    }
+    {
+        lock_guard<mutex> guard(compactorLatch);
+        compactorStopping = true;
+    }
+    compactorWake.notify_all();
+    compactor.join();
+}
@@ -0,0 +1,278 @@
+#include "../include/WAL.h"
+#include "../include/Storage.h"
+#include "../include/BufferPool.h"
+#include "../include/Columnar.h"
+#include "../include/IoBackend.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Every log record is a header followed by its writes:
+//   uint16 path length, path, uint64 offset, uint32 length, bytes
+struct WalRecordHeader {
+    char magic[4];
+    uint32_t payloadSize;
+    uint32_t checksum; // CRC-32 of the payload
+    uint32_t writeCount;
+    uint64_t lsn;
+};
+
+constexpr char walRecordMagic[4] = {'W', 'A', 'L', '1'};
+
+static uint32_t crc32(const char *data, size_t length) {
+    static const array<uint32_t, 256> table = [] {
+        array<uint32_t, 256> entries{};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; bit++) {
+                value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+            }
+            entries[i] = value;
+        }
+        return entries;
+    }();
+
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; i++) {
+        crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+template<typename T>
+static void appendValue(string &out, const T &value) {
+    out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+// ==================== Log File ====================
+
+WriteAheadLog::WriteAheadLog() : filePath(dataPath + walFileName) {
+    openLog();
+    bufferPool().setLogFlusher([this](uint64_t lsn) { return waitDurable(lsn); });
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    bufferPool().setLogFlusher(nullptr);
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+bool WriteAheadLog::openLog() {
+    fd = open(filePath.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        cerr << "Error: Failed to open write-ahead log " << filePath << endl;
+        return false;
+    }
+    logSize = lseek(fd, 0, SEEK_END);
+    return true;
+}
+
+uint64_t WriteAheadLog::append(const string &record, uint32_t writeCount) {
+    lock_guard<mutex> guard(latch);
+    WalRecordHeader header{};
+    memcpy(header.magic, walRecordMagic, 4);
+    header.payloadSize = static_cast<uint32_t>(record.size());
+    header.checksum = crc32(record.data(), record.size());
+    header.writeCount = writeCount;
+    header.lsn = nextLsn++;
+    buffer.append(reinterpret_cast<const char *>(&header), sizeof(header));
+    buffer.append(record);
+    logSize += sizeof(header) + record.size();
+    return header.lsn;
+}
+
+bool WriteAheadLog::waitDurable(uint64_t lsn) {
+    unique_lock<mutex> lock(latch);
+    while (durableLsn < lsn) {
+        if (failed) {
+            return false;
+        }
+        if (flushing) {
+            flushed.wait(lock);
+            continue;
+        }
+
+        // Become the leader: write and sync everything appended so far
+        flushing = true;
+        string batch;
+        batch.swap(buffer);
+        const uint64_t batchLsn = nextLsn - 1;
+        lock.unlock();
+
+        bool success = fd >= 0;
+        for (size_t written = 0; success && written < batch.size();) {
+            const ssize_t result = write(fd, batch.data() + written, batch.size() - written);
+            success = result > 0;
+            written += max<ssize_t>(result, 0);
+        }
+        success = success && fdatasync(fd) == 0;
+        syncs++;
+        if (!success) {
+            cerr << "Error: Failed to write the write-ahead log " << filePath << endl;
+        }
+
+        // After a failure the batch's tail may or may not be on disk; recovery
+        // stops at the first torn record
+        lock.lock();
+        if (success) {
+            durableLsn = batchLsn;
+        } else {
+            failed = true;
+        }
+        flushing = false;
+        flushed.notify_all();
+    }
+    return true;
+}
+
+bool WriteAheadLog::needsCheckpoint() {
+    lock_guard<mutex> guard(latch);
+    return logSize > walCheckpointBytes;
+}
+
+bool WriteAheadLog::checkpoint() {
+    lock_guard<mutex> writerGuard(writer);
+    return checkpointLocked();
+}
+
+bool WriteAheadLog::checkpointLocked() {
+    uint64_t lastLsn;
+    {
+        lock_guard<mutex> guard(latch);
+        lastLsn = nextLsn - 1;
+    }
+    if (!waitDurable(lastLsn)) {
+        cerr << "Error: Checkpoint failed, the write-ahead log can't be written" << endl;
+        return false;
+    }
+
+    if (!bufferPool().flushAll() || !bufferPool().syncAll()) {
+        cerr << "Error: Checkpoint failed, keeping the write-ahead log" << endl;
+        return false;
+    }
+
+    // Every logged change is in the table files now
+    lock_guard<mutex> guard(latch);
+    if (fd >= 0 && logSize > 0 && ftruncate(fd, 0) != 0) {
+        cerr << "Error: Failed to truncate the write-ahead log" << endl;
+        return false;
+    }
+    logSize = 0;
+    return true;
+}
+
+// ==================== Recovery ====================
+
+bool WriteAheadLog::recover() {
+    ifstream file(filePath, ios::binary);
+    string log((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+
+    size_t position = 0, recovered = 0;
+    while (position + sizeof(WalRecordHeader) <= log.size()) {
+        WalRecordHeader header;
+        memcpy(&header, log.data() + position, sizeof(header));
+        const char *payload = log.data() + position + sizeof(header);
+
+        // A torn or partial record at the tail was never acknowledged, stop there
+        if (memcmp(header.magic, walRecordMagic, 4) != 0 ||
+            position + sizeof(header) + header.payloadSize > log.size() ||
+            crc32(payload, header.payloadSize) != header.checksum) {
+            break;
+        }
+
+        size_t cursor = 0;
+        while (cursor < header.payloadSize) {
+            uint16_t pathLength;
+            memcpy(&pathLength, payload + cursor, sizeof(pathLength));
+            cursor += sizeof(pathLength);
+            const string path(payload + cursor, pathLength);
+            cursor += pathLength;
+
+            uint64_t offset;
+            uint32_t length;
+            memcpy(&offset, payload + cursor, sizeof(offset));
+            cursor += sizeof(offset);
+            memcpy(&length, payload + cursor, sizeof(length));
+            cursor += sizeof(length);
+
+            if (!bufferPool().writeBytes(path, offset, payload + cursor, length, true)) {
+                cerr << "Error: Failed to replay a write to " << path << endl;
+                return false;
+            }
+            cursor += length;
+        }
+
+        position += sizeof(header) + header.payloadSize;
+        recovered++;
+    }
+
+    if (recovered > 0) {
+        cout << "Recovered " << recovered << " transactions from the write-ahead log" << endl;
+    }
+    return checkpoint();
+}
+
+WriteAheadLog &wal() {
+    static WriteAheadLog instance;
+    return instance;
+}
+
+// ==================== Transactions ====================
+
+WalTransaction::WalTransaction() : writerLock(wal().writerLatch()) {
+    bufferPool().beginCapture();
+}
+
+WalTransaction::~WalTransaction() {
+    if (!committed) {
+        bufferPool().abortCapture();
+        invalidateSegmentDictionaries(); // may have been decoded from the undone pages
+    }
+}
+
+bool WalTransaction::commit() {
+    if (committed) {
+        return true;
+    }
+    committed = true;
+
+    const vector<WriteRange> ranges = bufferPool().endCapture();
+    if (ranges.empty()) {
+        bufferPool().releaseCapture(0);
+        writerLock.unlock();
+        return true;
+    }
+
+    // After-images of every changed range, read back from the pinned pages
+    string payload;
+    vector<char> bytes;
+    bool success = true;
+    for (const auto &range: ranges) {
+        bytes.resize(range.length);
+        success = bufferPool().readBytes(range.filePath, range.offset, bytes.data(), range.length) && success;
+        appendValue(payload, static_cast<uint16_t>(range.filePath.size()));
+        payload += range.filePath;
+        appendValue(payload, range.offset);
+        appendValue(payload, static_cast<uint32_t>(range.length));
+        payload.append(bytes.data(), bytes.size());
+    }
+
+    const uint64_t lsn = wal().append(payload, static_cast<uint32_t>(ranges.size()));
+    bufferPool().releaseCapture(lsn);
+    writerLock.unlock();
+
+    if (!wal().waitDurable(lsn)) {
+        return false;
+    }
+
+    // Mapped and io_uring readers only see what is in the files
+    if (ioBackend() != IoBackend::BufferPool) {
+        success = bufferPool().writeBackRanges(ranges) && success;
+    }
+    if (wal().needsCheckpoint()) {
+        wal().checkpoint();
+    }
+    return success;
+}
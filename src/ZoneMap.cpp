@@ -0,0 +1,227 @@
+#include "../include/ZoneMap.h"
+#include "../include/BloomFilter.h"
+#include "../include/BTree.h"
+#include "../include/BufferPool.h"
+
+using namespace std;
+
+// ==================== Zone Entries ====================
+
+// Followed by the minimum and the maximum record of the zone
+struct ZoneHeader {
+    uint32_t records; // records folded in, zero for a zone nothing was written to
+    uint32_t reserved;
+};
+
+static size_t zoneEntryBytes(const TableInfo &table) {
+    return sizeof(ZoneHeader) + 2 * size_t(table.recordSize);
+}
+
+// Widen [low, high] of one column to take in `value`
+static void foldValue(ColumnType type, int size, const char *value, char *low, char *high) {
+    if (type == ColumnType::Float) {
+        float number;
+        memcpy(&number, value, sizeof(float));
+        if (isnan(number)) {
+            // NaN is unordered, only unbounded floats cover it
+            const float lowest = -numeric_limits<float>::infinity(), highest = numeric_limits<float>::infinity();
+            memcpy(low, &lowest, sizeof(float));
+            memcpy(high, &highest, sizeof(float));
+            return;
+        }
+    }
+    if (compareKeys(type, size, value, low) < 0) memcpy(low, value, size);
+    if (compareKeys(type, size, value, high) > 0) memcpy(high, value, size);
+}
+
+bool updateZoneMap(const TableInfo &table, const string &filePath, uint64_t firstSlot, const char *records,
+                   size_t count) {
+    const string zonePath = companionFilePath(filePath, zoneMapFileType);
+    if (count == 0 || !bufferPool().fileExists(zonePath)) {
+        return true;
+    }
+
+    const int recordSize = table.recordSize;
+    const size_t entryBytes = zoneEntryBytes(table);
+    const uint64_t zoneMapBytes = bufferPool().fileSize(zonePath);
+    vector<char> entry(entryBytes);
+    for (uint64_t slot = firstSlot; slot < firstSlot + count;) {
+        const uint64_t zone = slot / zoneRecords;
+        const size_t run = min<uint64_t>(firstSlot + count - slot, zoneRecords - slot % zoneRecords);
+        const char *in = records + (slot - firstSlot) * recordSize;
+
+        // A zone past the end of the file hasn't been written to yet
+        ZoneHeader header{};
+        char *low = entry.data() + sizeof(ZoneHeader);
+        char *high = low + recordSize;
+        if ((zone + 1) * entryBytes <= zoneMapBytes) {
+            if (!bufferPool().readBytes(zonePath, zone * entryBytes, entry.data(), entryBytes)) {
+                return false;
+            }
+            memcpy(&header, entry.data(), sizeof(header));
+        }
+        if (header.records == 0) {
+            memcpy(low, in, recordSize);
+            memcpy(high, in, recordSize);
+        }
+        for (size_t i = 0; i < run; i++) {
+            for (size_t column = 0; column < table.columns.size(); column++) {
+                const int offset = table.columnOffsets[column];
+                foldValue(table.columnTypes[column], table.columns[column].size, in + i * recordSize + offset,
+                          low + offset, high + offset);
+            }
+        }
+        header.records = static_cast<uint32_t>(min<uint64_t>(uint64_t(header.records) + run, UINT32_MAX));
+        memcpy(entry.data(), &header, sizeof(header));
+        if (!bufferPool().writeBytes(zonePath, zone * entryBytes, entry.data(), entryBytes, true)) {
+            return false;
+        }
+        slot += run;
+    }
+    return true;
+}
+
+// ==================== Zone Skipping ====================
+
+// Sign of (the record's value - the predicate's operand)
+static int compareOperand(const CompiledPredicate &predicate, const char *record) {
+    const char *value = record + predicate.offset;
+    switch (predicate.kind) {
+        case KernelKind::Int: {
+            int number;
+            memcpy(&number, value, sizeof(int));
+            return (number > predicate.intValue) - (number < predicate.intValue);
+        }
+        case KernelKind::Float: {
+            float number;
+            memcpy(&number, value, sizeof(float));
+            return (number > predicate.floatValue) - (number < predicate.floatValue);
+        }
+        case KernelKind::IntAsFloat: {
+            int whole;
+            memcpy(&whole, value, sizeof(int));
+            const double number = whole;
+            return (number > predicate.doubleValue) - (number < predicate.doubleValue);
+        }
+        case KernelKind::String: {
+            const int order = string_view(value, strnlen(value, predicate.size)).compare(predicate.stringValue);
+            return (order > 0) - (order < 0);
+        }
+    }
+    return 0;
+}
+
+// Whether some value in [low, high] of the predicate's column can satisfy it
+static bool mayMatch(const CompiledPredicate &predicate, const char *low, const char *high) {
+    if (predicate.isInList()) {
+        return any_of(predicate.anyOf.begin(), predicate.anyOf.end(),
+                      [&](const CompiledPredicate &alternative) { return mayMatch(alternative, low, high); });
+    }
+    if ((predicate.kind == KernelKind::Float && isnan(predicate.floatValue)) ||
+        (predicate.kind == KernelKind::IntAsFloat && isnan(predicate.doubleValue))) {
+        return true;
+    }
+    switch (predicate.op) {
+        case CompareOp::Equal:
+            return compareOperand(predicate, low) <= 0 && compareOperand(predicate, high) >= 0;
+        case CompareOp::NotEqual:
+            return compareOperand(predicate, low) != 0 || compareOperand(predicate, high) != 0;
+        case CompareOp::Less:
+            return compareOperand(predicate, low) < 0;
+        case CompareOp::LessEqual:
+            return compareOperand(predicate, low) <= 0;
+        case CompareOp::Greater:
+            return compareOperand(predicate, high) > 0;
+        case CompareOp::GreaterEqual:
+            return compareOperand(predicate, high) >= 0;
+    }
+    return true;
+}
+
+// An equality predicate (or IN list of them) on a column with Bloom filters,
+// and the filters
+struct BloomCheck {
+    const CompiledPredicate *predicate;
+    vector<char> filters;
+
+    bool mayMatch(uint64_t zone) const {
+        // A zone without a filter can't be ruled out
+        if ((zone + 1) * bloomZoneBytes > filters.size()) {
+            return true;
+        }
+        const char *filter = filters.data() + zone * bloomZoneBytes;
+        if (!predicate->isInList()) {
+            return bloomMayContain(filter, predicate->stringValue);
+        }
+        return any_of(predicate->anyOf.begin(), predicate->anyOf.end(), [&](const CompiledPredicate &alternative) {
+            return bloomMayContain(filter, alternative.stringValue);
+        });
+    }
+};
+
+static bool bloomCheckable(const TableInfo &table, const CompiledPredicate &predicate) {
+    const auto &columns = table.bloomColumns;
+    const bool filtered = find(columns.begin(), columns.end(), predicate.columnIndex) != columns.end();
+    return filtered && predicate.kind == KernelKind::String &&
+           (predicate.isInList() || predicate.op == CompareOp::Equal);
+}
+
+bool zoneSlotRanges(const TableInfo &table, const vector<CompiledPredicate> &predicates,
+                    vector<pair<uint64_t, uint64_t>> &ranges, size_t &zonesScanned, bool &bloomFiltered) {
+    vector<BloomCheck> blooms;
+    for (const auto &predicate: predicates) {
+        if (bloomCheckable(table, predicate)) {
+            blooms.push_back({&predicate, {}});
+            if (!readBloomFilters(table, predicate.columnIndex, blooms.back().filters)) {
+                return false;
+            }
+        }
+    }
+    const string zonePath = dataPath + table.name + zoneMapFileType;
+    const bool zoneMapped = bufferPool().fileExists(zonePath);
+    if (!zoneMapped && blooms.empty()) {
+        return false;
+    }
+    bloomFiltered = !blooms.empty();
+
+    const uint64_t slotCount = table.header.slotCount;
+    const uint64_t zoneCount = (slotCount + zoneRecords - 1) / zoneRecords;
+    const size_t entryBytes = zoneEntryBytes(table);
+    const uint64_t mappedZones = zoneMapped ? bufferPool().fileSize(zonePath) / entryBytes : 0;
+    vector<char> entries(min(zoneCount, mappedZones) * entryBytes);
+    if (!entries.empty() && !bufferPool().readBytes(zonePath, 0, entries.data(), entries.size())) {
+        return false;
+    }
+
+    ranges.clear();
+    zonesScanned = 0;
+    for (uint64_t zone = 0; zone < zoneCount; zone++) {
+        // A zone missing from the map can't be ruled out by its bounds
+        bool scan = zone >= mappedZones;
+        if (!scan) {
+            const char *entry = entries.data() + zone * entryBytes;
+            ZoneHeader header;
+            memcpy(&header, entry, sizeof(header));
+            const char *low = entry + sizeof(ZoneHeader);
+            const char *high = low + table.recordSize;
+            scan = header.records > 0 && all_of(predicates.begin(), predicates.end(), [&](const auto &predicate) {
+                return mayMatch(predicate, low, high);
+            });
+        }
+        scan = scan && all_of(blooms.begin(), blooms.end(), [&](const BloomCheck &bloom) {
+            return bloom.mayMatch(zone);
+        });
+        if (!scan) {
+            continue;
+        }
+
+        const uint64_t first = zone * zoneRecords, end = min<uint64_t>(first + zoneRecords, slotCount);
+        if (!ranges.empty() && ranges.back().second == first) {
+            ranges.back().second = end;
+        } else {
+            ranges.emplace_back(first, end);
+        }
+        zonesScanned++;
+    }
+    return true;
+}
@@ -1,20 +1,30 @@
 #include <bits/stdc++.h>
 #include "../include/Parser.h"
 #include "../include/Storage.h"
+#include "../include/BufferPool.h"
+#include "../include/WAL.h"
+#include "../include/Vacuum.h"
 using namespace std ;
 
 
 int main()
 {
+    // Redo whatever the last run committed but didn't write back
+    wal().recover();
+    startBackgroundVacuum();
 
     while (true) {
         string query;
         cout << "Enter SQL Query: ";
-        getline(cin, query); // Read full line input
+        if (!getline(cin, query)) { // Read full line input
+            break;
+        }
 
         executeQuery(query);
     }
 
+    stopBackgroundVacuum();
+    wal().checkpoint();
     return 0 ;
 
 }
\ No newline at end of file
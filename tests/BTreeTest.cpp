@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+#include "../include/BTree.h"
+#include "../include/BufferPool.h"
+#include "../include/SecondaryIndex.h"
+#include "../include/WAL.h"
+#include <filesystem>
+#include <random>
+using namespace std;
+
+const string treeTestFile = "./btree_test.btree";
+
+class BTreeTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        remove(treeTestFile.c_str());
+    }
+    void TearDown() override {
+        bufferPool().dropFile(treeTestFile);
+        remove(treeTestFile.c_str());
+    }
+
+    static string intKey(int value) {
+        return string(reinterpret_cast<const char *>(&value), sizeof(int));
+    }
+
+    // IDs with lowKey <= key <= highKey, in tree order
+    static vector<int> scan(BTree &tree, const char *lowKey, const char *highKey) {
+        vector<int> ids;
+        EXPECT_TRUE(tree.scanRange(lowKey, highKey, [&](const char *, int id) {
+            ids.push_back(id);
+            return true;
+        }));
+        return ids;
+    }
+};
+
+TEST_F(BTreeTest, RandomInsertsAndRemovesMatchReference) {
+    BTree tree(treeTestFile, ColumnType::Int, sizeof(int));
+    ASSERT_TRUE(tree.create());
+
+    // Few distinct values so duplicates span several leaves
+    mt19937 random(42);
+    set<pair<int, int>> reference;
+    for (int id = 0; id < 20000; id++) {
+        const int value = static_cast<int>(random() % 500) - 250;
+        ASSERT_TRUE(tree.insert(intKey(value).data(), id));
+        reference.insert({value, id});
+    }
+    for (int id = 0; id < 20000; id += 3) {
+        auto it = find_if(reference.begin(), reference.end(), [&](const auto &entry) { return entry.second == id; });
+        ASSERT_TRUE(tree.remove(intKey(it->first).data(), id));
+        reference.erase(it);
+    }
+    EXPECT_EQ(tree.size(), reference.size());
+
+    vector<int> expected;
+    for (const auto &entry: reference) expected.push_back(entry.second);
+    EXPECT_EQ(scan(tree, nullptr, nullptr), expected);
+
+    expected.clear();
+    for (const auto &entry: reference) {
+        if (entry.first >= -10 && entry.first <= 10) expected.push_back(entry.second);
+    }
+    const string low = intKey(-10), high = intKey(10);
+    EXPECT_EQ(scan(tree, low.data(), high.data()), expected);
+}
+
+TEST_F(BTreeTest, BulkLoadBuildsASearchableTree) {
+    vector<pair<string, int>> entries;
+    for (int id = 0; id < 50000; id++) {
+        entries.emplace_back(intKey(id / 4), id);
+    }
+
+    BTree tree(treeTestFile, ColumnType::Int, sizeof(int));
+    ASSERT_TRUE(tree.bulkLoad(entries));
+    EXPECT_EQ(tree.size(), entries.size());
+
+    const string key = intKey(777);
+    EXPECT_EQ(scan(tree, key.data(), key.data()), (vector<int>{3108, 3109, 3110, 3111}));
+
+    // Full leaves split cleanly after a bulk load
+    ASSERT_TRUE(tree.insert(key.data(), 99999));
+    EXPECT_EQ(scan(tree, key.data(), key.data()), (vector<int>{3108, 3109, 3110, 3111, 99999}));
+}
+
+TEST_F(BTreeTest, StringKeysOrderLikeStrings) {
+    const int keySize = 8;
+    BTree tree(treeTestFile, ColumnType::String, keySize);
+    ASSERT_TRUE(tree.create());
+
+    const vector<string> names = {"bob", "alice", "al", "carol", "alice", "b"};
+    for (size_t id = 0; id < names.size(); id++) {
+        string key = names[id];
+        key.resize(keySize, '\0');
+        ASSERT_TRUE(tree.insert(key.data(), static_cast<int>(id)));
+    }
+
+    EXPECT_EQ(scan(tree, nullptr, nullptr), (vector<int>{2, 1, 4, 5, 0, 3}));
+
+    string low = "alice", high = "b";
+    low.resize(keySize, '\0');
+    high.resize(keySize, '\0');
+    EXPECT_EQ(scan(tree, low.data(), high.data()), (vector<int>{1, 4, 5}));
+}
+
+TEST_F(BTreeTest, TreeSurvivesEvictionAndReopen) {
+    {
+        BTree tree(treeTestFile, ColumnType::Float, sizeof(float));
+        ASSERT_TRUE(tree.create());
+        for (int id = 0; id < 5000; id++) {
+            const float value = id * 0.5f;
+            ASSERT_TRUE(tree.insert(reinterpret_cast<const char *>(&value), id));
+        }
+        ASSERT_TRUE(bufferPool().flushFile(treeTestFile));
+        bufferPool().dropFile(treeTestFile);
+    }
+
+    BTree reopened(treeTestFile, ColumnType::Float, sizeof(float));
+    EXPECT_EQ(reopened.size(), 5000u);
+    const float low = 10.0f, high = 11.0f;
+    EXPECT_EQ(scan(reopened, reinterpret_cast<const char *>(&low), reinterpret_cast<const char *>(&high)),
+              (vector<int>{20, 21, 22}));
+}
+
+TEST_F(BTreeTest, WidestKeysStillSplit) {
+    // Two entries per node: every load and insert splits
+    const int keySize = BTree::maxKeySize();
+    auto wideKey = [&](int value) {
+        string key = to_string(100000 + value);
+        key.resize(keySize, '\0');
+        return key;
+    };
+    vector<pair<string, int>> entries;
+    for (int id = 0; id < 200; id += 2) {
+        entries.emplace_back(wideKey(id), id);
+    }
+
+    BTree tree(treeTestFile, ColumnType::String, keySize);
+    ASSERT_TRUE(tree.bulkLoad(entries));
+    for (int id = 1; id < 200; id += 2) {
+        ASSERT_TRUE(tree.insert(wideKey(id).data(), id));
+    }
+    vector<int> expected(200);
+    iota(expected.begin(), expected.end(), 0);
+    EXPECT_EQ(scan(tree, nullptr, nullptr), expected);
+}
+
+TEST_F(BTreeTest, IndexBuildsMergeSpilledRuns) {
+    const string table = "btree_build_test";
+    filesystem::create_directories(dataPath);
+    createTable(table, "Score:int, Tag:string(6)");
+    vector<vector<string>> rows;
+    mt19937 random(7);
+    for (int i = 0; i < 5000; i++) {
+        rows.push_back({to_string(static_cast<int>(random() % 300) - 100), "t" + to_string(i)});
+    }
+    ASSERT_EQ(writeRecords(table, rows), rows.size());
+    ASSERT_TRUE(deleteRecord(table, 17));
+
+    // Runs of a few hundred entries: the build spills and merges a dozen of them
+    shared_ptr<const TableInfo> info = catalog().getTable(table);
+    ASSERT_NE(info, nullptr);
+    const int column = info->columnIndex("Score");
+    ASSERT_TRUE(buildIndex(*info, column, treeTestFile, 4096));
+    for (int run = 0; run < 20; run++) {
+        EXPECT_FALSE(filesystem::exists(treeTestFile + indexRunFileType + to_string(run)));
+    }
+
+    set<pair<int, int>> reference;
+    for (int id = 0; id < static_cast<int>(rows.size()); id++) {
+        if (id != 17) reference.insert({stoi(rows[id][0]), id});
+    }
+    vector<int> expected;
+    for (const auto &entry: reference) expected.push_back(entry.second);
+    BTree tree(treeTestFile, ColumnType::Int, sizeof(int));
+    EXPECT_EQ(tree.size(), reference.size());
+    EXPECT_EQ(scan(tree, nullptr, nullptr), expected);
+
+    // The same table in a single run builds the same tree
+    ASSERT_TRUE(buildIndex(*info, column, treeTestFile));
+    EXPECT_EQ(scan(tree, nullptr, nullptr), expected);
+
+    wal().checkpoint();
+    for (const string &type: {dataFileType, schemaFileType, idMapFileType, freeListFileType, zoneMapFileType}) {
+        bufferPool().dropFile(dataPath + table + type);
+        remove((dataPath + table + type).c_str());
+    }
+    catalog().invalidate(table);
+}
@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+#include "../include/BitmapIndex.h"
+#include "../include/BufferPool.h"
+#include "../include/FilterKernels.h"
+#include "../include/ResultCursor.h"
+#include "../include/Vacuum.h"
+#include "../include/WAL.h"
+#include <filesystem>
+using namespace std;
+
+const string bitmapTestTable = "bitmap_test";
+
+// Spans three 65536-ID chunks; each region holds enough IDs of a chunk for a
+// bitmap container, open and pending few enough for an array one
+class BitmapIndexTest : public ::testing::TestWithParam<TableLayout> {
+protected:
+    static constexpr int rowCount = 2 * 65536 + 1000;
+
+    static string regionOf(int i) { return vector<string>{"EU", "US", "JP", "BR", "IN"}[i % 5]; }
+    static string statusOf(int i) { return i % 599 == 0 ? "open" : i % 599 == 1 ? "pending" : "closed"; }
+
+    void SetUp() override {
+        filesystem::create_directories(dataPath);
+        createTable(bitmapTestTable, "Region:string(8), Status:string(8), Amount:int, Note:string(12)", GetParam());
+        vector<vector<string>> rows;
+        for (int i = 0; i < rowCount; i++) {
+            rows.push_back({regionOf(i), statusOf(i), to_string(i), "n" + to_string(i)});
+        }
+        ASSERT_EQ(writeRecords(bitmapTestTable, rows), static_cast<size_t>(rowCount));
+        ASSERT_TRUE(createBitmapIndex(bitmapTestTable, "Region"));
+        ASSERT_TRUE(createBitmapIndex(bitmapTestTable, "Status"));
+    }
+    void TearDown() override {
+        wal().checkpoint();
+        dropAllBitmapIndexes(bitmapTestTable);
+        for (const string &type: {dataFileType, schemaFileType, idMapFileType, freeListFileType, segmentFileType,
+                                  zoneMapFileType}) {
+            bufferPool().dropFile(dataPath + bitmapTestTable + type);
+            remove((dataPath + bitmapTestTable + type).c_str());
+        }
+        catalog().invalidate(bitmapTestTable);
+    }
+
+    // Matching amounts (the row's number) and the access path
+    static pair<vector<int>, AccessPath> query(const vector<Condition> &conditions) {
+        ResultCursor cursor(bitmapTestTable, {"Amount"}, conditions);
+        vector<int> amounts;
+        Row row;
+        while (cursor.next(row)) {
+            amounts.push_back(get<int>(row[0]));
+        }
+        sort(amounts.begin(), amounts.end());
+        return {amounts, cursor.accessPath()};
+    }
+
+    // IDs straight from the bitmaps, whatever the planner would make of them
+    static vector<int> bitmapIds(const vector<Condition> &conditions) {
+        shared_ptr<const TableInfo> table = catalog().getTable(bitmapTestTable);
+        vector<CompiledPredicate> predicates;
+        EXPECT_TRUE(compilePredicates(*table, conditions, predicates));
+        vector<const CompiledPredicate *> answered;
+        for (const auto &predicate: predicates) {
+            answered.push_back(&predicate);
+        }
+        vector<int> ids;
+        EXPECT_TRUE(bitmapMatches(*table, answered, ids));
+        return ids;
+    }
+
+    // Row numbers passing `matches`, which are also their IDs and amounts
+    static vector<int> expected(const function<bool(int)> &matches) {
+        vector<int> amounts;
+        for (int i = 0; i < rowCount; i++) {
+            if (matches(i)) amounts.push_back(i);
+        }
+        return amounts;
+    }
+};
+
+TEST(BitmapKernelsTest, AndOrMatchScalar) {
+    vector<uint64_t> a(1027), b(1027);
+    mt19937_64 random(5);
+    for (size_t i = 0; i < a.size(); i++) {
+        a[i] = random() & random();
+        b[i] = random();
+    }
+    b[1026] = 0;
+    for (const SimdLevel level: {SimdLevel::Scalar, SimdLevel::AVX2}) {
+        setSimdLevel(level);
+        vector<uint64_t> both = a, either = a;
+        EXPECT_TRUE(andBitmaps(both.data(), b.data(), both.size()));
+        orBitmaps(either.data(), b.data(), either.size());
+        for (size_t i = 0; i < a.size(); i++) {
+            ASSERT_EQ(both[i], a[i] & b[i]) << simdLevelName(level) << " word " << i;
+            ASSERT_EQ(either[i], a[i] | b[i]) << simdLevelName(level) << " word " << i;
+        }
+
+        // Only the last word has bits: the tail alone must report them
+        vector<uint64_t> tail(a.size()), mask(a.size(), ~uint64_t(0));
+        tail.back() = 1;
+        EXPECT_TRUE(andBitmaps(tail.data(), mask.data(), tail.size()));
+        mask.back() = 0;
+        EXPECT_FALSE(andBitmaps(tail.data(), mask.data(), tail.size()));
+    }
+    setSimdLevel(detectSimdLevel());
+}
+
+TEST_P(BitmapIndexTest, ConjunctionsAreAnsweredFromTheBitmaps) {
+    auto [open, openPath] = query({Condition("Region", "=", "EU"), Condition("Status", "=", "open")});
+    EXPECT_EQ(open, expected([](int i) { return regionOf(i) == "EU" && statusOf(i) == "open"; }));
+    EXPECT_EQ(openPath.type, AccessPathType::BitmapScan);
+    EXPECT_EQ(openPath.ids, open);
+
+    // IN lists OR the values' bitmaps, other predicates filter the fetched records
+    auto [listed, listedPath] = query({Condition("Region", {string("JP"), string("IN"), string("XX")}),
+                                       Condition("Status", {string("open"), string("pending")}),
+                                       Condition("Amount", ">", 70000)});
+    EXPECT_EQ(listed, expected([](int i) {
+        return (regionOf(i) == "JP" || regionOf(i) == "IN") && statusOf(i) != "closed" && i > 70000;
+    }));
+    EXPECT_EQ(listedPath.type, AccessPathType::BitmapScan);
+
+    ResultCursor none(bitmapTestTable, {"Amount"}, {Condition("Region", "=", "EU"), Condition("Status", "=", "x")});
+    EXPECT_EQ(none.accessPath().type, AccessPathType::Empty);
+
+    // More matches than pages: scanning is cheaper than fetching them by ID
+    auto [closed, closedPath] = query({Condition("Status", "=", "closed"), Condition("Amount", "<", 10)});
+    EXPECT_EQ(closed, expected([](int i) { return statusOf(i) == "closed" && i < 10; }));
+    EXPECT_NE(closedPath.type, AccessPathType::BitmapScan);
+    EXPECT_EQ(bitmapIds({Condition("Region", "=", "BR"), Condition("Status", "=", "closed")}),
+              expected([](int i) { return regionOf(i) == "BR" && statusOf(i) == "closed"; }));
+}
+
+TEST_P(BitmapIndexTest, WritesKeepTheBitmapsExact) {
+    // Out of a region's bitmap container and a status's array container
+    ASSERT_TRUE(deleteRecord(bitmapTestTable, 2995));
+    ASSERT_TRUE(deleteRecord(bitmapTestTable, 65536 + 5));
+    const vector<int> liveOpen = expected([](int i) { return statusOf(i) == "open" && i != 2995; });
+    EXPECT_EQ(bitmapIds({Condition("Status", "=", "open")}), liveOpen);
+    EXPECT_EQ(bitmapIds({Condition("Region", "=", "EU"), Condition("Status", "=", "closed")}),
+              expected([](int i) { return regionOf(i) == "EU" && statusOf(i) == "closed" && i != 65536 + 5; }));
+
+    // A new value, in two batches that turn its array container into a bitmap;
+    // the first two records fill the freed slots
+    for (int batch = 0; batch < 2; batch++) {
+        vector<vector<string>> rows;
+        for (int i = 0; i < 2500; i++) {
+            rows.push_back({"SA", "new", to_string(rowCount + batch * 2500 + i), "x"});
+        }
+        ASSERT_EQ(writeRecords(bitmapTestTable, rows), rows.size());
+    }
+    vector<int> addedIds(5000);
+    iota(addedIds.begin(), addedIds.end(), rowCount);
+    EXPECT_EQ(bitmapIds({Condition("Region", "=", "SA"), Condition("Status", "=", "new")}), addedIds);
+    EXPECT_EQ(bitmapIds({Condition("Status", "=", "open")}), liveOpen);
+    EXPECT_EQ(query({Condition("Region", "=", "SA"), Condition("Amount", "<", rowCount + 2)}).first,
+              (vector<int>{rowCount, rowCount + 1}));
+
+    // Deleting a fifth of them takes the container back to an array
+    for (int id = rowCount + 1; id < rowCount + 5000; id += 5) {
+        ASSERT_TRUE(deleteRecord(bitmapTestTable, id));
+    }
+    addedIds.erase(remove_if(addedIds.begin(), addedIds.end(), [](int id) { return (id - rowCount) % 5 == 1; }),
+                   addedIds.end());
+    EXPECT_EQ(bitmapIds({Condition("Status", "=", "new")}), addedIds);
+
+    // VACUUM moves records but not IDs, the bitmaps stay valid
+    ASSERT_TRUE(vacuumTable(bitmapTestTable));
+    EXPECT_EQ(query({Condition("Region", "=", "SA"), Condition("Status", "=", "new")}).first, addedIds);
+    auto [open, path] = query({Condition("Region", "=", "EU"), Condition("Status", "=", "open")});
+    EXPECT_EQ(open, expected([](int i) { return regionOf(i) == "EU" && statusOf(i) == "open" && i != 2995; }));
+    EXPECT_EQ(path.type, AccessPathType::BitmapScan);
+}
+
+TEST_P(BitmapIndexTest, CreateAndDrop) {
+    EXPECT_FALSE(createBitmapIndex(bitmapTestTable, "Region"));
+    EXPECT_FALSE(createBitmapIndex(bitmapTestTable, "Missing"));
+    EXPECT_FALSE(createBitmapIndex(bitmapTestTable, "Note")); // a value per record
+    EXPECT_FALSE(filesystem::exists(bitmapFilePath(bitmapTestTable, "Note")));
+    EXPECT_EQ(readBitmapList(bitmapTestTable), (vector<string>{"Region", "Status"}));
+
+    ASSERT_TRUE(dropBitmapIndex(bitmapTestTable, "Status"));
+    EXPECT_FALSE(filesystem::exists(bitmapFilePath(bitmapTestTable, "Status")));
+    EXPECT_FALSE(dropBitmapIndex(bitmapTestTable, "Status"));
+    auto [open, path] = query({Condition("Region", "=", "US"), Condition("Status", "=", "open")});
+    EXPECT_EQ(open, expected([](int i) { return regionOf(i) == "US" && statusOf(i) == "open"; }));
+    EXPECT_NE(path.type, AccessPathType::BitmapScan); // a fifth of the table
+
+    // Recreating the table drops its indexes
+    createTable(bitmapTestTable, "Region:string(8)", GetParam());
+    EXPECT_TRUE(readBitmapList(bitmapTestTable).empty());
+    EXPECT_FALSE(filesystem::exists(bitmapFilePath(bitmapTestTable, "Region")));
+}
+
+INSTANTIATE_TEST_SUITE_P(Layouts, BitmapIndexTest, ::testing::Values(TableLayout::Row, TableLayout::Columnar));
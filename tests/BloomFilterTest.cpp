@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include "../include/BloomFilter.h"
+#include "../include/BufferPool.h"
+#include "../include/ResultCursor.h"
+#include "../include/Vacuum.h"
+#include "../include/WAL.h"
+#include "../include/ZoneMap.h"
+#include <filesystem>
+using namespace std;
+
+const string bloomTestTable = "bloom_test";
+
+// Names are unique and unordered, so zone bounds can't rule anything out
+class BloomFilterTest : public ::testing::TestWithParam<TableLayout> {
+protected:
+    static constexpr int rowCount = 8 * zoneRecords;
+
+    static string nameOf(int i) { return "u" + to_string(i * 7919 % 100003); }
+
+    void SetUp() override {
+        filesystem::create_directories(dataPath);
+        createTable(bloomTestTable, "Name:string(16), Age:int", GetParam());
+        vector<vector<string>> rows;
+        for (int i = 0; i < rowCount; i++) {
+            rows.push_back({nameOf(i), to_string(i % 90)});
+        }
+        ASSERT_EQ(writeRecords(bloomTestTable, rows), static_cast<size_t>(rowCount));
+        ASSERT_TRUE(createBloomFilter(bloomTestTable, "Name"));
+    }
+    void TearDown() override {
+        wal().checkpoint();
+        dropAllBloomFilters(bloomTestTable);
+        for (const string &type: {dataFileType, schemaFileType, idMapFileType, freeListFileType, segmentFileType,
+                                  zoneMapFileType}) {
+            bufferPool().dropFile(dataPath + bloomTestTable + type);
+            remove((dataPath + bloomTestTable + type).c_str());
+        }
+        catalog().invalidate(bloomTestTable);
+    }
+
+    // Matching ages and the number of zones the scan read
+    static pair<vector<int>, size_t> query(const vector<Condition> &conditions) {
+        ResultCursor cursor(bloomTestTable, {"Age"}, conditions);
+        vector<int> ages;
+        Row row;
+        while (cursor.next(row)) {
+            ages.push_back(get<int>(row[0]));
+        }
+        return {ages, cursor.accessPath().zonesScanned};
+    }
+};
+
+TEST_P(BloomFilterTest, EqualityScansOnlyZonesHoldingTheValue) {
+    auto [ages, zones] = query({Condition("Name", "=", nameOf(5000))});
+    EXPECT_EQ(ages, vector<int>{5000 % 90});
+    EXPECT_EQ(zones, 1u);
+
+    auto [listed, listedZones] = query({Condition("Name", {nameOf(10), nameOf(rowCount - 1), string("nobody")})});
+    EXPECT_EQ(listed, (vector<int>{10, (rowCount - 1) % 90}));
+    EXPECT_EQ(listedZones, 2u);
+
+    // Every stored name passes its zone's filter
+    size_t zonesRead = 0;
+    for (int i = 0; i < rowCount; i += 97) {
+        auto [found, read] = query({Condition("Name", "=", nameOf(i))});
+        EXPECT_EQ(found, vector<int>{i % 90}) << nameOf(i);
+        zonesRead += read;
+    }
+    EXPECT_LT(zonesRead, 1.1 * ((rowCount + 96) / 97));
+
+    ResultCursor missing(bloomTestTable, {"Age"}, {Condition("Name", "=", string("nobody"))});
+    EXPECT_LE(missing.accessPath().zonesScanned, 1u);
+}
+
+TEST_P(BloomFilterTest, WritesAddValuesAndVacuumRebuilds) {
+    EXPECT_FALSE(createBloomFilter(bloomTestTable, "Name"));
+    ASSERT_TRUE(deleteRecord(bloomTestTable, 3));
+    ASSERT_EQ(writeRecords(bloomTestTable, {{"reused", "91"}, {"appended", "92"}}), 2u);
+    EXPECT_EQ(query({Condition("Name", "=", string("reused"))}).first, vector<int>{91});
+    EXPECT_EQ(query({Condition("Name", "=", string("appended"))}).first, vector<int>{92});
+    EXPECT_TRUE(query({Condition("Name", "=", nameOf(3))}).first.empty());
+
+    ASSERT_TRUE(vacuumTable(bloomTestTable));
+    EXPECT_EQ(catalog().getTable(bloomTestTable)->bloomColumns.size(), 1u);
+    auto [reused, zones] = query({Condition("Name", "=", string("reused"))});
+    EXPECT_EQ(reused, vector<int>{91});
+    EXPECT_EQ(zones, 1u);
+    EXPECT_EQ(query({Condition("Name", "=", nameOf(4))}).first, vector<int>{4});
+
+    ASSERT_TRUE(dropBloomFilter(bloomTestTable, "Name"));
+    EXPECT_FALSE(filesystem::exists(bloomFilePath(dataPath + bloomTestTable + dataFileType, "Name")));
+    EXPECT_GT(query({Condition("Name", "=", nameOf(4))}).second, 1u);
+    EXPECT_FALSE(createBloomFilter(bloomTestTable, "Age"));
+}
+
+INSTANTIATE_TEST_SUITE_P(Layouts, BloomFilterTest, ::testing::Values(TableLayout::Row, TableLayout::Columnar));
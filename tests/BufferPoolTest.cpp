@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include "../include/BufferPool.h"
+#include <fstream>
+#include <vector>
+using namespace std;
+
+const string poolTestFile = "./buffer_pool_test.bin";
+
+class BufferPoolTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        remove(poolTestFile.c_str());
+    }
+    void TearDown() override {
+        remove(poolTestFile.c_str());
+    }
+};
+
+TEST_F(BufferPoolTest, MissingFileIsNotCreatedByReads) {
+    BufferPool pool(4);
+    char byte;
+    EXPECT_FALSE(pool.fileExists(poolTestFile));
+    EXPECT_FALSE(pool.readBytes(poolTestFile, 0, &byte, 1));
+    EXPECT_EQ(pool.fetchPage(poolTestFile, 0), nullptr);
+}
+
+TEST_F(BufferPoolTest, WriteThenReadAcrossPageBoundary) {
+    BufferPool pool(4);
+    vector<char> data(PAGE_SIZE + 100);
+    for (size_t i = 0; i < data.size(); i++) data[i] = static_cast<char>(i % 251);
+
+    ASSERT_TRUE(pool.writeBytes(poolTestFile, PAGE_SIZE - 50, data.data(), data.size(), true));
+    EXPECT_EQ(pool.fileSize(poolTestFile), PAGE_SIZE - 50 + data.size());
+
+    vector<char> readBack(data.size());
+    ASSERT_TRUE(pool.readBytes(poolTestFile, PAGE_SIZE - 50, readBack.data(), readBack.size()));
+    EXPECT_EQ(readBack, data);
+
+    // Reading past the logical end fails like a short stream read
+    char byte;
+    EXPECT_FALSE(pool.readBytes(poolTestFile, PAGE_SIZE * 3, &byte, 1));
+}
+
+TEST_F(BufferPoolTest, DirtyPagesReachDiskOnFlush) {
+    BufferPool pool(4);
+    const string text = "SimDB";
+    ASSERT_TRUE(pool.writeBytes(poolTestFile, 10, text.data(), text.size(), true));
+    ASSERT_TRUE(pool.flushFile(poolTestFile));
+
+    ifstream file(poolTestFile, ios::binary | ios::ate);
+    EXPECT_EQ(file.tellg(), 15); // only the logical size is written
+    file.seekg(10);
+    string onDisk(5, '\0');
+    file.read(onDisk.data(), 5);
+    EXPECT_EQ(onDisk, text);
+}
+
+TEST_F(BufferPoolTest, EvictionWritesBackAndRepeatedReadsHit) {
+    BufferPool pool(2);
+    for (int page = 0; page < 8; page++) {
+        int value = page * 7;
+        ASSERT_TRUE(pool.writeBytes(poolTestFile, page * PAGE_SIZE, reinterpret_cast<char *>(&value), sizeof(int), true));
+    }
+
+    // Every page but the resident ones was evicted, so values must come back from disk
+    for (int page = 0; page < 8; page++) {
+        int value = -1;
+        ASSERT_TRUE(pool.readBytes(poolTestFile, page * PAGE_SIZE, reinterpret_cast<char *>(&value), sizeof(int)));
+        EXPECT_EQ(value, page * 7);
+    }
+
+    const size_t hitsBefore = pool.hitCount();
+    int value;
+    pool.readBytes(poolTestFile, 7 * PAGE_SIZE, reinterpret_cast<char *>(&value), sizeof(int));
+    EXPECT_EQ(pool.hitCount(), hitsBefore + 1);
+}
+
+TEST_F(BufferPoolTest, PinnedPagesAreNeverEvicted) {
+    BufferPool pool(2);
+    int value = 1;
+    ASSERT_TRUE(pool.writeBytes(poolTestFile, 0, reinterpret_cast<char *>(&value), sizeof(int), true));
+
+    char *first = pool.fetchPage(poolTestFile, 0);
+    char *second = pool.fetchPage(poolTestFile, 1);
+    ASSERT_NE(first, nullptr);
+    ASSERT_NE(second, nullptr);
+    EXPECT_EQ(pool.fetchPage(poolTestFile, 2), nullptr); // both frames pinned
+
+    pool.unpinPage(poolTestFile, 1, false);
+    EXPECT_NE(pool.fetchPage(poolTestFile, 2), nullptr);
+    EXPECT_EQ(*reinterpret_cast<int *>(first), 1);
+    pool.unpinPage(poolTestFile, 0, false);
+    pool.unpinPage(poolTestFile, 2, false);
+}
+
+TEST_F(BufferPoolTest, DroppedFilesFreeTheirSlots) {
+    BufferPool pool(4);
+    const string otherFile = poolTestFile + ".other";
+    for (int round = 0; round < 100; round++) {
+        const string &filePath = round % 2 ? otherFile : poolTestFile;
+        int value = -1;
+        // The page dropped last round was never written back, and mustn't be found under the reused slot
+        EXPECT_FALSE(pool.readBytes(filePath, 0, reinterpret_cast<char *>(&value), sizeof(int)));
+        ASSERT_TRUE(pool.writeBytes(filePath, 0, reinterpret_cast<char *>(&round), sizeof(int), true));
+        ASSERT_TRUE(pool.readBytes(filePath, 0, reinterpret_cast<char *>(&value), sizeof(int)));
+        EXPECT_EQ(value, round);
+        pool.dropFile(filePath);
+    }
+    EXPECT_EQ(pool.fileSlotCount(), 1u);
+    remove(otherFile.c_str());
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include "../include/Parser.h"
+#include "../include/Catalog.h"
+#include "../include/BufferPool.h"
+#include "../include/SecondaryIndex.h"
+#include "../include/WAL.h"
+#include <filesystem>
+#include <fstream>
+using namespace std;
+
+const string bulkTestTable = "bulk_insert_test";
+const string bulkTestFile = "./bulk_insert_test.csv";
+
+class BulkInsertTest : public ::testing::Test {
+protected:
+    size_t poolPages = 0;
+
+    void SetUp() override {
+        filesystem::create_directories(dataPath);
+        poolPages = bufferPool().capacity();
+        dropTable();
+        createTable(bulkTestTable, "Name:string(12), N:int");
+    }
+    void TearDown() override {
+        dropTable();
+        bufferPool().resize(poolPages);
+        remove(bulkTestFile.c_str());
+    }
+
+    static void dropTable() {
+        wal().checkpoint();
+        dropAllIndexes(bulkTestTable);
+        for (const string &type: {dataFileType, schemaFileType, idMapFileType, freeListFileType, zoneMapFileType}) {
+            bufferPool().dropFile(dataPath + bulkTestTable + type);
+            remove((dataPath + bulkTestTable + type).c_str());
+        }
+        catalog().invalidate(bulkTestTable);
+    }
+
+    // (ID, Name, N) of the rows matching `conditions`, in ID order
+    static vector<tuple<int, string, int>> rows(const vector<Condition> &conditions = {}) {
+        vector<tuple<int, string, int>> rows;
+        for (const auto &row: getRecordsWithCondition(bulkTestTable, {ID_COLUMN, "Name", "N"}, conditions)) {
+            rows.emplace_back(get<int>(row[0]), get<string>(row[1]), get<int>(row[2]));
+        }
+        sort(rows.begin(), rows.end());
+        return rows;
+    }
+};
+
+TEST_F(BulkInsertTest, MultiRowInsertTakesEveryTuple) {
+    executeQuery("INSERT INTO " + bulkTestTable + " VALUES (a,1), (\"b,c\",2),(\"d)e\", 3)");
+    EXPECT_EQ(rows(), (vector<tuple<int, string, int>>{{0, "a", 1}, {1, "b,c", 2}, {2, "d)e", 3}}));
+
+    executeQuery("INSERT INTO " + bulkTestTable + " VALUES (f,4)");
+    EXPECT_EQ(rows({Condition("N", "=", 4)}), (vector<tuple<int, string, int>>{{3, "f", 4}}));
+}
+
+TEST_F(BulkInsertTest, BadRowRejectsTheWholeStatement) {
+    executeQuery("INSERT INTO " + bulkTestTable + " VALUES (a,1), (b,two), (c,3)");
+    executeQuery("INSERT INTO " + bulkTestTable + " VALUES (a,1), (b)");
+    executeQuery("INSERT INTO " + bulkTestTable + " VALUES (a,1), (name_too_long,2)");
+    executeQuery("INSERT INTO " + bulkTestTable + " VALUES (a,1) (b,2)");
+    executeQuery("INSERT INTO " + bulkTestTable + " VALUES (a,1), (b,2");
+    EXPECT_TRUE(rows().empty());
+    EXPECT_EQ(catalog().getTable(bulkTestTable)->header.nextRecordId, 0u);
+
+    // Nothing was handed out, so IDs start at 0
+    executeQuery("INSERT INTO " + bulkTestTable + " VALUES (a,1), (b,2)");
+    EXPECT_EQ(rows(), (vector<tuple<int, string, int>>{{0, "a", 1}, {1, "b", 2}}));
+}
+
+TEST_F(BulkInsertTest, CopyAppendsTheFile) {
+    ofstream(bulkTestFile) << "Name,N\nx,10\n\"y,z\",20\n";
+
+    // Without HEADER the header line is a row, and not a valid one
+    executeQuery("COPY " + bulkTestTable + " FROM '" + bulkTestFile + "'");
+    EXPECT_TRUE(rows().empty());
+
+    executeQuery("COPY " + bulkTestTable + " FROM '" + bulkTestFile + "' HEADER");
+    executeQuery("COPY " + bulkTestTable + " FROM \"" + bulkTestFile + "\" header");
+    EXPECT_EQ(rows(), (vector<tuple<int, string, int>>{{0, "x", 10}, {1, "y,z", 20}, {2, "x", 10}, {3, "y,z", 20}}));
+
+    executeQuery("COPY " + bulkTestTable + " FROM './missing.csv'");
+    executeQuery("COPY " + bulkTestTable + " FROM '" + bulkTestFile + "' HEADER REPLACE");
+    EXPECT_EQ(rows().size(), 4u);
+}
+
+TEST_F(BulkInsertTest, BatchesCrossTheBatchSizeAndFillFreeSlots) {
+    // 64 pages and one index make batches of 8 rows
+    bufferPool().resize(64);
+    ASSERT_TRUE(createIndex(bulkTestTable, "bulk_n", "N"));
+    vector<vector<string>> first;
+    for (int i = 0; i < 10; i++) first.push_back({"r" + to_string(i), to_string(i)});
+    ASSERT_EQ(writeRecords(bulkTestTable, first), 10u);
+    for (int id: {2, 5, 7}) ASSERT_TRUE(deleteRecord(bulkTestTable, id));
+
+    // The first batch fills the three free slots and appends five, the other two append
+    vector<vector<string>> second;
+    for (int i = 10; i < 30; i++) second.push_back({"r" + to_string(i), to_string(i)});
+    ASSERT_EQ(writeRecords(bulkTestTable, second), 20u);
+
+    const DBHeader header = catalog().getTable(bulkTestTable)->header;
+    EXPECT_EQ(header.numRecords, 27u);
+    EXPECT_EQ(header.nextRecordId, 30u);
+    EXPECT_EQ(header.freeSlots, 0u);
+    EXPECT_EQ(header.slotCount, 27u);
+
+    vector<tuple<int, string, int>> expected;
+    for (int i = 0; i < 30; i++) {
+        if (i != 2 && i != 5 && i != 7) expected.emplace_back(i, "r" + to_string(i), i);
+    }
+    EXPECT_EQ(rows(), expected);
+
+    // The index has every batch's rows, the ones in reused slots too
+    for (int n: {10, 12, 17, 18, 29}) {
+        EXPECT_EQ(rows({Condition("N", "=", n)}), (vector<tuple<int, string, int>>{{n, "r" + to_string(n), n}}));
+    }
+    EXPECT_TRUE(rows({Condition("N", "=", 5)}).empty());
+}
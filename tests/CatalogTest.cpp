@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include "../include/Catalog.h"
+#include "../include/BufferPool.h"
+#include "../include/WAL.h"
+#include <filesystem>
+#include <fstream>
+using namespace std;
+
+const string upgradeTestTable = "upgrade_test";
+
+class CatalogTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        filesystem::create_directories(dataPath);
+        TearDown();
+    }
+    void TearDown() override {
+        wal().checkpoint();
+        for (const string &type: {dataFileType, schemaFileType, indexFileType, idMapFileType, freeListFileType,
+                                  zoneMapFileType}) {
+            bufferPool().dropFile(dataPath + upgradeTestTable + type);
+            remove((dataPath + upgradeTestTable + type).c_str());
+        }
+        catalog().invalidate(upgradeTestTable);
+    }
+
+    // A table as the first version wrote it: "SDB1" header with the record
+    // count and free offset, packed (ID, Name) records and an ID -> offset .idx
+    static void writeDB01Table(const vector<pair<int, string>> &records) {
+        ofstream schema(dataPath + upgradeTestTable + schemaFileType);
+        schema << "ID:int\nName:string(8)\n";
+
+        char header[headerSize] = {'S', 'D', 'B', '1'};
+        const int32_t count = static_cast<int32_t>(records.size());
+        const uint32_t freeOffset = headerSize + count * 12;
+        memcpy(header + 4, &count, sizeof(count));
+        memcpy(header + 8, &freeOffset, sizeof(freeOffset));
+        ofstream data(dataPath + upgradeTestTable + dataFileType, ios::binary);
+        data.write(header, headerSize);
+        ofstream index(dataPath + upgradeTestTable + indexFileType, ios::binary);
+        for (int32_t i = 0; i < count; i++) {
+            char record[12] = {};
+            memcpy(record, &records[i].first, sizeof(int));
+            memcpy(record + 4, records[i].second.data(), records[i].second.size());
+            data.write(record, sizeof(record));
+            const int32_t offset = headerSize + i * 12;
+            index.write(reinterpret_cast<const char *>(&offset), sizeof(offset));
+        }
+    }
+
+    static vector<pair<int, string>> rowsWhere(const vector<Condition> &conditions) {
+        vector<pair<int, string>> rows;
+        for (const auto &row: getRecordsWithCondition(upgradeTestTable, {ID_COLUMN, "Name"}, conditions)) {
+            rows.emplace_back(get<int>(row[0]), get<string>(row[1]));
+        }
+        return rows;
+    }
+};
+
+TEST_F(CatalogTest, DB01TablesKeepTheirStoredIds) {
+    // Inserts a, b, c, then deleting ID 0 moved c into its slot; the next
+    // insert was handed ID 2 again
+    writeDB01Table({{2, "c"}, {1, "b"}, {2, "d"}});
+
+    shared_ptr<const TableInfo> table = catalog().getTable(upgradeTestTable);
+    ASSERT_NE(table, nullptr);
+    EXPECT_EQ(memcmp(table->header.magic, currentHeaderMagic, 4), 0);
+    EXPECT_EQ(table->header.numRecords, 3u);
+    EXPECT_EQ(table->header.nextRecordId, 4u);
+    EXPECT_FALSE(filesystem::exists(dataPath + upgradeTestTable + indexFileType));
+
+    EXPECT_EQ(rowsWhere({Condition(ID_COLUMN, "=", 2)}), (vector<pair<int, string>>{{2, "c"}}));
+    EXPECT_EQ(rowsWhere({Condition(ID_COLUMN, "=", 1)}), (vector<pair<int, string>>{{1, "b"}}));
+    EXPECT_EQ(rowsWhere({Condition(ID_COLUMN, "=", 3)}), (vector<pair<int, string>>{{3, "d"}}));
+    EXPECT_TRUE(rowsWhere({Condition(ID_COLUMN, "=", 0)}).empty());
+
+    // New records continue after the highest ID, and the IDs survive a reload
+    ASSERT_EQ(writeRecords(upgradeTestTable, {{"e"}}), 1u);
+    ASSERT_TRUE(deleteRecord(upgradeTestTable, 1));
+    wal().checkpoint();
+    catalog().invalidate(upgradeTestTable);
+    EXPECT_EQ(rowsWhere({}), (vector<pair<int, string>>{{2, "c"}, {3, "d"}, {4, "e"}}));
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include "../include/Columnar.h"
+#include "../include/SecondaryIndex.h"
+#include "../include/Vacuum.h"
+#include "../include/WAL.h"
+#include <filesystem>
+using namespace std;
+
+const string columnarTestTable = "columnar_test";
+
+// More rows than one segment holds, so reads and writes cross a segment boundary
+class ColumnarTest : public ::testing::Test {
+protected:
+    static constexpr int rowCount = defaultSegmentRecords + 500;
+
+    void SetUp() override {
+        filesystem::create_directories(dataPath);
+        createTable(columnarTestTable, "Name:string(16), Age:int, Score:float, Region:string(8)",
+                    TableLayout::Columnar);
+        vector<vector<string>> rows;
+        for (int i = 0; i < rowCount; i++) {
+            rows.push_back({"n" + to_string(i), to_string(i % 50), to_string(i) + ".5", "r" + to_string(i / 1000)});
+        }
+        ASSERT_EQ(writeRecords(columnarTestTable, rows), static_cast<size_t>(rowCount));
+    }
+    void TearDown() override {
+        wal().checkpoint();
+        dropAllIndexes(columnarTestTable);
+        for (const string &type: {dataFileType, schemaFileType, idMapFileType, freeListFileType, segmentFileType}) {
+            bufferPool().dropFile(dataPath + columnarTestTable + type);
+            remove((dataPath + columnarTestTable + type).c_str());
+        }
+        catalog().invalidate(columnarTestTable);
+    }
+
+    static vector<string> namesWhere(const vector<Condition> &conditions) {
+        vector<string> names;
+        for (const auto &row: getRecordsWithCondition(columnarTestTable, {"Name"}, conditions)) {
+            names.push_back(get<string>(row[0]));
+        }
+        return names;
+    }
+};
+
+TEST_F(ColumnarTest, ColumnsAreStoredContiguouslyPerSegment) {
+    shared_ptr<const TableInfo> table = catalog().getTable(columnarTestTable);
+    ASSERT_EQ(table->header.layout, TableLayout::Columnar);
+    const int age = table->columnIndex("Age");
+
+    // Neighbouring slots of one column sit next to each other...
+    EXPECT_EQ(columnValueOffset(*table, 1, age), columnValueOffset(*table, 0, age) + sizeof(int));
+
+    // ...and the next segment starts after a whole segment of records
+    EXPECT_EQ(columnValueOffset(*table, defaultSegmentRecords, 0),
+              headerSize + uint64_t(defaultSegmentRecords) * table->recordSize);
+
+    int value;
+    ASSERT_TRUE(bufferPool().readBytes(dataPath + columnarTestTable + dataFileType,
+                                       columnValueOffset(*table, defaultSegmentRecords + 7, age),
+                                       reinterpret_cast<char *>(&value), sizeof(int)));
+    EXPECT_EQ(value, (defaultSegmentRecords + 7) % 50);
+}
+
+TEST_F(ColumnarTest, QueriesMatchAcrossSegments) {
+    EXPECT_EQ(namesWhere({Condition(ID_COLUMN, ">=", int(defaultSegmentRecords) - 1),
+                          Condition(ID_COLUMN, "<=", int(defaultSegmentRecords))}),
+              (vector<string>{"n" + to_string(defaultSegmentRecords - 1),
+                              "n" + to_string(defaultSegmentRecords)}));
+    EXPECT_EQ(namesWhere({Condition("Score", ">", float(rowCount - 1))}),
+              vector<string>{"n" + to_string(rowCount - 1)});
+    EXPECT_EQ(namesWhere({Condition("Age", "=", 7)}).size(), static_cast<size_t>((rowCount - 7 + 49) / 50));
+}
+
+TEST_F(ColumnarTest, FullSegmentsEncodeTheirStringColumns) {
+    shared_ptr<const TableInfo> table = catalog().getTable(columnarTestTable);
+    const string filePath = dataPath + columnarTestTable + dataFileType;
+    const int name = table->columnIndex("Name");
+    const int region = table->columnIndex("Region");
+
+    shared_ptr<const SegmentDictionary> dictionary;
+    ASSERT_TRUE(segmentDictionary(*table, filePath, 0, name, dictionary));
+    ASSERT_NE(dictionary, nullptr);
+    EXPECT_STREQ(dictionary->value(dictionary->codes[7]), "n7");
+    EXPECT_EQ(dictionary->codeOf("n7"), dictionary->codes[7]);
+    EXPECT_EQ(dictionary->codeOf("n" + to_string(rowCount - 1)), -1);
+
+    ASSERT_TRUE(segmentDictionary(*table, filePath, 0, region, dictionary));
+    ASSERT_NE(dictionary, nullptr);
+    EXPECT_EQ(dictionary->values.size(), 5u * table->columns[region].size); // r0 .. r4
+
+    // The last segment isn't full yet and stays plain
+    ASSERT_TRUE(segmentDictionary(*table, filePath, 1, name, dictionary));
+    EXPECT_EQ(dictionary, nullptr);
+
+    EXPECT_EQ(namesWhere({Condition("Region", "=", string("r2"))}).size(), 1000u);
+    EXPECT_EQ(namesWhere({Condition("Region", "!=", string("r0")), Condition("Age", "=", 0)}).size(),
+              static_cast<size_t>((rowCount - 1000 + 49) / 50));
+    EXPECT_TRUE(namesWhere({Condition("Region", "=", string("r9"))}).empty());
+
+    // A reused slot in an encoded segment takes a value the segment didn't hold
+    ASSERT_TRUE(deleteRecord(columnarTestTable, 10));
+    ASSERT_EQ(writeRecords(columnarTestTable, {{"fresh", "1", "1.5", "new"}}), 1u);
+    EXPECT_EQ(namesWhere({Condition("Region", "=", string("new"))}), vector<string>{"fresh"});
+    EXPECT_EQ(namesWhere({Condition("Name", "=", string("n11"))}), vector<string>{"n11"});
+    EXPECT_EQ(namesWhere({Condition("Region", "=", string("r0"))}).size(), 999u);
+}
+
+TEST_F(ColumnarTest, DeletesIndexesAndVacuum) {
+    ASSERT_TRUE(createIndex(columnarTestTable, "score_idx", "Score"));
+    for (int id = 0; id < rowCount; id += 3) {
+        ASSERT_TRUE(deleteRecord(columnarTestTable, id));
+    }
+    EXPECT_TRUE(namesWhere({Condition("Score", "=", 3.5f)}).empty());
+    EXPECT_EQ(namesWhere({Condition("Score", "=", 4.5f)}), vector<string>{"n4"});
+
+    ASSERT_TRUE(vacuumTable(columnarTestTable));
+    shared_ptr<const TableInfo> table = catalog().getTable(columnarTestTable);
+    EXPECT_EQ(table->header.layout, TableLayout::Columnar);
+    EXPECT_EQ(table->header.numRecords, static_cast<uint64_t>(rowCount - (rowCount + 2) / 3));
+    EXPECT_EQ(namesWhere({Condition(ID_COLUMN, "=", rowCount - 1)}), vector<string>{"n" + to_string(rowCount - 1)});
+    EXPECT_EQ(namesWhere({Condition("Score", "=", 4.5f)}), vector<string>{"n4"});
+    size_t sevens = 0;
+    for (int id = 0; id < rowCount; id++) {
+        sevens += id % 50 == 7 && id % 3 != 0;
+    }
+    EXPECT_EQ(namesWhere({Condition("Age", "=", 7)}).size(), sevens);
+}
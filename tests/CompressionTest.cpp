@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include "../include/Compression.h"
+#include "../include/Columnar.h"
+#include "../include/SecondaryIndex.h"
+#include "../include/Vacuum.h"
+#include "../include/WAL.h"
+#include <filesystem>
+using namespace std;
+
+const string compressionTestTable = "compression_test";
+
+TEST(LzCodecTest, RoundTrips) {
+    string repetitive;
+    for (int i = 0; i < 5000; i++) {
+        repetitive += "row " + to_string(i % 37) + ", region EU;";
+    }
+    mt19937 random(7);
+    string noise(70000, '\0');
+    for (auto &byte: noise) {
+        byte = static_cast<char>(random());
+    }
+
+    for (const string &input: {repetitive, noise, string("abc"), string(300, 'x')}) {
+        string compressed;
+        lzCompress(input.data(), input.size(), compressed);
+        string output(input.size(), '\0');
+        ASSERT_TRUE(lzDecompress(compressed.data(), compressed.size(), output.data(), output.size()));
+        EXPECT_EQ(output, input);
+    }
+
+    string compressed;
+    lzCompress(repetitive.data(), repetitive.size(), compressed);
+    EXPECT_LT(compressed.size(), repetitive.size() / 10);
+
+    // Truncated input or the wrong length is rejected, not overrun
+    string output(repetitive.size(), '\0');
+    EXPECT_FALSE(lzDecompress(compressed.data(), compressed.size() / 2, output.data(), output.size()));
+    EXPECT_FALSE(lzDecompress(compressed.data(), compressed.size(), output.data(), output.size() - 1));
+}
+
+// Compressed once per test, in either layout
+class CompressionTest : public ::testing::TestWithParam<TableLayout> {
+protected:
+    static constexpr int rowCount = 10000;
+
+    void SetUp() override {
+        filesystem::create_directories(dataPath);
+        createTable(compressionTestTable, "Name:string(32), Age:int, Score:float", GetParam());
+        vector<vector<string>> rows;
+        for (int i = 0; i < rowCount; i++) {
+            rows.push_back({"n" + to_string(i % 100), to_string(i % 50), to_string(i) + ".5"});
+        }
+        ASSERT_EQ(writeRecords(compressionTestTable, rows), static_cast<size_t>(rowCount));
+        ASSERT_TRUE(createIndex(compressionTestTable, "age_idx", "Age"));
+        ASSERT_TRUE(deleteRecord(compressionTestTable, 3));
+    }
+    void TearDown() override {
+        wal().checkpoint();
+        dropAllIndexes(compressionTestTable);
+        for (const string &type: {dataFileType, schemaFileType, idMapFileType, freeListFileType, segmentFileType,
+                                  blockIndexFileType}) {
+            bufferPool().dropFile(dataPath + compressionTestTable + type);
+            remove((dataPath + compressionTestTable + type).c_str());
+        }
+        catalog().invalidate(compressionTestTable);
+    }
+
+    static vector<float> scoresWhere(const vector<Condition> &conditions) {
+        vector<float> scores;
+        for (const auto &row: getRecordsWithCondition(compressionTestTable, {"Score"}, conditions)) {
+            scores.push_back(get<float>(row[0]));
+        }
+        return scores;
+    }
+};
+
+TEST_P(CompressionTest, QueriesMatchAfterCompressing) {
+    const vector<vector<Condition>> queries = {
+        {},
+        {Condition("Age", "=", 3)},
+        {Condition("Name", "=", string("n42")), Condition("Score", ">", 5000.0f)},
+        {Condition(ID_COLUMN, {0, 3, 4, 9999, 20000})},
+        {Condition(ID_COLUMN, ">=", 8190), Condition(ID_COLUMN, "<", 8200)},
+    };
+    vector<vector<float>> expected;
+    for (const auto &conditions: queries) {
+        expected.push_back(scoresWhere(conditions));
+    }
+
+    const string filePath = dataPath + compressionTestTable + dataFileType;
+    const auto sizeBefore = filesystem::file_size(filePath);
+    ASSERT_TRUE(vacuumTable(compressionTestTable, true));
+    EXPECT_TRUE(isCompressed(*catalog().getTable(compressionTestTable)));
+    EXPECT_LT(filesystem::file_size(filePath), sizeBefore / 2);
+
+    for (size_t i = 0; i < queries.size(); i++) {
+        EXPECT_EQ(scoresWhere(queries[i]), expected[i]) << "query " << i;
+    }
+}
+
+TEST_P(CompressionTest, CompressedTablesAreReadOnlyUntilVacuumed) {
+    ASSERT_TRUE(vacuumTable(compressionTestTable, true));
+    EXPECT_THROW(writeRecords(compressionTestTable, {{"late", "1", "1.5"}}), runtime_error);
+    EXPECT_FALSE(deleteRecord(compressionTestTable, 4));
+    EXPECT_EQ(scoresWhere({Condition(ID_COLUMN, "=", 4)}), vector<float>{4.5f});
+
+    ASSERT_TRUE(vacuumTable(compressionTestTable));
+    EXPECT_FALSE(isCompressed(*catalog().getTable(compressionTestTable)));
+    EXPECT_FALSE(filesystem::exists(dataPath + compressionTestTable + blockIndexFileType));
+    ASSERT_EQ(writeRecords(compressionTestTable, {{"late", "1", "1.5"}}), 1u);
+    ASSERT_TRUE(deleteRecord(compressionTestTable, 4));
+    EXPECT_EQ(scoresWhere({Condition("Name", "=", string("late"))}), vector<float>{1.5f});
+    EXPECT_EQ(scoresWhere({Condition("Age", "=", 4)}).size(), static_cast<size_t>(rowCount / 50 - 1));
+}
+
+INSTANTIATE_TEST_SUITE_P(Layouts, CompressionTest, ::testing::Values(TableLayout::Row, TableLayout::Columnar));
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include "../include/CsvImport.h"
+#include "../include/Catalog.h"
+#include "../include/BufferPool.h"
+#include "../include/FilterKernels.h"
+#include "../include/WAL.h"
+#include <filesystem>
+#include <fstream>
+using namespace std;
+
+const string csvTestTable = "csv_test";
+const string csvTestFile = "./csv_import_test.csv";
+
+class CsvImportTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        filesystem::create_directories(dataPath);
+        setenv(importThreadsEnv.c_str(), "3", 1); // several workers even on one core
+        resetTable();
+    }
+    void TearDown() override {
+        dropTable();
+        remove(csvTestFile.c_str());
+        unsetenv(importThreadsEnv.c_str());
+    }
+
+    static void dropTable() {
+        wal().checkpoint();
+        for (const string &type: {dataFileType, schemaFileType, idMapFileType, freeListFileType, zoneMapFileType}) {
+            bufferPool().dropFile(dataPath + csvTestTable + type);
+            remove((dataPath + csvTestTable + type).c_str());
+        }
+        catalog().invalidate(csvTestTable);
+    }
+    static void resetTable() {
+        dropTable();
+        createTable(csvTestTable, "Name:string(40), N:int");
+    }
+
+    // Rows of the table in ID order after importing `contents`
+    static vector<pair<string, int>> import(const string &contents, size_t chunkBytes = csvImportChunkBytes) {
+        ofstream(csvTestFile, ios::binary) << contents;
+        importCsv(csvTestTable, csvTestFile, false, chunkBytes);
+        return rows();
+    }
+    static vector<pair<string, int>> rows() {
+        vector<pair<string, int>> rows;
+        for (const auto &row: getRecordsWithCondition(csvTestTable, {"Name", "N"}, {})) {
+            rows.emplace_back(get<string>(row[0]), get<int>(row[1]));
+        }
+        return rows;
+    }
+};
+
+TEST_F(CsvImportTest, QuotedDelimitersStayInTheirField) {
+    // The quoted comma and newline sit on either side of the first 32 byte block's end
+    const string field = string(30, 'a') + ",b\nc";
+    const string contents = "\"" + field + "\",1\nplain,2\n\"x,\ny\",3\n";
+    const vector<pair<string, int>> expected{{field, 1}, {"plain", 2}, {"x,\ny", 3}};
+    EXPECT_EQ(import(contents), expected);
+
+    // Chunks of a few bytes would end inside the quotes if cut at the first newline
+    for (size_t chunkBytes: {1, 8, 33, 40}) {
+        resetTable();
+        EXPECT_EQ(import(contents, chunkBytes), expected) << chunkBytes;
+    }
+}
+
+TEST_F(CsvImportTest, CrlfLineEndings) {
+    EXPECT_EQ(import("x,1\r\ny,2\r\n\r\n\"z\",3\r\n"), (vector<pair<string, int>>{{"x", 1}, {"y", 2}, {"z", 3}}));
+}
+
+TEST_F(CsvImportTest, LastLineNeedsNoNewline) {
+    EXPECT_EQ(import("x,1\ny,2"), (vector<pair<string, int>>{{"x", 1}, {"y", 2}}));
+    resetTable();
+    EXPECT_EQ(import("x,1\n\"y\n\",2", 4), (vector<pair<string, int>>{{"x", 1}, {"y\n", 2}}));
+}
+
+TEST_F(CsvImportTest, MalformedRowsStopTheImport) {
+    ofstream(csvTestFile, ios::binary) << "x,1\ny\n";
+    EXPECT_THROW(importCsv(csvTestTable, csvTestFile, false), runtime_error);
+    ofstream(csvTestFile, ios::binary) << "x,1\ny,two\n";
+    EXPECT_THROW(importCsv(csvTestTable, csvTestFile, false), runtime_error);
+    ofstream(csvTestFile, ios::binary) << "x,1,extra\n";
+    EXPECT_THROW(importCsv(csvTestTable, csvTestFile, false), runtime_error);
+    ofstream(csvTestFile, ios::binary) << string(41, 'l') << ",1\n";
+    EXPECT_THROW(importCsv(csvTestTable, csvTestFile, false), runtime_error);
+    EXPECT_TRUE(rows().empty());
+
+    // The chunks before the bad one stay imported, nothing of it or after it
+    ofstream(csvTestFile, ios::binary) << "a,1\nb,2\nc,oops\nd,4\n";
+    EXPECT_THROW(importCsv(csvTestTable, csvTestFile, false, 4), runtime_error);
+    EXPECT_EQ(rows(), (vector<pair<string, int>>{{"a", 1}, {"b", 2}}));
+}
+
+TEST_F(CsvImportTest, Avx2AndScalarScansAgree) {
+    if (detectSimdLevel() != SimdLevel::AVX2) {
+        GTEST_SKIP() << "AVX2 is not available";
+    }
+    // Quotes, commas, newlines and CRLF at every offset of a 32 byte block
+    string contents;
+    for (int i = 0; i < 2000; i++) {
+        const string name = string(i % 37, 'n') + (i % 3 == 1 ? "," : i % 3 == 2 ? "\n" : "");
+        contents += (i % 3 == 0 ? name : "\"" + name + "\"") + "," + to_string(i) + (i % 5 == 0 ? "\r\n" : "\n");
+    }
+
+    const SimdLevel level = activeSimdLevel();
+    setSimdLevel(SimdLevel::Scalar);
+    const vector<pair<string, int>> scalar = import(contents, 4096);
+    resetTable();
+    setSimdLevel(SimdLevel::AVX2);
+    const vector<pair<string, int>> avx2 = import(contents, 4096);
+    setSimdLevel(level);
+
+    ASSERT_EQ(scalar.size(), 2000u);
+    EXPECT_EQ(scalar, avx2);
+    EXPECT_EQ(scalar[1], (pair<string, int>{"n,", 1}));
+    EXPECT_EQ(scalar[2], (pair<string, int>{"nn\n", 2}));
+}
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include "../include/IoBackend.h"
+#include "../include/Catalog.h"
+#include "../include/BufferPool.h"
+#include "../include/WAL.h"
+#include <fcntl.h>
+#include <filesystem>
+#include <unistd.h>
+using namespace std;
+
+const string mappingTestFile = "./file_mapping_test.bin";
+const string mmapTestTable = "mmap_test";
+
+// The backend is read once, so pick it before any test asks
+static const bool mmapSelected = setenv(ioBackendEnv.c_str(), "mmap", 1) == 0;
+
+class FileMappingTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        remove(mappingTestFile.c_str());
+    }
+    void TearDown() override {
+        remove(mappingTestFile.c_str());
+    }
+
+    static void append(const string &bytes) {
+        ofstream(mappingTestFile, ios::binary | ios::app) << bytes;
+    }
+};
+
+TEST_F(FileMappingTest, GrowsWithoutMovingEarlierViews) {
+    append("hello");
+    FileMapping mapping(mappingTestFile);
+
+    const char *first = mapping.view(0, 5);
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(string(first, 5), "hello");
+
+    // Past the end of the file there is nothing to map yet
+    EXPECT_EQ(mapping.view(5, 6), nullptr);
+
+    append(" world");
+    const char *second = mapping.view(5, 6);
+    ASSERT_NE(second, nullptr);
+    EXPECT_EQ(second, first + 5);
+    EXPECT_EQ(string(first, 11), "hello world");
+}
+
+TEST_F(FileMappingTest, MissingFileIsNotMapped) {
+    FileMapping mapping(mappingTestFile);
+    EXPECT_EQ(mapping.view(0, 1), nullptr);
+}
+
+// Batched io_uring reads, skipped where the kernel doesn't offer io_uring
+TEST_F(FileMappingTest, RingReadsBatchesAndRejectsShortReads) {
+    string contents;
+    for (int i = 0; i < 10000; i++) contents += to_string(i % 10);
+    append(contents);
+
+    IoRing ring(4);
+    if (!ring.ready()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    const int fd = open(mappingTestFile.c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+
+    // More reads than the ring holds at once
+    vector<string> buffers(10, string(100, '\0'));
+    vector<ReadRequest> requests;
+    for (size_t i = 0; i < buffers.size(); i++) {
+        requests.push_back({i * 997, buffers[i].size(), buffers[i].data()});
+    }
+    EXPECT_TRUE(ring.readAll(fd, requests));
+    for (size_t i = 0; i < buffers.size(); i++) {
+        EXPECT_EQ(buffers[i], contents.substr(i * 997, 100));
+    }
+
+    // Past the end of the file
+    char tail[10];
+    EXPECT_FALSE(ring.readAll(fd, {{contents.size() - 5, sizeof(tail), tail}, {0, 1, tail}}));
+    close(fd);
+}
+
+class MmapReadTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_EQ(ioBackend(), IoBackend::Mmap);
+        filesystem::create_directories(dataPath);
+        createTable(mmapTestTable, "Name:string(8), Age:int");
+    }
+    void TearDown() override {
+        wal().checkpoint();
+        for (const string &type: {dataFileType, schemaFileType, idMapFileType, freeListFileType}) {
+            bufferPool().dropFile(dataPath + mmapTestTable + type);
+            fileMappings().drop(dataPath + mmapTestTable + type);
+            remove((dataPath + mmapTestTable + type).c_str());
+        }
+        catalog().invalidate(mmapTestTable);
+    }
+
+    static vector<int> agesWhere(const vector<Condition> &conditions) {
+        vector<int> ages;
+        for (const auto &row: getRecordsWithCondition(mmapTestTable, {"Age"}, conditions)) {
+            ages.push_back(get<int>(row[0]));
+        }
+        return ages;
+    }
+};
+
+TEST_F(MmapReadTest, ReadersSeeEveryCommit) {
+    vector<vector<string>> rows;
+    for (int i = 0; i < 2000; i++) {
+        rows.push_back({"n" + to_string(i), to_string(i)});
+    }
+    ASSERT_EQ(writeRecords(mmapTestTable, rows), 2000u);
+    EXPECT_EQ(agesWhere({Condition("Age", ">=", 1998)}), (vector<int>{1998, 1999}));
+    EXPECT_EQ(agesWhere({Condition(ID_COLUMN, "=", 1234)}), vector<int>{1234});
+
+    // Later commits are visible through the mappings made above
+    ASSERT_TRUE(deleteRecord(mmapTestTable, 1998));
+    ASSERT_EQ(writeRecords(mmapTestTable, {{"new", "5000"}}), 1u);
+    EXPECT_EQ(agesWhere({Condition("Age", ">=", 1998)}), (vector<int>{5000, 1999}));
+    EXPECT_EQ(agesWhere({Condition(ID_COLUMN, ">=", 1998)}), (vector<int>{1999, 5000}));
+}
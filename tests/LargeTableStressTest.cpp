@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include "../include/Catalog.h"
+#include "../include/SecondaryIndex.h"
+#include "../include/WAL.h"
+#include <filesystem>
+using namespace std;
+
+const string largeTestTable = "large_table_test";
+
+// Starts the table with millions of empty slots in a sparse file, so every
+// record written by the tests lands past the 4 GB mark without writing 4 GB.
+// The empty slots aren't valid records, so the tests only reach rows by ID.
+class LargeTableStressTest : public ::testing::Test {
+protected:
+    static constexpr uint64_t skippedSlots = 5'000'000;
+
+    void SetUp() override {
+        filesystem::create_directories(dataPath);
+        createTable(largeTestTable, "Name:string(996), Age:int");
+        shared_ptr<const TableInfo> table = catalog().getTable(largeTestTable);
+        ASSERT_NE(table, nullptr);
+        recordSize = table->recordSize;
+
+        DBHeader header = table->header;
+        header.slotCount = skippedSlots;
+        header.freeOffset = slotOffset(skippedSlots, recordSize);
+        writeHeader(largeTestTable, header);
+        ASSERT_TRUE(wal().checkpoint());
+        bufferPool().dropFile(dataFilePath());
+        filesystem::resize_file(dataFilePath(), header.freeOffset);
+    }
+    void TearDown() override {
+        wal().checkpoint();
+        dropAllIndexes(largeTestTable);
+        for (const string &type: {dataFileType, schemaFileType, idMapFileType, freeListFileType}) {
+            bufferPool().dropFile(dataPath + largeTestTable + type);
+            remove((dataPath + largeTestTable + type).c_str());
+        }
+        catalog().invalidate(largeTestTable);
+    }
+
+    static string dataFilePath() { return dataPath + largeTestTable + dataFileType; }
+
+    static vector<vector<string>> rows(int first, int count) {
+        vector<vector<string>> result;
+        for (int i = first; i < first + count; i++) {
+            result.push_back({"row" + to_string(i), to_string(i)});
+        }
+        return result;
+    }
+
+    static vector<int> agesWhere(const vector<Condition> &conditions) {
+        vector<int> ages;
+        for (const auto &row: getRecordsWithCondition(largeTestTable, {"Age"}, conditions)) {
+            ages.push_back(get<int>(row[0]));
+        }
+        return ages;
+    }
+
+    int recordSize = 0;
+};
+
+TEST_F(LargeTableStressTest, RecordsPastFourGigabytes) {
+    ASSERT_EQ(writeRecords(largeTestTable, rows(0, 3000)), 3000u);
+
+    shared_ptr<const TableInfo> table = catalog().getTable(largeTestTable);
+    EXPECT_GT(table->header.freeOffset, 4ull << 30);
+    EXPECT_EQ(table->header.numRecords, 3000u);
+
+    // ID lookups go through the map to slots beyond the 32-bit range
+    EXPECT_EQ(agesWhere({Condition(ID_COLUMN, "=", 2999)}), vector<int>{2999});
+    EXPECT_EQ(agesWhere({Condition(ID_COLUMN, ">=", 1000), Condition(ID_COLUMN, "<", 1003)}),
+              (vector<int>{1000, 1001, 1002}));
+
+    // Deleted slots far out in the file are reused by the next insert
+    ASSERT_TRUE(deleteRecord(largeTestTable, 1500));
+    ASSERT_EQ(writeRecords(largeTestTable, rows(5000, 1)), 1u);
+    EXPECT_EQ(catalog().getTable(largeTestTable)->header.slotCount, skippedSlots + 3000);
+    EXPECT_EQ(agesWhere({Condition(ID_COLUMN, "=", 3000)}), vector<int>{5000});
+    EXPECT_TRUE(agesWhere({Condition(ID_COLUMN, "=", 1500)}).empty());
+}
+
+TEST_F(LargeTableStressTest, HeaderSurvivesReload) {
+    ASSERT_EQ(writeRecords(largeTestTable, rows(0, 100)), 100u);
+    const DBHeader before = catalog().getTable(largeTestTable)->header;
+
+    ASSERT_TRUE(wal().checkpoint());
+    bufferPool().dropFile(dataFilePath());
+    catalog().invalidate(largeTestTable);
+
+    const DBHeader after = catalog().getTable(largeTestTable)->header;
+    EXPECT_EQ(memcmp(after.magic, currentHeaderMagic, 4), 0);
+    EXPECT_EQ(after.freeOffset, before.freeOffset);
+    EXPECT_EQ(after.slotCount, skippedSlots + 100);
+    EXPECT_EQ(filesystem::file_size(dataFilePath()), after.freeOffset);
+    EXPECT_EQ(agesWhere({Condition(ID_COLUMN, "=", 99)}), vector<int>{99});
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include "../include/TableScan.h"
+#include "../include/Storage.h"
+#include "../include/BufferPool.h"
+#include <filesystem>
+using namespace std;
+
+const string scanTestTable = "table_scan_test";
+
+class TableScanTest : public ::testing::Test {
+protected:
+    static constexpr int recordSize = 16;
+    static constexpr size_t chunkBytes = 4096;
+
+    const string filePath = dataPath + scanTestTable + dataFileType;
+
+    void SetUp() override {
+        filesystem::create_directories(dataPath);
+        TearDown();
+    }
+    void TearDown() override {
+        bufferPool().dropFile(filePath);
+        remove(filePath.c_str());
+    }
+
+    // Records [first, first + count) each hold their own number
+    void writeNumbers(int first, int count) {
+        vector<char> records(count * recordSize);
+        for (int i = 0; i < count; i++) {
+            const int value = first + i;
+            memcpy(records.data() + i * recordSize, &value, sizeof(int));
+        }
+        ASSERT_TRUE(bufferPool().writeBytes(filePath, headerSize + uint64_t(first) * recordSize, records.data(),
+                                            records.size(), true));
+    }
+
+    vector<int> scan(int count) {
+        TableScanIterator scan(scanTestTable, recordSize, headerSize + uint64_t(count) * recordSize, chunkBytes);
+        vector<int> values;
+        while (const char *record = scan.next()) {
+            int value;
+            memcpy(&value, record, sizeof(int));
+            values.push_back(value);
+        }
+        EXPECT_FALSE(scan.failed());
+        return values;
+    }
+};
+
+// Prefetched chunks come from the file, except for what only the pool has
+TEST_F(TableScanTest, ScansSeePagesNotWrittenBack) {
+    const int written = 4000, total = 5000;
+    writeNumbers(0, written);
+    ASSERT_TRUE(bufferPool().flushFile(filePath));
+
+    // Changed in the pool only, and records past the end of the file on disk
+    const int changed = -1;
+    ASSERT_TRUE(bufferPool().writeBytes(filePath, headerSize + 1234 * recordSize,
+                                        reinterpret_cast<const char *>(&changed), sizeof(int)));
+    writeNumbers(written, total - written);
+    EXPECT_FALSE(bufferPool().dirtyPages(filePath, headerSize, uint64_t(total) * recordSize).empty());
+
+    vector<int> expected(total);
+    iota(expected.begin(), expected.end(), 0);
+    expected[1234] = changed;
+    EXPECT_EQ(scan(total), expected);
+}
+
+TEST_F(TableScanTest, DirtyPagesAreReportedInOrder) {
+    writeNumbers(0, 2000);
+    ASSERT_TRUE(bufferPool().flushFile(filePath));
+    EXPECT_TRUE(bufferPool().dirtyPages(filePath, 0, PAGE_SIZE * 8).empty());
+
+    const int value = 7;
+    for (const uint64_t pageNo: {5, 2}) {
+        ASSERT_TRUE(bufferPool().writeBytes(filePath, pageNo * PAGE_SIZE + 8, reinterpret_cast<const char *>(&value),
+                                            sizeof(int)));
+    }
+    EXPECT_EQ(bufferPool().dirtyPages(filePath, 0, PAGE_SIZE * 8), (vector<uint64_t>{2, 5}));
+    EXPECT_EQ(bufferPool().dirtyPages(filePath, PAGE_SIZE * 2 + 100, 10), vector<uint64_t>{2});
+    EXPECT_TRUE(bufferPool().dirtyPages(filePath, PAGE_SIZE * 3, PAGE_SIZE * 2).empty());
+}
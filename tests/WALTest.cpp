@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+#include "../include/WAL.h"
+#include "../include/BufferPool.h"
+#include "../include/Storage.h"
+#include "../include/BitmapIndex.h"
+#include "../include/SecondaryIndex.h"
+#include <filesystem>
+#include <fstream>
+#include <thread>
+using namespace std;
+
+const string walTestFile = "./wal_test.bin";
+const string walTestTable = "wal_test";
+
+class WALTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        filesystem::create_directories(dataPath);
+        remove(walTestFile.c_str());
+        wal().checkpoint();
+    }
+    void TearDown() override {
+        wal().checkpoint();
+        bufferPool().dropFile(walTestFile);
+        remove(walTestFile.c_str());
+        dropAllIndexes(walTestTable);
+        dropAllBitmapIndexes(walTestTable);
+        for (const string &type: {dataFileType, schemaFileType, idMapFileType, freeListFileType, zoneMapFileType}) {
+            bufferPool().dropFile(dataPath + walTestTable + type);
+            remove((dataPath + walTestTable + type).c_str());
+        }
+        catalog().invalidate(walTestTable);
+    }
+
+    static int readInt(uint64_t offset) {
+        int value = -1;
+        ifstream file(walTestFile, ios::binary);
+        file.seekg(offset);
+        file.read(reinterpret_cast<char *>(&value), sizeof(int));
+        return value;
+    }
+};
+
+TEST_F(WALTest, ConcurrentCommitsShareSyncs) {
+    const int threads = 8, commitsPerThread = 100;
+    const uint64_t syncsBefore = wal().syncCount();
+
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([t] {
+            for (int i = 0; i < commitsPerThread; i++) {
+                WalTransaction transaction;
+                const int value = t * commitsPerThread + i;
+                bufferPool().writeBytes(walTestFile, value * sizeof(int), reinterpret_cast<const char *>(&value),
+                                        sizeof(int), true);
+                ASSERT_TRUE(transaction.commit());
+            }
+        });
+    }
+    for (auto &worker: workers) worker.join();
+
+    // Followers ride along on the leader's fdatasync
+    EXPECT_LT(wal().syncCount() - syncsBefore, static_cast<uint64_t>(threads * commitsPerThread));
+
+    ASSERT_TRUE(wal().checkpoint());
+    for (int value = 0; value < threads * commitsPerThread; value += 97) {
+        EXPECT_EQ(readInt(value * sizeof(int)), value);
+    }
+}
+
+TEST_F(WALTest, RecoveryReplaysCommittedWrites) {
+    {
+        WalTransaction transaction;
+        const int value = 4242;
+        bufferPool().writeBytes(walTestFile, 8, reinterpret_cast<const char *>(&value), sizeof(int), true);
+        ASSERT_TRUE(transaction.commit());
+    }
+
+    // Lose the dirty page as a crash would; only the log has the write
+    bufferPool().dropFile(walTestFile);
+    EXPECT_NE(readInt(8), 4242);
+
+    ASSERT_TRUE(wal().recover());
+    EXPECT_EQ(readInt(8), 4242);
+}
+
+TEST_F(WALTest, UncommittedStatementsAreRolledBack) {
+    const int committed = 7, uncommitted = 8;
+    {
+        WalTransaction transaction;
+        bufferPool().writeBytes(walTestFile, 0, reinterpret_cast<const char *>(&committed), sizeof(int), true);
+        ASSERT_TRUE(transaction.commit());
+    }
+    const uint64_t syncsBefore = wal().syncCount();
+
+    // Overwrites the committed page while it is still only in the pool, and grows the file
+    {
+        WalTransaction transaction;
+        bufferPool().writeBytes(walTestFile, 0, reinterpret_cast<const char *>(&uncommitted), sizeof(int), true);
+        bufferPool().writeBytes(walTestFile, 3 * PAGE_SIZE, reinterpret_cast<const char *>(&uncommitted),
+                                sizeof(int), true);
+    }
+    EXPECT_EQ(wal().syncCount(), syncsBefore);
+    EXPECT_EQ(bufferPool().fileSize(walTestFile), sizeof(int));
+    int value = -1;
+    ASSERT_TRUE(bufferPool().readBytes(walTestFile, 0, reinterpret_cast<char *>(&value), sizeof(int)));
+    EXPECT_EQ(value, committed);
+
+    // The committed write is still due for write back
+    ASSERT_TRUE(wal().checkpoint());
+    EXPECT_EQ(readInt(0), committed);
+}
+
+TEST_F(WALTest, FailedBatchLeavesTableUnchanged) {
+    filesystem::create_directories(dataPath);
+    createTable(walTestTable, "Name:string(8), Kind:string(8)");
+    ASSERT_EQ(writeRecords(walTestTable, {{"a", "k0"}, {"b", "k0"}, {"c", "k1"}}), 3u);
+    ASSERT_TRUE(deleteRecord(walTestTable, 1));
+    ASSERT_TRUE(createIndex(walTestTable, "name_index", "Name"));
+    ASSERT_TRUE(createBitmapIndex(walTestTable, "Kind"));
+    const DBHeader before = catalog().getTable(walTestTable)->header;
+
+    // The bitmap index can't take this many kinds, after the records, map and B-tree were written
+    vector<vector<string>> rows;
+    for (uint32_t i = 0; i <= bitmapMaxValues; i++) {
+        rows.push_back({"n" + to_string(i), "k" + to_string(i)});
+    }
+    EXPECT_THROW(writeRecords(walTestTable, rows), runtime_error);
+
+    const DBHeader after = catalog().getTable(walTestTable)->header;
+    EXPECT_EQ(after.numRecords, before.numRecords);
+    EXPECT_EQ(after.nextRecordId, before.nextRecordId);
+    EXPECT_EQ(after.freeSlots, before.freeSlots);
+    EXPECT_EQ(after.slotCount, before.slotCount);
+    EXPECT_TRUE(getRecordsWithCondition(walTestTable, {ID_COLUMN}, {Condition("Name", "=", "n0")}).empty());
+    EXPECT_EQ(getRecordsWithCondition(walTestTable, {ID_COLUMN}, {}).size(), 2u);
+
+    // The next insert takes the deleted slot and the next ID, as if the batch never ran
+    ASSERT_EQ(writeRecords(walTestTable, {{"d", "k1"}}), 1u);
+    EXPECT_EQ(catalog().getTable(walTestTable)->header.slotCount, before.slotCount);
+    const auto rowsOfD = getRecordsWithCondition(walTestTable, {ID_COLUMN}, {Condition("Name", "=", "d")});
+    ASSERT_EQ(rowsOfD.size(), 1u);
+    EXPECT_EQ(get<int>(rowsOfD[0][0]), 3);
+    EXPECT_EQ(getRecordsWithCondition(walTestTable, {ID_COLUMN}, {Condition("Kind", "=", "k1")}).size(), 2u);
+
+    // Nor does any of it come back from disk
+    ASSERT_TRUE(wal().checkpoint());
+    catalog().invalidate(walTestTable);
+    EXPECT_EQ(getRecordsWithCondition(walTestTable, {ID_COLUMN}, {}).size(), 3u);
+}
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include "../include/BufferPool.h"
+#include "../include/ResultCursor.h"
+#include "../include/Vacuum.h"
+#include "../include/WAL.h"
+#include "../include/ZoneMap.h"
+#include <filesystem>
+using namespace std;
+
+const string zoneMapTestTable = "zone_map_test";
+
+// Timestamps ascend with the slots, like an append-only event table
+class ZoneMapTest : public ::testing::TestWithParam<TableLayout> {
+protected:
+    static constexpr int rowCount = 10 * zoneRecords;
+
+    void SetUp() override {
+        filesystem::create_directories(dataPath);
+        createTable(zoneMapTestTable, "Ts:int, Value:float, Tag:string(8)", GetParam());
+        vector<vector<string>> rows;
+        for (int i = 0; i < rowCount; i++) {
+            rows.push_back({to_string(1000 + i), to_string(i % 7) + ".5", "t" + to_string(i % 3)});
+        }
+        ASSERT_EQ(writeRecords(zoneMapTestTable, rows), static_cast<size_t>(rowCount));
+    }
+    void TearDown() override {
+        wal().checkpoint();
+        for (const string &type: {dataFileType, schemaFileType, idMapFileType, freeListFileType, segmentFileType,
+                                  zoneMapFileType}) {
+            bufferPool().dropFile(dataPath + zoneMapTestTable + type);
+            remove((dataPath + zoneMapTestTable + type).c_str());
+        }
+        catalog().invalidate(zoneMapTestTable);
+    }
+
+    // Matching timestamps and the number of zones the scan read
+    static pair<vector<int>, size_t> query(const vector<Condition> &conditions) {
+        ResultCursor cursor(zoneMapTestTable, {"Ts"}, conditions);
+        vector<int> values;
+        Row row;
+        while (cursor.next(row)) {
+            values.push_back(get<int>(row[0]));
+        }
+        return {values, cursor.accessPath().zonesScanned};
+    }
+};
+
+TEST_P(ZoneMapTest, ScansOnlyZonesThatCanMatch) {
+    auto [tail, tailZones] = query({Condition("Ts", ">", 1000 + rowCount - 3)});
+    EXPECT_EQ(tail, (vector<int>{998 + rowCount, 999 + rowCount}));
+    EXPECT_EQ(tailZones, 1u);
+
+    auto [range, rangeZones] = query({Condition("Ts", ">=", 1000 + int(zoneRecords) - 1),
+                                      Condition("Ts", "<=", 1000 + int(zoneRecords)), Condition("Tag", "!=", "x")});
+    EXPECT_EQ(range.size(), 2u);
+    EXPECT_EQ(rangeZones, 2u);
+
+    auto [listed, listedZones] = query({Condition("Ts", {5, 1003, 1000 + rowCount - 1})});
+    EXPECT_EQ(listed, (vector<int>{1003, 999 + rowCount}));
+    EXPECT_EQ(listedZones, 2u);
+
+    // Columns without an order in the slots rule nothing out
+    EXPECT_EQ(query({Condition("Value", "=", 3.5f)}).first.size(), static_cast<size_t>((rowCount + 3) / 7));
+    EXPECT_EQ(query({Condition("Value", "=", 3.5f)}).second, 10u);
+
+    ResultCursor none(zoneMapTestTable, {"Ts"}, {Condition("Tag", "=", "t9")});
+    EXPECT_EQ(none.accessPath().type, AccessPathType::Empty);
+}
+
+TEST_P(ZoneMapTest, WritesWidenAndVacuumRebuilds) {
+    // The freed slot in the first zone takes a timestamp from far after it
+    ASSERT_TRUE(deleteRecord(zoneMapTestTable, 5));
+    ASSERT_EQ(writeRecords(zoneMapTestTable, {{"99999", "1.5", "late"}}), 1u);
+    auto [late, lateZones] = query({Condition("Ts", ">", 50000)});
+    EXPECT_EQ(late, vector<int>{99999});
+    EXPECT_EQ(lateZones, 1u);
+    EXPECT_EQ(query({Condition("Ts", "=", 1005)}).first, vector<int>{});
+
+    // Deleting the first zone's records keeps its bounds until VACUUM
+    for (int id = 0; id < int(zoneRecords); id++) {
+        if (id != 5) {
+            ASSERT_TRUE(deleteRecord(zoneMapTestTable, id));
+        }
+    }
+    EXPECT_EQ(query({Condition("Ts", "<", 1100)}).second, 1u);
+    ASSERT_TRUE(vacuumTable(zoneMapTestTable));
+    auto [early, earlyZones] = query({Condition("Ts", "<", 1100)});
+    EXPECT_TRUE(early.empty());
+    EXPECT_EQ(earlyZones, 0u);
+    EXPECT_EQ(query({Condition("Ts", ">", 50000)}).first, vector<int>{99999});
+}
+
+TEST_P(ZoneMapTest, FractionalLiteralsCompareExactlyOnIntColumns) {
+    // Past 2^24 a float can't tell neighbouring ints apart; the parser hands
+    // such literals over as text
+    const int big = 1 << 24;
+    ASSERT_EQ(writeRecords(zoneMapTestTable, {{to_string(big), "0", "x"}, {to_string(big + 1), "0", "x"},
+                                              {to_string(big + 2), "0", "x"}}), 3u);
+    EXPECT_EQ(query({Condition("Ts", "=", "16777217.0")}).first, vector<int>{big + 1});
+    EXPECT_EQ(query({Condition("Ts", "=", "16777216.5")}).first, vector<int>{});
+    EXPECT_EQ(query({Condition("Ts", ">", "16777216.5")}).first, (vector<int>{big + 1, big + 2}));
+    EXPECT_EQ(query({Condition("Ts", "<", "16777217.5")}).first.back(), big + 1);
+    auto [top, topZones] = query({Condition("Ts", ">=", "16777217.5")});
+    EXPECT_EQ(top, vector<int>{big + 2});
+    EXPECT_EQ(topZones, 1u);
+    EXPECT_EQ(query({Condition("Ts", "<", 1000.5f)}).first, vector<int>{1000});
+}
+
+INSTANTIATE_TEST_SUITE_P(Layouts, ZoneMapTest, ::testing::Values(TableLayout::Row, TableLayout::Columnar));